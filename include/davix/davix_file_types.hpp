@@ -66,10 +66,12 @@ struct DAVIX_EXPORT DavIOVecOuput{
 /// AdviseAuto : default operation, no optimization
 /// AdviseSequentialRead : optimize next operation for sequential read/write
 /// AdviseRandomRead: optimize next operation for random position read/write
+/// AdviseWillNeed: the given range will be read soon, fetch it in the background
 enum DAVIX_EXPORT advise_t{
     AdviseAuto=0x00,
     AdviseSequential,
     AdviseRandom,
+    AdviseWillNeed,
 
 };
 
@@ -23,6 +23,7 @@
 #define DAVIXCONTEXT_HPP
 
 #include <string>
+#include <map>
 #include <status/davixstatusrequest.hpp>
 #include <hooks/davix_hooks.hpp>
 #include <utils/davix_uri.hpp>
@@ -45,6 +46,67 @@ struct ContextExplorer;
 class HookList;
 class HttpRequest;
 class DavPosix;
+class RequestParams;
+
+/// @brief Session pool statistics of one endpoint
+///
+/// Endpoints are identified as protocol://host:port
+struct DAVIX_EXPORT SessionPoolStats {
+    SessionPoolStats() : live(0), idle(0), created(0), reused(0), multiplexed(0) {}
+
+    /// sessions currently open, either in use or idle
+    dav_size_t live;
+    /// sessions idle in the pool, ready to be reused
+    dav_size_t idle;
+    /// sessions created since the context was created or its cache cleared
+    dav_size_t created;
+    /// number of times an idle session was reused
+    dav_size_t reused;
+    /// requests served over an HTTP/2 connection which was already open,
+    /// shared with other sessions - see \ref RequestParams::setHttp2Support
+    dav_size_t multiplexed;
+};
+
+/// @brief Statistics of the memory blocks buffering response bodies
+///
+/// Blocks are recycled through a free list shared by all requests of the
+/// context. Only the libcurl backend uses it.
+struct DAVIX_EXPORT ResponseBufferStats {
+    ResponseBufferStats() : allocated(0), reused(0), cached_bytes(0) {}
+
+    /// blocks allocated from the heap
+    dav_size_t allocated;
+    /// blocks handed out again from the free list
+    dav_size_t reused;
+    /// bytes currently kept in the free list
+    dav_size_t cached_bytes;
+};
+
+/// @brief Link statistics of one endpoint, and their effect on vectored reads
+///
+/// Endpoints are identified as protocol://host:port
+struct DAVIX_EXPORT LinkStats {
+    LinkStats() : latency(0), bandwidth(0), merge_window(0), vector_reads(0), ranges_requested(0),
+        ranges_issued(0), bytes_requested(0), bytes_wasted(0) {}
+
+    /// average time to receive the response headers, in microseconds, 0 if unknown
+    dav_size_t latency;
+    /// average throughput while reading response bodies, in bytes per second, 0 if unknown
+    dav_size_t bandwidth;
+    /// merge window currently used by vectored reads when none is set explicitly,
+    /// see \ref RequestParams::setMergeWindow
+    dav_size_t merge_window;
+    /// number of vectored reads
+    dav_size_t vector_reads;
+    /// number of ranges asked for by vectored reads
+    dav_size_t ranges_requested;
+    /// number of ranges actually requested, after merging close ranges together
+    dav_size_t ranges_issued;
+    /// number of bytes asked for by vectored reads
+    dav_size_t bytes_requested;
+    /// number of bytes transferred only because they sit in between merged ranges
+    dav_size_t bytes_wasted;
+};
 
 
 
@@ -110,9 +172,105 @@ public:
     /// get session caching status
     bool getSessionCaching() const;
 
-    /// clear both redirect and session cache
+    /// clear the session cache, the block cache and the metadata cache, and have
+    /// the files of the disk cache validated again - the disk cache itself is left alone
     void clearCache();
 
+    /// @brief set the maximum number of redirections remembered by this context
+    ///
+    /// Requests to a URL which redirected before go straight to the cached
+    /// destination. Redirections are evicted in LRU order beyond the limit, and
+    /// forgotten after a while in any case. Default: 4096.
+    void setRedirectionCacheSize(size_t entries);
+
+    /// get the maximum number of cached redirections
+    size_t getRedirectionCacheSize() const;
+
+    /// @brief set the memory limit of the block cache, in bytes - 0 disables it
+    ///
+    /// The block cache keeps the blocks read by positional reads (DavFile::readPartial,
+    /// DavPosix::pread, ...) in memory, shared by every file opened through this context.
+    /// Blocks are evicted in LRU order beyond the limit. Disabled by default.
+    void setBlockCacheLimit(dav_size_t bytes);
+
+    /// get the memory limit of the block cache, in bytes
+    dav_size_t getBlockCacheLimit() const;
+
+    /// @brief set the directory of the disk cache, and the limit of its size in bytes
+    /// @param directory : local directory, created if needed - empty disables the cache
+    /// @param limit : size limit, 0 for none
+    ///
+    /// The disk cache keeps the blocks read by positional and vectored reads in local
+    /// files, which outlive the process and can be shared by several processes.
+    /// Cached files are checked against the remote ones by size and modification
+    /// time; files without a modification time are not cached.
+    /// When both the disk cache and the block cache are enabled, the disk cache
+    /// is looked up first. Disabled by default.
+    void setDiskCache(const std::string & directory, dav_size_t limit);
+
+    /// get the directory of the disk cache, empty if disabled
+    std::string getDiskCacheDirectory() const;
+
+    /// get the size limit of the disk cache, in bytes
+    dav_size_t getDiskCacheLimit() const;
+
+    /// @brief set how long the metadata of files and directories is cached, in seconds - 0 disables it
+    /// @param ttl : lifetime of the cached metadata
+    /// @param negative_ttl : lifetime of "not found" answers, 0 not to cache them
+    ///
+    /// The metadata cache answers DavFile::stat, DavPosix::stat, DavPosix::open and
+    /// the like without asking the server again. It is filled by directory listings
+    /// as well (DavFile::listCollection, DavPosix::readdirpp, ...). Writes, deletions,
+    /// moves and collection creations going through this context drop the metadata
+    /// of the affected resources and of their parent directory; changes made by
+    /// anyone else are only seen once the metadata expired. Disabled by default.
+    void setStatCacheTTL(unsigned int ttl, unsigned int negative_ttl = 0);
+
+    /// get the lifetime of the cached metadata, in seconds
+    unsigned int getStatCacheTTL() const;
+
+    /// get the lifetime of cached "not found" answers, in seconds
+    unsigned int getStatCacheNegativeTTL() const;
+
+    /// @brief set the number of threads of the worker pool of this context
+    /// @param n : number of threads, 0 for the default
+    ///
+    /// The worker pool runs the asynchronous operations (DavFile::readPartialAsync,
+    /// HttpRequest::executeAsync) and the parallel requests of vectored reads,
+    /// read-ahead, prefetching and segmented transfers. At most n asynchronous operations
+    /// are in flight at once, the others wait in a queue for a free thread - a completion
+    /// callback must therefore never block on another asynchronous operation.
+    /// The default is DAVIX_WORKER_THREADS from the environment, 16 otherwise, and the
+    /// maximum is 256. The pool is started by its first use: later calls have no effect.
+    void setWorkerThreads(size_t n);
+
+    /// get the number of threads of the worker pool of this context
+    size_t getWorkerThreads() const;
+
+    /// @brief open sessions towards an endpoint ahead of time
+    /// @param uri : any resource on the endpoint, queried with HEAD
+    /// @param n : number of sessions to open, at most 32
+    /// @param params : request parameters, NULL for the defaults
+    /// @param err : DavixError error report
+    /// @return number of sessions opened, -1 if none could be
+    ///
+    /// The sessions are put into the session pool, so that the next
+    /// n concurrent requests to the endpoint skip the TCP and TLS
+    /// handshakes. The pool keeps at most 32 idle sessions per endpoint,
+    /// larger values of n are clamped to that. The requests run on the
+    /// worker pool of the context. With HTTP/2 enabled in params, the
+    /// requests end up multiplexed over a single connection instead.
+    int prewarmConnections(const Uri & uri, int n, const RequestParams* params, DavixError** err);
+
+    /// @brief get session pool statistics, per endpoint
+    std::map<std::string, SessionPoolStats> getSessionPoolStats() const;
+
+    /// @brief get statistics of the blocks buffering response bodies
+    ResponseBufferStats getResponseBufferStats() const;
+
+    /// @brief get link statistics, per endpoint
+    std::map<std::string, LinkStats> getLinkStats() const;
+
 private:
     // internal context
     ContextInternal* _intern;
@@ -30,6 +30,9 @@
 #include <file/davix_file_info.hpp>
 #include <compat/deprecated.hpp>
 
+#ifdef __DAVIX_CX11_SUPPORT
+#include <future>
+#endif
 
 
 #ifndef __DAVIX_INSIDE__
@@ -151,6 +154,50 @@ public:
                             dav_off_t offset,
                             DavixError** err) throw();
 
+#ifdef __DAVIX_CX11_SUPPORT
+
+    ///
+    ///  @brief Asynchronous partial position independant read.
+    ///
+    ///         Same semantics as @ref readPartial, including replica failover
+    ///         and retries, but returns immediately. The read is executed by the
+    ///         worker pool of the Context, see @ref Context::setWorkerThreads:
+    ///         when all its threads are busy, the read waits in a queue.
+    ///
+    ///         buff must remain valid until the operation completes.
+    ///
+    ///  @param params Davix request Parameters
+    ///  @param buff  buffer
+    ///  @param count  maximum read size
+    ///  @param offset  starting offset for the read operation
+    ///  @return future holding the total number of bytes read,
+    ///          rethrows @ref DavixException on get() if an error occured
+    ///
+    std::future<dav_ssize_t> readPartialAsync(const RequestParams* params,
+                            void* buff,
+                            dav_size_t count,
+                            dav_off_t offset);
+
+    ///
+    ///  @brief Asynchronous partial position independant read.
+    ///
+    ///         Callback flavour of @ref readPartialAsync, the callback is
+    ///         invoked from a davix worker thread once the read completes.
+    ///
+    ///  @param params Davix request Parameters
+    ///  @param buff  buffer
+    ///  @param count  maximum read size
+    ///  @param offset  starting offset for the read operation
+    ///  @param callback completion callback
+    ///
+    void readPartialAsync(const RequestParams* params,
+                            void* buff,
+                            dav_size_t count,
+                            dav_off_t offset,
+                            const AsyncCompletionCallback & callback);
+
+#endif
+
 
     ///
     ///  @brief Get the full file content and write it to file descriptor
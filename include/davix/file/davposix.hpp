@@ -276,6 +276,12 @@ public:
 
       Behavior similar to the POSIX read function
 
+      Sequential reads are served from a read-ahead window, fetched in the
+      background by the worker pool of the Context: it grows while the file
+      is read sequentially, and collapses on seek. Its maximum size, in bytes,
+      can be set with the DAVIX_READAHEAD_WINDOW environment variable, 0
+      disables it.
+
       @param fd davix file descriptor
       @param buffer buffer to fill
       @param count maximum number of bytes to read
@@ -409,10 +415,17 @@ public:
       similar to posix_fadvise, allow I/O optimizations
       non-blocking asynchronous function
 
+      With AdviseRandom or AdviseWillNeed and a non-empty range, the range is
+      fetched in the background, batched with the other pending ranges of the
+      descriptor into vectored reads. pread and preadVec calls falling within
+      a prefetched range are then served from memory. When the block cache of
+      the Context serves the descriptor, the blocks covering the range are
+      fetched into it instead.
+
       @param fd Davix file descriptor
       @param offset offset of the next chunk to read
       @param len size of the next chunk to read
-      @param advise type of pattern for I/O : sequential, random
+      @param advise type of pattern for I/O : sequential, random, will need
     */
     void fadvise(DAVIX_FD* fd, dav_off_t offset, dav_size_t len, advise_t advise);
 
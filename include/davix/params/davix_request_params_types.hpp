@@ -40,6 +40,8 @@
 
 namespace Davix{
 
+class DavixError;
+
 namespace RequestProtocol{
     ///
     /// \brief Http based protocol to use for advanced queries
@@ -186,6 +188,16 @@ typedef  std::string SwiftAccount;
     ///
     typedef std::function<void (const Uri & url, Transfer::Type type, dav_ssize_t bytes_transfered, dav_size_t total_size)> TransferMonitorCB;
 
+    ///
+    /// \brief AsyncCompletionCallback
+    ///
+    ///  Completion callback of asynchronous operations, called from a davix worker thread
+    ///
+    ///  result: return value of the operation, -1 on failure
+    ///  err: error report on failure, NULL otherwise. Owned by davix, only valid during the call
+    ///
+    typedef std::function<void (dav_ssize_t result, DavixError* err)> AsyncCompletionCallback;
+
 #endif
 
 
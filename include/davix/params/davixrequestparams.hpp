@@ -285,6 +285,19 @@ public:
     /// return true if the transparent redirection mode is enabled
     bool getTransparentRedirectionSupport() const;
 
+    /// enable or disable redirection prediction
+    /// Once a server redirected requests for files of a directory to another
+    /// server, keeping their path, GET and HEAD requests for other files of
+    /// that directory are sent straight to the other server, saving a round
+    /// trip. They go back to the original server if the predicted one answers
+    /// with a client error or cannot be reached.
+    /// Needs transparent redirection support.
+    /// DEFAULT : disabled
+    void setRedirectionPrediction(bool prediction);
+
+    /// return true if redirection prediction is enabled
+    bool getRedirectionPrediction() const;
+
     ///
     /// \brief number of re-try in case of operation failure
     /// \param number_retry
@@ -431,6 +444,124 @@ public:
     /// perform in case it receives 202-Accepted on a GET request
     /// @param delay the delay in seconds
     void setAcceptedRetryDelay(int delay);
+
+    /// set the maximum number of response body bytes buffered for a request
+    /// ahead of the application reading them. Once reached, the transfer is
+    /// paused until the application catches up.
+    /// Only honoured by the libcurl backend. DEFAULT: 32 MiB
+    /// @param bytes the limit in bytes
+    void setResponseBufferLimit(dav_size_t bytes);
+
+    /// get the per-request response buffering limit,
+    /// see \ref setResponseBufferLimit for more details
+    dav_size_t getResponseBufferLimit() const;
+
+    /// set the maximum number of response body bytes buffered across all
+    /// requests of the Context. Requests going over it are paused, except for
+    /// those with nothing buffered, so that every reader can make progress.
+    /// Only honoured by the libcurl backend. DEFAULT: 0, no limit
+    /// @param bytes the limit in bytes, 0 to disable
+    void setContextResponseBufferLimit(dav_size_t bytes);
+
+    /// get the Context-wide response buffering limit,
+    /// see \ref setContextResponseBufferLimit for more details
+    dav_size_t getContextResponseBufferLimit() const;
+
+    /// set the size of the memory blocks buffering a response body: the
+    /// first block is initial bytes long, each next one twice as large up
+    /// to max. Larger blocks mean fewer allocations on fast transfers, at
+    /// the cost of memory for small responses. See
+    /// \ref Context::getResponseBufferStats.
+    /// Only honoured by the libcurl backend. DEFAULT: 16 KiB and 1 MiB
+    /// @param initial size of the first block in bytes, at least 1 KiB
+    /// @param max size of the largest block in bytes, at least initial
+    void setResponseBlockSize(dav_size_t initial, dav_size_t max);
+
+    /// get the size of the first block buffering a response body,
+    /// see \ref setResponseBlockSize for more details
+    dav_size_t getResponseBlockSize() const;
+
+    /// get the size of the largest block buffering a response body,
+    /// see \ref setResponseBlockSize for more details
+    dav_size_t getMaxResponseBlockSize() const;
+
+    /// enable or disable HTTP/2. When enabled, HTTP/2 is negotiated through
+    /// ALPN on https connections, and concurrent requests towards the same
+    /// endpoint are multiplexed over a single connection.
+    /// Only honoured by the libcurl backend. DEFAULT: false, HTTP/1.1 only
+    void setHttp2Support(bool enabled);
+
+    /// get HTTP/2 support status, see \ref setHttp2Support for more details
+    bool getHttp2Support() const;
+
+    /// set the merge window of vectored reads: requested ranges closer to
+    /// each other than this are fetched as a single range, gap included.
+    /// When automatic, the window is derived from the latency and throughput
+    /// observed towards the endpoint, see \ref Context::getLinkStats.
+    /// The "mergewindow" URL fragment parameter takes precedence.
+    /// DEFAULT: -1, automatic
+    /// @param bytes the window in bytes, negative for automatic
+    void setMergeWindow(dav_ssize_t bytes);
+
+    /// get the merge window of vectored reads,
+    /// see \ref setMergeWindow for more details
+    dav_ssize_t getMergeWindow() const;
+
+    /// set the number of concurrent range requests used to download a file
+    /// to a file descriptor, see \ref DavFile::getToFd. The file is split
+    /// into segments sized from the observed throughput, written at their
+    /// offsets as they arrive. Used for regular files of known size only,
+    /// falls back to a single request otherwise.
+    /// DEFAULT: 1, single request
+    /// @param streams number of concurrent requests
+    void setTransferStreams(unsigned int streams);
+
+    /// get the number of concurrent range requests of a download,
+    /// see \ref setTransferStreams for more details
+    unsigned int getTransferStreams() const;
+
+    /// set the size of the chunks of multi-part uploads: S3 parts, Azure
+    /// blocks, Swift segments.
+    /// S3 parts are at least 5 MiB, smaller sizes are rounded up.
+    /// DEFAULT: 0, protocol default - 256 MiB for S3 and Swift, 100 MiB for Azure
+    /// @param bytes the chunk size in bytes, 0 for the protocol default
+    void setUploadChunkSize(dav_size_t bytes);
+
+    /// get the chunk size of multi-part uploads,
+    /// see \ref setUploadChunkSize for more details
+    dav_size_t getUploadChunkSize() const;
+
+    /// set the number of chunks of a multi-part upload sent concurrently,
+    /// while the next ones are read from the source.
+    /// DEFAULT: 4
+    /// @param streams number of concurrent chunk uploads
+    void setUploadStreams(unsigned int streams);
+
+    /// get the number of concurrent chunk uploads,
+    /// see \ref setUploadStreams for more details
+    unsigned int getUploadStreams() const;
+
+    /// set the maximum memory used for the chunks of a multi-part upload in
+    /// flight, each concurrent upload holding one chunk. Fewer chunks are
+    /// sent concurrently if needed, at least one.
+    /// DEFAULT: 512 MiB
+    /// @param bytes the limit in bytes, 0 for no limit
+    void setUploadBufferLimit(dav_size_t bytes);
+
+    /// get the memory limit of multi-part uploads,
+    /// see \ref setUploadBufferLimit for more details
+    dav_size_t getUploadBufferLimit() const;
+
+    /// set the size above which S3 and Swift uploads are split into chunks,
+    /// as a multi-part upload or a Static Large Object.
+    /// Azure uploads always are.
+    /// DEFAULT: 512 MiB
+    /// @param bytes the threshold in bytes
+    void setUploadThreshold(dav_size_t bytes);
+
+    /// get the multi-part upload threshold,
+    /// see \ref setUploadThreshold for more details
+    dav_size_t getUploadThreshold() const;
 private:
 
    // dptr
@@ -29,6 +29,10 @@
 #include <status/davixstatusrequest.hpp>
 #include <params/davixrequestparams.hpp>
 
+#ifdef __DAVIX_CX11_SUPPORT
+#include <future>
+#endif
+
 #ifndef __DAVIX_INSIDE__
 #error "Only davix.h or davix.hpp should be included."
 #endif
@@ -71,7 +75,8 @@ namespace RequestFlag{
     ///
     enum RequestFlag{
         SupportContinue100 = 0x01, /**< Enable support for 100 Continue code (default: OFF) */
-        IdempotentRequest  = 0x02  /**< Specifie the request as Idempotent ( default : ON) */
+        IdempotentRequest  = 0x02, /**< Specifie the request as Idempotent ( default : ON) */
+        FreshConnection    = 0x04  /**< Open a new session rather than reusing an idle one ( default : OFF) */
     };
 
 }
@@ -147,6 +152,30 @@ public:
     /// @snippet example_code_snippets.cpp HttpRequest::executeRequest
     int executeRequest(DavixError** err);
 
+#ifdef __DAVIX_CX11_SUPPORT
+
+    ///   @brief execute this request completely, asynchronously
+    ///
+    ///   Same as \ref Davix::HttpRequest::executeRequest, but returns immediately.
+    ///   The request is executed by the worker pool of the Context, see
+    ///   \ref Davix::Context::setWorkerThreads: when all its threads are busy,
+    ///   the request waits in a queue.
+    ///   The HttpRequest object must outlive the operation, and must not be
+    ///   used until it has completed.
+    ///
+    ///   @return future holding 0 on success, rethrows @ref DavixException on get() if an error occured
+    std::future<int> executeAsync();
+
+    ///   @brief execute this request completely, asynchronously
+    ///
+    ///   Callback flavour of \ref Davix::HttpRequest::executeAsync, the callback is
+    ///   invoked from a davix worker thread once the request completes.
+    ///
+    ///   @param callback completion callback
+    void executeAsync(const AsyncCompletionCallback & callback);
+
+#endif
+
     ///
     ///  set the content of the request from a string
     ///  an empty string set no request content
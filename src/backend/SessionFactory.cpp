@@ -69,6 +69,29 @@ bool SessionFactory::getSessionCaching() const {
   return _neon_factory->getSessionCaching();
 }
 
+//------------------------------------------------------------------------------
+// Session pool statistics of both neon and curl, per endpoint
+//------------------------------------------------------------------------------
+std::map<std::string, SessionPoolStats> SessionFactory::getSessionPoolStats() const {
+  std::map<std::string, SessionPoolStats> stats;
+  _neon_factory->collectSessionPoolStats(stats);
+  _curl_factory->collectSessionPoolStats(stats);
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Statistics of the blocks buffering response bodies of curl
+//------------------------------------------------------------------------------
+ResponseBufferStats SessionFactory::getResponseBufferStats() const {
+  const ResponseBlockPool::Stats pool = _curl_factory->getResponseBlockPool().getStats();
+
+  ResponseBufferStats stats;
+  stats.allocated = pool.allocated;
+  stats.reused = pool.reused;
+  stats.cached_bytes = pool.cachedBytes;
+  return stats;
+}
+
 //------------------------------------------------------------------------------
 // "httpize" protocol
 //------------------------------------------------------------------------------
@@ -95,7 +118,7 @@ std::string SessionFactory::httpizeProtocol(const std::string &protocol) {
 // Create session key based on Uri
 //------------------------------------------------------------------------------
 std::string SessionFactory::makeSessionKey(const Uri &uri) {
-    return SSTR(httpizeProtocol(uri.getProtocol()) << uri.getHost() << ":" << uri.getPort());
+    return SSTR(httpizeProtocol(uri.getProtocol()) << "://" << uri.getHost() << ":" << httpUriGetPort(uri));
 }
 
 
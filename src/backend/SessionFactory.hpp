@@ -24,6 +24,7 @@
 
 #include <davix_internal.hpp>
 
+#include <map>
 #include <mutex>
 #include <memory>
 
@@ -68,6 +69,16 @@ public:
   //----------------------------------------------------------------------------
   bool getSessionCaching() const;
 
+  //----------------------------------------------------------------------------
+  // Session pool statistics of both neon and curl, per endpoint
+  //----------------------------------------------------------------------------
+  std::map<std::string, SessionPoolStats> getSessionPoolStats() const;
+
+  //----------------------------------------------------------------------------
+  // Statistics of the blocks buffering response bodies of curl
+  //----------------------------------------------------------------------------
+  ResponseBufferStats getResponseBufferStats() const;
+
   //----------------------------------------------------------------------------
   // "httpize" protocol
   //----------------------------------------------------------------------------
@@ -35,9 +35,9 @@ namespace Davix {
 //------------------------------------------------------------------------------
 class NeonSessionWrapper {
 public:
-    NeonSessionWrapper(StandaloneNeonRequest* r, NEONSessionFactory &factory, const Uri &uri, const RequestParams &p, DavixError **err)
+    NeonSessionWrapper(StandaloneNeonRequest* r, NEONSessionFactory &factory, const Uri &uri, const RequestParams &p, bool fresh, DavixError **err)
         : _r(r) {
-        _sess = factory.provideNEONSession(uri, p, err);
+        _sess = factory.provideNEONSession(uri, p, err, fresh);
 
         if(_sess && _sess->get_ne_sess() != NULL){
             ne_hook_pre_send(_sess->get_ne_sess(), NeonSessionWrapper::runHookPreSend, (void*) this);
@@ -225,7 +225,8 @@ Status StandaloneNeonRequest::startRequest() {
   // Retrieve a session, create request
   //----------------------------------------------------------------------------
   DavixError* tmp_err = NULL;
-  _session.reset(new NeonSessionWrapper(this, _session_factory, _uri, _params, &tmp_err));
+  _session.reset(new NeonSessionWrapper(this, _session_factory, _uri, _params,
+    (_req_flag & RequestFlag::FreshConnection) != 0, &tmp_err));
 
   if(tmp_err) {
     markCompleted();
@@ -0,0 +1,311 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "BlockCache.hpp"
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Most URLs whose validator, or lack of range support, is remembered
+//------------------------------------------------------------------------------
+static const size_t kMaxUrls = 4096;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+BlockCache::BlockCache(dav_size_t capacity)
+: _capacity(capacity), _size(0), _generation(0), _validators(kMaxUrls), _rangeless(kMaxUrls),
+  _hits(0), _misses(0), _waits(0) {}
+
+//------------------------------------------------------------------------------
+// Change the capacity, evicting blocks if needed
+//------------------------------------------------------------------------------
+void BlockCache::setCapacity(dav_size_t capacity) {
+  std::lock_guard<std::mutex> lock(_mtx);
+  _capacity = capacity;
+  evict();
+}
+
+//------------------------------------------------------------------------------
+// Get the capacity
+//------------------------------------------------------------------------------
+dav_size_t BlockCache::getCapacity() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _capacity;
+}
+
+//------------------------------------------------------------------------------
+// Build the key of a block
+//------------------------------------------------------------------------------
+std::string BlockCache::makeKey(const std::string &url, const std::string &validator, dav_off_t index) {
+  std::string key(url);
+  key.append(1, '\n').append(validator).append(1, '\n').append(std::to_string(index));
+  return key;
+}
+
+//------------------------------------------------------------------------------
+// Get a block, calling the fetcher on a miss
+//------------------------------------------------------------------------------
+BlockCache::Block BlockCache::get(const std::string &key, const Fetcher &fetcher) {
+  std::promise<Block> promise;
+  uint64_t generation;
+
+  {
+    std::unique_lock<std::mutex> lock(_mtx);
+    auto it = _entries.find(key);
+
+    if(it != _entries.end()) {
+      if(it->second.ready) {
+        _hits++;
+        _lru.splice(_lru.begin(), _lru, it->second.lru);
+        return it->second.block;
+      }
+
+      // someone is already fetching this block
+      _waits++;
+      std::shared_future<Block> pending = it->second.pending;
+      lock.unlock();
+      return pending.get();
+    }
+
+    _misses++;
+    generation = ++_generation;
+
+    Entry &entry = _entries[key];
+    entry.pending = promise.get_future().share();
+    entry.generation = generation;
+  }
+
+  Block block;
+  try {
+    block = fetcher();
+  }
+  catch(...) {
+    {
+      std::lock_guard<std::mutex> lock(_mtx);
+      auto it = _entries.find(key);
+      if(it != _entries.end() && !it->second.ready && it->second.generation == generation) {
+        _entries.erase(it);
+      }
+    }
+
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  {
+    // the entry is gone if the URL was invalidated in the meantime
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto it = _entries.find(key);
+    if(it != _entries.end() && !it->second.ready && it->second.generation == generation) {
+      _entries.erase(it);
+
+      if(block) {
+        store(key, block);
+      }
+    }
+  }
+
+  promise.set_value(block);
+  return block;
+}
+
+//------------------------------------------------------------------------------
+// Store a block under the given key
+//------------------------------------------------------------------------------
+void BlockCache::insert(const std::string &key, const Block &block) {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  auto it = _entries.find(key);
+  if(it != _entries.end()) {
+    erase(it);
+  }
+
+  store(key, block);
+}
+
+//------------------------------------------------------------------------------
+// Drop the block stored under the given key
+//------------------------------------------------------------------------------
+void BlockCache::drop(const std::string &key) {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  auto it = _entries.find(key);
+  if(it != _entries.end() && it->second.ready) {
+    erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Store a block - lock must be held
+//------------------------------------------------------------------------------
+void BlockCache::store(const std::string &key, const Block &block) {
+  if(!block || block->size() > _capacity) {
+    return;
+  }
+
+  _lru.push_front(key);
+
+  Entry &entry = _entries[key];
+  entry.ready = true;
+  entry.block = block;
+  entry.lru = _lru.begin();
+
+  _size += block->size();
+  evict();
+}
+
+//------------------------------------------------------------------------------
+// Remove an entry - lock must be held
+//------------------------------------------------------------------------------
+void BlockCache::erase(std::map<std::string, Entry>::iterator it) {
+  if(it->second.ready) {
+    _size -= it->second.block->size();
+    _lru.erase(it->second.lru);
+  }
+
+  _entries.erase(it);
+}
+
+//------------------------------------------------------------------------------
+// Evict blocks until under capacity - lock must be held
+//------------------------------------------------------------------------------
+void BlockCache::evict() {
+  while(_size > _capacity && !_lru.empty()) {
+    erase(_entries.find(_lru.back()));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Last validator seen for the given URL
+//------------------------------------------------------------------------------
+std::string BlockCache::getValidator(const std::string &url) const {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  std::shared_ptr<Validator> validator = _validators.find(url);
+  if(!validator) {
+    return std::string();
+  }
+
+  return validator->value;
+}
+
+//------------------------------------------------------------------------------
+// Was the validator of the given URL checked less than maxAge ago?
+//------------------------------------------------------------------------------
+bool BlockCache::isValidated(const std::string &url, std::chrono::seconds maxAge) const {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  std::shared_ptr<Validator> validator = _validators.find(url);
+  return validator && validator->checkedAt + maxAge >= std::chrono::steady_clock::now();
+}
+
+//------------------------------------------------------------------------------
+// Record the validator of the given URL
+//------------------------------------------------------------------------------
+void BlockCache::setValidator(const std::string &url, const std::string &validator) {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  std::shared_ptr<Validator> checked(new Validator());
+  checked->value = validator;
+  checked->checkedAt = std::chrono::steady_clock::now();
+
+  // without a validator, there is no telling whether the file changed
+  std::shared_ptr<Validator> known = _validators.find(url);
+  if(!known || known->value != validator || validator.empty()) {
+    dropUrl(url);
+  }
+
+  _validators.insert(url, checked);
+}
+
+//------------------------------------------------------------------------------
+// Remember that the server of the given URL ignores range requests
+//------------------------------------------------------------------------------
+void BlockCache::setRangeless(const std::string &url) {
+  std::lock_guard<std::mutex> lock(_mtx);
+  dropUrl(url);
+  _rangeless.insert(url, std::make_shared<bool>(true));
+}
+
+//------------------------------------------------------------------------------
+// Does the server of the given URL ignore range requests?
+//------------------------------------------------------------------------------
+bool BlockCache::isRangeless(const std::string &url) const {
+  return _rangeless.find(url).get() != NULL;
+}
+
+//------------------------------------------------------------------------------
+// Drop the entries of the given URL - lock must be held
+//------------------------------------------------------------------------------
+void BlockCache::dropUrl(const std::string &url) {
+  const std::string prefix = url + '\n';
+
+  auto it = _entries.lower_bound(prefix);
+  while(it != _entries.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+    erase(it++);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop everything cached about the given URL
+//------------------------------------------------------------------------------
+void BlockCache::invalidate(const std::string &url) {
+  std::lock_guard<std::mutex> lock(_mtx);
+  dropUrl(url);
+  _validators.erase(url);
+}
+
+//------------------------------------------------------------------------------
+// Drop everything
+//------------------------------------------------------------------------------
+void BlockCache::clear() {
+  std::lock_guard<std::mutex> lock(_mtx);
+  _entries.clear();
+  _lru.clear();
+  _validators.clear();
+  _rangeless.clear();
+  _size = 0;
+}
+
+//------------------------------------------------------------------------------
+// Statistics
+//------------------------------------------------------------------------------
+dav_size_t BlockCache::size() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _size;
+}
+
+dav_size_t BlockCache::hits() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _hits;
+}
+
+dav_size_t BlockCache::misses() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _misses;
+}
+
+dav_size_t BlockCache::waits() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _waits;
+}
+
+}
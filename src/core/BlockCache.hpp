@@ -0,0 +1,197 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_CORE_BLOCK_CACHE_HPP
+#define DAVIX_CORE_BLOCK_CACHE_HPP
+
+#include <davix_internal.hpp>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <libs/alibxx/containers/cache.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// In-memory cache of file blocks, shared by every file of a Context.
+// Owned by the Context, disabled as long as its capacity is 0.
+//
+// Blocks are keyed by URL, validator (ETag) and block index, and evicted in
+// LRU order once the cached bytes exceed the capacity. Concurrent misses on
+// the same block are served by a single fetch: the first caller fetches,
+// the others wait for its outcome.
+//
+// The cache remembers the last validator seen for each URL, and when it was
+// last checked. When a fetch returns a different one, the file changed on
+// the server: every block cached under the old validator is dropped. It also remembers the URLs
+// whose server ignores range requests, those are not cached at all. Both
+// are kept for a bounded number of URLs, least recently used first out.
+//------------------------------------------------------------------------------
+class BlockCache {
+public:
+  typedef std::shared_ptr<const std::vector<char> > Block;
+  typedef std::function<Block()> Fetcher;
+
+  //----------------------------------------------------------------------------
+  // Constructor - capacity in bytes, 0 disables the cache
+  //----------------------------------------------------------------------------
+  BlockCache(dav_size_t capacity = 0);
+
+  //----------------------------------------------------------------------------
+  // Change the capacity, evicting blocks if needed
+  //----------------------------------------------------------------------------
+  void setCapacity(dav_size_t capacity);
+
+  //----------------------------------------------------------------------------
+  // Get the capacity
+  //----------------------------------------------------------------------------
+  dav_size_t getCapacity() const;
+
+  //----------------------------------------------------------------------------
+  // Build the key of a block
+  //----------------------------------------------------------------------------
+  static std::string makeKey(const std::string &url, const std::string &validator, dav_off_t index);
+
+  //----------------------------------------------------------------------------
+  // Get the block stored under the given key, calling the fetcher on a miss.
+  // A block the fetcher returns as NULL is not cached; if the fetcher throws,
+  // the exception is propagated to every caller waiting for that block.
+  //----------------------------------------------------------------------------
+  Block get(const std::string &key, const Fetcher &fetcher);
+
+  //----------------------------------------------------------------------------
+  // Store a block under the given key
+  //----------------------------------------------------------------------------
+  void insert(const std::string &key, const Block &block);
+
+  //----------------------------------------------------------------------------
+  // Drop the block stored under the given key, so that the next get fetches
+  // it again - a fetch in progress is left alone
+  //----------------------------------------------------------------------------
+  void drop(const std::string &key);
+
+  //----------------------------------------------------------------------------
+  // Last validator seen for the given URL, empty if none
+  //----------------------------------------------------------------------------
+  std::string getValidator(const std::string &url) const;
+
+  //----------------------------------------------------------------------------
+  // Was the validator of the given URL checked less than maxAge ago?
+  //----------------------------------------------------------------------------
+  bool isValidated(const std::string &url, std::chrono::seconds maxAge) const;
+
+  //----------------------------------------------------------------------------
+  // Record the validator of the given URL, just checked - if it changed, or
+  // is empty and can't tell, the blocks cached under the old one are dropped
+  //----------------------------------------------------------------------------
+  void setValidator(const std::string &url, const std::string &validator);
+
+  //----------------------------------------------------------------------------
+  // Remember that the server of the given URL ignores range requests
+  //----------------------------------------------------------------------------
+  void setRangeless(const std::string &url);
+
+  //----------------------------------------------------------------------------
+  // Does the server of the given URL ignore range requests?
+  //----------------------------------------------------------------------------
+  bool isRangeless(const std::string &url) const;
+
+  //----------------------------------------------------------------------------
+  // Drop the blocks and validator of the given URL
+  //----------------------------------------------------------------------------
+  void invalidate(const std::string &url);
+
+  //----------------------------------------------------------------------------
+  // Drop everything
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  // Statistics: bytes cached, blocks served from the cache, blocks fetched,
+  // and blocks obtained by waiting on a fetch issued by someone else
+  //----------------------------------------------------------------------------
+  dav_size_t size() const;
+  dav_size_t hits() const;
+  dav_size_t misses() const;
+  dav_size_t waits() const;
+
+private:
+  struct Validator {
+    std::string value;
+    std::chrono::steady_clock::time_point checkedAt;
+  };
+
+  struct Entry {
+    Entry() : ready(false), generation(0) {}
+
+    bool ready;
+    Block block;
+    // while not ready: outcome of the fetch in progress
+    std::shared_future<Block> pending;
+    uint64_t generation;
+    std::list<std::string>::iterator lru;
+  };
+
+  //----------------------------------------------------------------------------
+  // Remove an entry - lock must be held
+  //----------------------------------------------------------------------------
+  void erase(std::map<std::string, Entry>::iterator it);
+
+  //----------------------------------------------------------------------------
+  // Store a block - lock must be held
+  //----------------------------------------------------------------------------
+  void store(const std::string &key, const Block &block);
+
+  //----------------------------------------------------------------------------
+  // Evict blocks until under capacity - lock must be held
+  //----------------------------------------------------------------------------
+  void evict();
+
+  //----------------------------------------------------------------------------
+  // Drop the entries of the given URL - lock must be held
+  //----------------------------------------------------------------------------
+  void dropUrl(const std::string &url);
+
+  mutable std::mutex _mtx;
+  dav_size_t _capacity;
+  dav_size_t _size;
+  uint64_t _generation;
+
+  // keys are ordered, so that the blocks of a URL are contiguous
+  std::map<std::string, Entry> _entries;
+  // most recently used first, ready entries only
+  std::list<std::string> _lru;
+  mutable Cache<std::string, Validator> _validators;
+  mutable Cache<std::string, bool> _rangeless;
+
+  dav_size_t _hits;
+  dav_size_t _misses;
+  dav_size_t _waits;
+};
+
+}
+
+#endif
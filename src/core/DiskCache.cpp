@@ -0,0 +1,590 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "DiskCache.hpp"
+#include <libs/alibxx/crypto/hmacsha.hpp>
+#include <utils/davix_logger_internal.hpp>
+
+#include <algorithm>
+#include <set>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Index layout: header, then the block bitmap at a fixed offset
+//------------------------------------------------------------------------------
+static const char kMagic[8] = { 'D', 'A', 'V', 'I', 'X', 'D', 'C', '1' };
+static const dav_size_t kHeaderFixedSize = 32;
+static const dav_off_t kBitmapOffset = 4096;
+
+static const dav_size_t kBlockSize = DAVIX_DISK_CACHE_BLOCK_SIZE;
+
+//------------------------------------------------------------------------------
+// Entries of this process kept open at most
+//------------------------------------------------------------------------------
+static const size_t kMaxEntries = 64;
+
+//------------------------------------------------------------------------------
+// Attempts at opening the files of an entry, while they get removed
+//------------------------------------------------------------------------------
+static const size_t kOpenAttempts = 3;
+
+static bool lockFile(int fd, int operation) {
+  int ret;
+  while((ret = flock(fd, operation)) != 0 && errno == EINTR) {}
+  return ret == 0;
+}
+
+//------------------------------------------------------------------------------
+// flock() for the lifetime of the object
+//------------------------------------------------------------------------------
+class FileLock {
+public:
+  FileLock(int fd, int operation) : _fd(fd) {
+    lockFile(_fd, operation);
+  }
+
+  ~FileLock() {
+    flock(_fd, LOCK_UN);
+  }
+
+private:
+  int _fd;
+};
+
+static bool readFully(int fd, char *buf, dav_size_t count, dav_off_t offset) {
+  while(count > 0) {
+    ssize_t ret = ::pread(fd, buf, count, offset);
+    if(ret < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if(ret <= 0) {
+      return false;
+    }
+
+    buf += ret;
+    count -= ret;
+    offset += ret;
+  }
+
+  return true;
+}
+
+static bool writeFully(int fd, const char *buf, dav_size_t count, dav_off_t offset) {
+  while(count > 0) {
+    ssize_t ret = ::pwrite(fd, buf, count, offset);
+    if(ret < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if(ret <= 0) {
+      return false;
+    }
+
+    buf += ret;
+    count -= ret;
+    offset += ret;
+  }
+
+  return true;
+}
+
+static void appendInteger(std::string &out, uint64_t value, size_t bytes) {
+  for(size_t i = 0; i < bytes; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+static dav_size_t diskUsage(const struct stat &st) {
+  return static_cast<dav_size_t>(st.st_blocks) * 512;
+}
+
+static bool hasSuffix(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool isUnlinked(int fd) {
+  struct stat st;
+  return ::fstat(fd, &st) != 0 || st.st_nlink == 0;
+}
+
+//------------------------------------------------------------------------------
+// Remove the files of an entry, data file first, with its index locked -
+// false if the index is locked by someone else and wait isn't set
+//------------------------------------------------------------------------------
+static bool removeFiles(const std::string &base, bool wait) {
+  const int fd = ::open((base + ".index").c_str(), O_RDWR | O_CLOEXEC);
+  if(fd < 0) {
+    return errno == ENOENT;
+  }
+
+  if(!lockFile(fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB)) {
+    ::close(fd);
+    return false;
+  }
+
+  ::unlink((base + ".data").c_str());
+  ::unlink((base + ".index").c_str());
+  ::close(fd);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+DiskCache::DiskCache() : _limit(0), _writtenSinceTrim(0), _entries(kMaxEntries) {}
+
+DiskCache::~DiskCache() {}
+
+//------------------------------------------------------------------------------
+// Use the given directory, holding at most limit bytes
+//------------------------------------------------------------------------------
+void DiskCache::configure(const std::string &directory, dav_size_t limit) {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _directory = directory;
+    _limit = limit;
+    _writtenSinceTrim = 0;
+  }
+
+  _entries.clear();
+
+  if(!directory.empty()) {
+    if(::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+      DAVIX_SLOG(DAVIX_LOG_WARNING, DAVIX_LOG_CHAIN, "Unable to create disk cache directory {}: {}", directory, strerror(errno));
+    }
+
+    trim();
+  }
+}
+
+std::string DiskCache::getDirectory() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _directory;
+}
+
+dav_size_t DiskCache::getLimit() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _limit;
+}
+
+bool DiskCache::enabled() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return !_directory.empty();
+}
+
+//------------------------------------------------------------------------------
+// Local file name of the given URL, without extension
+//------------------------------------------------------------------------------
+std::string DiskCache::makeName(const std::string &url) {
+  static const char digits[] = "0123456789abcdef";
+
+  const std::string hash = sha256(url);
+  std::string name;
+  for(size_t i = 0; i < hash.size(); i++) {
+    name.push_back(digits[(hash[i] >> 4) & 0xf]);
+    name.push_back(digits[hash[i] & 0xf]);
+  }
+
+  return name;
+}
+
+std::string DiskCache::pathOf(const std::string &url) const {
+  return _directory + "/" + makeName(url);
+}
+
+//------------------------------------------------------------------------------
+// Look up the entry of the given URL
+//------------------------------------------------------------------------------
+bool DiskCache::lookup(const std::string &url, std::chrono::seconds maxAge, std::shared_ptr<Entry> &entry) {
+  std::shared_ptr<Opened> opened = _entries.find(url);
+  if(!opened || opened->validatedAt + maxAge < std::chrono::steady_clock::now()) {
+    return false;
+  }
+
+  // removed by a trim, maybe from another process: open it again
+  if(opened->entry && opened->entry->unlinked()) {
+    _entries.erase(url);
+    return false;
+  }
+
+  entry = opened->entry;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remember the outcome of opening the given URL
+//------------------------------------------------------------------------------
+std::shared_ptr<DiskCache::Entry> DiskCache::remember(const std::string &url, const std::shared_ptr<Entry> &entry) {
+  std::shared_ptr<Opened> opened(new Opened());
+  opened->entry = entry;
+  opened->validatedAt = std::chrono::steady_clock::now();
+  _entries.insert(url, opened);
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Open the entry of the given URL
+//------------------------------------------------------------------------------
+std::shared_ptr<DiskCache::Entry> DiskCache::open(const std::string &url, const std::string &validator, dav_size_t size) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if(_directory.empty()) {
+      return std::shared_ptr<Entry>();
+    }
+
+    path = pathOf(url);
+  }
+
+  if(validator.empty() || kHeaderFixedSize + url.size() + validator.size() > (dav_size_t) kBitmapOffset) {
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Unable to validate {}, not caching it on disk", url);
+    return remember(url, std::shared_ptr<Entry>());
+  }
+
+  // files are removed with their index locked: once we hold the lock of an
+  // index still in the directory, the data file next to it goes with it
+  int indexFd = -1;
+  int dataFd = -1;
+
+  for(size_t attempt = 0; attempt < kOpenAttempts && dataFd < 0; attempt++) {
+    indexFd = ::open((path + ".index").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(indexFd < 0) {
+      break;
+    }
+
+    if(lockFile(indexFd, LOCK_EX) && !isUnlinked(indexFd)) {
+      dataFd = ::open((path + ".data").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if(dataFd >= 0) {
+        break;
+      }
+    }
+
+    ::close(indexFd);
+    indexFd = -1;
+  }
+
+  if(indexFd < 0 || dataFd < 0) {
+    DAVIX_SLOG(DAVIX_LOG_WARNING, DAVIX_LOG_CHAIN, "Unable to open disk cache files {}: {}", path, strerror(errno));
+    if(indexFd >= 0) ::close(indexFd);
+    return remember(url, std::shared_ptr<Entry>());
+  }
+
+  std::shared_ptr<Entry> entry(new Entry(indexFd, dataFd, url, validator, size));
+  const bool ready = entry->setup();
+
+  // least recently opened files go first when trimming
+  if(ready) {
+    ::futimens(indexFd, NULL);
+  }
+
+  lockFile(indexFd, LOCK_UN);
+
+  if(!ready) {
+    DAVIX_SLOG(DAVIX_LOG_WARNING, DAVIX_LOG_CHAIN, "Unable to set up disk cache files {}: {}", path, strerror(errno));
+    return remember(url, std::shared_ptr<Entry>());
+  }
+
+  return remember(url, entry);
+}
+
+//------------------------------------------------------------------------------
+// Remove the cached blocks of the given URL
+//------------------------------------------------------------------------------
+void DiskCache::invalidate(const std::string &url) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if(_directory.empty()) {
+      return;
+    }
+
+    path = pathOf(url);
+  }
+
+  _entries.erase(url);
+  removeFiles(path, true);
+}
+
+//------------------------------------------------------------------------------
+// Forget the entries opened by this process
+//------------------------------------------------------------------------------
+void DiskCache::forget() {
+  _entries.clear();
+}
+
+//------------------------------------------------------------------------------
+// Account for bytes added to the directory
+//------------------------------------------------------------------------------
+void DiskCache::written(dav_size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if(_limit == 0) {
+      return;
+    }
+
+    _writtenSinceTrim += bytes;
+
+    // no need to look at the directory after each block
+    if(_writtenSinceTrim < std::max<dav_size_t>(_limit / 16, kBlockSize)) {
+      return;
+    }
+
+    _writtenSinceTrim = 0;
+  }
+
+  trim();
+}
+
+//------------------------------------------------------------------------------
+// Remove the least recently opened files until under the limit
+//------------------------------------------------------------------------------
+void DiskCache::trim() {
+  std::string directory;
+  dav_size_t limit;
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    directory = _directory;
+    limit = _limit;
+  }
+
+  DIR *dir = ::opendir(directory.c_str());
+  if(dir == NULL) {
+    return;
+  }
+
+  struct Item {
+    struct timespec used;
+    dav_size_t bytes;
+    std::string base;
+
+    bool operator<(const Item &other) const {
+      return used.tv_sec < other.used.tv_sec ||
+             (used.tv_sec == other.used.tv_sec && used.tv_nsec < other.used.tv_nsec);
+    }
+  };
+
+  std::vector<Item> items;
+  dav_size_t total = 0;
+
+  struct dirent *ent;
+  while((ent = ::readdir(dir)) != NULL) {
+    const std::string name(ent->d_name);
+    if(!hasSuffix(name, ".index")) {
+      continue;
+    }
+
+    Item item;
+    item.base = directory + "/" + name.substr(0, name.size() - 6);
+
+    struct stat st;
+    if(::stat((item.base + ".index").c_str(), &st) != 0) {
+      continue;
+    }
+
+#ifdef __APPLE__
+    item.used = st.st_mtimespec;
+#else
+    item.used = st.st_mtim;
+#endif
+    item.bytes = diskUsage(st);
+
+    if(::stat((item.base + ".data").c_str(), &st) == 0) {
+      item.bytes += diskUsage(st);
+    }
+
+    total += item.bytes;
+    items.push_back(item);
+  }
+
+  ::closedir(dir);
+
+  if(limit == 0 || total <= limit) {
+    return;
+  }
+
+  // trim a bit more than needed, not to do it again after the next block
+  const dav_size_t target = limit - limit / 10;
+  std::sort(items.begin(), items.end());
+
+  // files being read or written right now are skipped
+  std::set<std::string> removed;
+  for(size_t i = 0; i < items.size() && total > target; i++) {
+    if(removeFiles(items[i].base, false)) {
+      total -= items[i].bytes;
+      removed.insert(items[i].base);
+    }
+  }
+
+  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Removed {} files from disk cache {}", removed.size(), directory);
+
+  // release the files of our entries right away, they can't be used anymore
+  std::vector<std::string> urls;
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _entries.forEach([&](const std::string &url, const std::shared_ptr<Opened> &) {
+      if(removed.count(pathOf(url)) != 0) {
+        urls.push_back(url);
+      }
+    });
+  }
+
+  for(size_t i = 0; i < urls.size(); i++) {
+    _entries.erase(urls[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Entry constructor
+//------------------------------------------------------------------------------
+DiskCache::Entry::Entry(int indexFd, int dataFd, const std::string &url, const std::string &validator, dav_size_t size)
+: _indexFd(indexFd), _dataFd(dataFd), _url(url), _validator(validator), _size(size) {
+
+  _header.append(kMagic, sizeof(kMagic));
+  appendInteger(_header, kBlockSize, 8);
+  appendInteger(_header, size, 8);
+  appendInteger(_header, url.size(), 4);
+  appendInteger(_header, validator.size(), 4);
+  _header.append(url);
+  _header.append(validator);
+}
+
+DiskCache::Entry::~Entry() {
+  ::close(_indexFd);
+  ::close(_dataFd);
+}
+
+dav_size_t DiskCache::Entry::fileSize() const {
+  return _size;
+}
+
+dav_size_t DiskCache::Entry::blockSize() const {
+  return kBlockSize;
+}
+
+//------------------------------------------------------------------------------
+// Check the index still describes our version of the file
+//------------------------------------------------------------------------------
+bool DiskCache::Entry::current() {
+  std::vector<char> header(_header.size());
+  return !unlinked() && readFully(_indexFd, header.data(), header.size(), 0) &&
+         memcmp(header.data(), _header.data(), header.size()) == 0;
+}
+
+//------------------------------------------------------------------------------
+// Check whether our files were removed since opened
+//------------------------------------------------------------------------------
+bool DiskCache::Entry::unlinked() const {
+  return isUnlinked(_indexFd) || isUnlinked(_dataFd);
+}
+
+//------------------------------------------------------------------------------
+// Make the index describe our version of the file
+//------------------------------------------------------------------------------
+bool DiskCache::Entry::setup() {
+  if(current()) {
+    return true;
+  }
+
+  const dav_size_t blocks = (_size + kBlockSize - 1) / kBlockSize;
+
+  return ::ftruncate(_dataFd, 0) == 0 && ::ftruncate(_dataFd, _size) == 0 &&
+         ::ftruncate(_indexFd, 0) == 0 && ::ftruncate(_indexFd, kBitmapOffset + (blocks + 7) / 8) == 0 &&
+         writeFully(_indexFd, _header.data(), _header.size(), 0);
+}
+
+//------------------------------------------------------------------------------
+// Indexes of the blocks missing in [first, last]
+//------------------------------------------------------------------------------
+std::vector<dav_off_t> DiskCache::Entry::missingBlocks(dav_off_t first, dav_off_t last) {
+  std::vector<dav_off_t> missing;
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  FileLock flock(_indexFd, LOCK_SH);
+
+  std::vector<char> bitmap(last / 8 - first / 8 + 1);
+  if(!current() || !readFully(_indexFd, bitmap.data(), bitmap.size(), kBitmapOffset + first / 8)) {
+    bitmap.assign(bitmap.size(), 0);
+  }
+
+  for(dav_off_t i = first; i <= last; i++) {
+    if((bitmap[i / 8 - first / 8] & (1 << (i % 8))) == 0) {
+      missing.push_back(i);
+    }
+  }
+
+  return missing;
+}
+
+//------------------------------------------------------------------------------
+// Store a block
+//------------------------------------------------------------------------------
+bool DiskCache::Entry::writeBlock(dav_off_t index, const char *data, dav_size_t size) {
+  std::lock_guard<std::mutex> lock(_mtx);
+  FileLock flock(_indexFd, LOCK_EX);
+
+  // someone else may have seen a newer version of the file in the meantime
+  if(!current()) {
+    return false;
+  }
+
+  char bits;
+  if(!writeFully(_dataFd, data, size, index * kBlockSize) ||
+     !readFully(_indexFd, &bits, 1, kBitmapOffset + index / 8)) {
+    return false;
+  }
+
+  bits |= (1 << (index % 8));
+  return writeFully(_indexFd, &bits, 1, kBitmapOffset + index / 8);
+}
+
+//------------------------------------------------------------------------------
+// Read from the cached blocks
+//------------------------------------------------------------------------------
+bool DiskCache::Entry::read(char *buf, dav_size_t count, dav_off_t offset) {
+  if(count == 0) {
+    return true;
+  }
+
+  const dav_off_t first = offset / kBlockSize;
+  const dav_off_t last = (offset + count - 1) / kBlockSize;
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  FileLock flock(_indexFd, LOCK_SH);
+
+  std::vector<char> bitmap(last / 8 - first / 8 + 1);
+  if(!current() || !readFully(_indexFd, bitmap.data(), bitmap.size(), kBitmapOffset + first / 8)) {
+    return false;
+  }
+
+  for(dav_off_t i = first; i <= last; i++) {
+    if((bitmap[i / 8 - first / 8] & (1 << (i % 8))) == 0) {
+      return false;
+    }
+  }
+
+  return readFully(_dataFd, buf, count, offset);
+}
+
+}
@@ -0,0 +1,190 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_CORE_DISK_CACHE_HPP
+#define DAVIX_CORE_DISK_CACHE_HPP
+
+#include <davix_internal.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <libs/alibxx/containers/cache.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Persistent cache of remote file blocks, in a local directory. Owned by the
+// Context, disabled until a directory is configured.
+//
+// Each remote file is cached as a pair of local files, named after a hash of
+// its URL:
+//  - <hash>.data, sparse, with blocks stored at their offset in the remote file
+//  - <hash>.index, holding the URL, the validator of the remote file, and a
+//    bitmap of the blocks present in the data file
+//
+// The index is locked with flock() while reading or updating blocks, so that
+// several processes can share the directory. When the validator of a remote
+// file changes, its blocks are discarded.
+//
+// The directory is kept under its size limit by removing the least recently
+// opened files. Files are only removed with their index locked, data file
+// first: an entry whose files were removed since it was opened notices it,
+// and stops being used.
+//------------------------------------------------------------------------------
+class DiskCache {
+public:
+  class Entry;
+
+  DiskCache();
+  ~DiskCache();
+
+  //----------------------------------------------------------------------------
+  // Use the given directory, holding at most limit bytes, or as much as
+  // needed if 0 - an empty directory disables the cache
+  //----------------------------------------------------------------------------
+  void configure(const std::string &directory, dav_size_t limit);
+
+  std::string getDirectory() const;
+  dav_size_t getLimit() const;
+  bool enabled() const;
+
+  //----------------------------------------------------------------------------
+  // Look up the entry of the given URL: false if it wasn't opened less than
+  // maxAge ago, or if its files were removed since, and needs to be validated
+  // again. Otherwise, entry is set - to NULL if the file can't be cached.
+  //----------------------------------------------------------------------------
+  bool lookup(const std::string &url, std::chrono::seconds maxAge, std::shared_ptr<Entry> &entry);
+
+  //----------------------------------------------------------------------------
+  // Open the entry of the given URL, whose remote file currently has the
+  // given validator and size. Blocks cached for another validator are
+  // discarded. NULL if the file can't be cached, which is remembered as
+  // well - an empty validator means the file can't be validated.
+  //----------------------------------------------------------------------------
+  std::shared_ptr<Entry> open(const std::string &url, const std::string &validator, dav_size_t size);
+
+  //----------------------------------------------------------------------------
+  // Remove the cached blocks of the given URL
+  //----------------------------------------------------------------------------
+  void invalidate(const std::string &url);
+
+  //----------------------------------------------------------------------------
+  // Forget the entries opened by this process - the directory is left alone
+  //----------------------------------------------------------------------------
+  void forget();
+
+  //----------------------------------------------------------------------------
+  // Account for bytes added to the directory, trimming it when needed
+  //----------------------------------------------------------------------------
+  void written(dav_size_t bytes);
+
+  //----------------------------------------------------------------------------
+  // Remove the least recently opened files until the directory is under
+  // its limit
+  //----------------------------------------------------------------------------
+  void trim();
+
+  //----------------------------------------------------------------------------
+  // Local file name of the given URL, without extension
+  //----------------------------------------------------------------------------
+  static std::string makeName(const std::string &url);
+
+private:
+  struct Opened {
+    std::shared_ptr<Entry> entry;
+    std::chrono::steady_clock::time_point validatedAt;
+  };
+
+  std::string pathOf(const std::string &url) const;
+
+  //----------------------------------------------------------------------------
+  // Remember the outcome of opening the given URL
+  //----------------------------------------------------------------------------
+  std::shared_ptr<Entry> remember(const std::string &url, const std::shared_ptr<Entry> &entry);
+
+  mutable std::mutex _mtx;
+  std::string _directory;
+  dav_size_t _limit;
+  dav_size_t _writtenSinceTrim;
+
+  Cache<std::string, Opened> _entries;
+};
+
+//------------------------------------------------------------------------------
+// The cached blocks of one remote file
+//------------------------------------------------------------------------------
+class DiskCache::Entry {
+public:
+  ~Entry();
+
+  dav_size_t fileSize() const;
+  dav_size_t blockSize() const;
+
+  //----------------------------------------------------------------------------
+  // Indexes of the blocks missing in [first, last]
+  //----------------------------------------------------------------------------
+  std::vector<dav_off_t> missingBlocks(dav_off_t first, dav_off_t last);
+
+  //----------------------------------------------------------------------------
+  // Store a block - size must be the block size, except for the last block
+  //----------------------------------------------------------------------------
+  bool writeBlock(dav_off_t index, const char *data, dav_size_t size);
+
+  //----------------------------------------------------------------------------
+  // Read from the cached blocks, false if any of them is missing
+  //----------------------------------------------------------------------------
+  bool read(char *buf, dav_size_t count, dav_off_t offset);
+
+private:
+  friend class DiskCache;
+
+  Entry(int indexFd, int dataFd, const std::string &url, const std::string &validator, dav_size_t size);
+
+  //----------------------------------------------------------------------------
+  // Check the index still describes our version of the file - index lock
+  // must be held
+  //----------------------------------------------------------------------------
+  bool current();
+
+  //----------------------------------------------------------------------------
+  // Check whether our files were removed from the directory since opened
+  //----------------------------------------------------------------------------
+  bool unlinked() const;
+
+  //----------------------------------------------------------------------------
+  // Make the index describe our version of the file, discarding blocks if
+  // needed - exclusive index lock must be held
+  //----------------------------------------------------------------------------
+  bool setup();
+
+  std::mutex _mtx;
+  int _indexFd;
+  int _dataFd;
+  std::string _url;
+  std::string _validator;
+  dav_size_t _size;
+  std::string _header;
+};
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "LinkEstimator.hpp"
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Weight of a new sample in the moving averages
+//------------------------------------------------------------------------------
+static const double kSampleWeight = 0.25;
+
+//------------------------------------------------------------------------------
+// Bodies smaller than this are dominated by latency, their throughput is
+// meaningless
+//------------------------------------------------------------------------------
+static const dav_size_t kMinBandwidthSample = 65536;
+
+static void addSample(double &average, double sample) {
+  if(average <= 0) {
+    average = sample;
+  }
+  else {
+    average += kSampleWeight * (sample - average);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+LinkEstimator::LinkEstimator(size_t maxEndpoints) : _entries(maxEndpoints) {}
+
+//------------------------------------------------------------------------------
+// Find or create the entry of the given endpoint - lock must be held
+//------------------------------------------------------------------------------
+std::shared_ptr<LinkEstimator::Entry> LinkEstimator::getEntry(const std::string &endpoint) {
+  std::shared_ptr<Entry> entry = _entries.find(endpoint);
+  if(!entry) {
+    entry = _entries.insert(endpoint, std::make_shared<Entry>());
+  }
+
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Record one request towards the given endpoint
+//------------------------------------------------------------------------------
+void LinkEstimator::recordRequest(const std::string &endpoint, std::chrono::microseconds latency,
+  dav_size_t bytes, std::chrono::microseconds transferTime) {
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  Entry &entry = *getEntry(endpoint);
+
+  if(latency.count() > 0) {
+    addSample(entry.latency, latency.count());
+  }
+
+  if(bytes >= kMinBandwidthSample && transferTime.count() > 0) {
+    addSample(entry.bandwidth, bytes * 1000000.0 / transferTime.count());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record the outcome of planning one vectored read
+//------------------------------------------------------------------------------
+void LinkEstimator::recordVectorRead(const std::string &endpoint, dav_size_t rangesRequested,
+  dav_size_t rangesIssued, dav_size_t bytesRequested, dav_size_t bytesWasted) {
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  Entry &entry = *getEntry(endpoint);
+
+  entry.vectorReads++;
+  entry.rangesRequested += rangesRequested;
+  entry.rangesIssued += rangesIssued;
+  entry.bytesRequested += bytesRequested;
+  entry.bytesWasted += bytesWasted;
+}
+
+//------------------------------------------------------------------------------
+// Merge window derived from the given entry - fallback if unknown
+//------------------------------------------------------------------------------
+dav_size_t LinkEstimator::computeMergeWindow(const Entry &entry, dav_size_t fallback) {
+  if(entry.latency <= 0 || entry.bandwidth <= 0) {
+    return fallback;
+  }
+
+  double window = entry.latency * entry.bandwidth / 1000000.0;
+  window = std::max<double>(window, DAVIX_MIN_MERGE_WINDOW);
+  window = std::min<double>(window, DAVIX_MAX_MERGE_WINDOW);
+  return static_cast<dav_size_t>(window);
+}
+
+//------------------------------------------------------------------------------
+// Merge window to use towards the given endpoint
+//------------------------------------------------------------------------------
+dav_size_t LinkEstimator::getMergeWindow(const std::string &endpoint, dav_size_t fallback) const {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  std::shared_ptr<Entry> entry = _entries.find(endpoint);
+  if(!entry) {
+    return fallback;
+  }
+
+  return computeMergeWindow(*entry, fallback);
+}
+
+//------------------------------------------------------------------------------
+// Collect statistics of all known endpoints
+//------------------------------------------------------------------------------
+void LinkEstimator::collectStats(std::map<std::string, LinkStats> &stats) const {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  _entries.forEach([&](const std::string &endpoint, const std::shared_ptr<Entry> &entry) {
+    LinkStats &st = stats[endpoint];
+    st.latency = static_cast<dav_size_t>(entry->latency);
+    st.bandwidth = static_cast<dav_size_t>(entry->bandwidth);
+    st.merge_window = computeMergeWindow(*entry, DAVIX_DEFAULT_MERGE_WINDOW);
+    st.vector_reads = entry->vectorReads;
+    st.ranges_requested = entry->rangesRequested;
+    st.ranges_issued = entry->rangesIssued;
+    st.bytes_requested = entry->bytesRequested;
+    st.bytes_wasted = entry->bytesWasted;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Forget everything
+//------------------------------------------------------------------------------
+void LinkEstimator::clear() {
+  std::lock_guard<std::mutex> lock(_mtx);
+  _entries.clear();
+}
+
+}
@@ -0,0 +1,118 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_CORE_LINK_ESTIMATOR_HPP
+#define DAVIX_CORE_LINK_ESTIMATOR_HPP
+
+#include <davix_internal.hpp>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <libs/alibxx/containers/cache.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Keeps track of latency and throughput observed towards each endpoint,
+// as exponentially weighted moving averages. Owned by the Context.
+//
+// Used to size the merge window of vectored reads: two ranges separated by
+// a gap are worth merging as long as transferring the gap costs less than
+// an extra round trip, ie. as long as the gap is below the
+// bandwidth-delay product of the link.
+//------------------------------------------------------------------------------
+class LinkEstimator {
+public:
+  //----------------------------------------------------------------------------
+  // Constructor - keep track of at most maxEndpoints endpoints, the least
+  // recently used ones are forgotten first
+  //----------------------------------------------------------------------------
+  LinkEstimator(size_t maxEndpoints = 1024);
+
+  //----------------------------------------------------------------------------
+  // Record one request towards the given endpoint: latency is the time it
+  // took to receive the response headers, transferTime the time it took
+  // to read the body of the given size. Bodies too small to say anything
+  // meaningful about throughput only contribute to the latency estimate.
+  //----------------------------------------------------------------------------
+  void recordRequest(const std::string &endpoint, std::chrono::microseconds latency,
+    dav_size_t bytes, std::chrono::microseconds transferTime);
+
+  //----------------------------------------------------------------------------
+  // Record the outcome of planning one vectored read: how many ranges and
+  // bytes were asked for, how many ranges were actually requested after
+  // merging, and how many bytes of gap the merging added.
+  //----------------------------------------------------------------------------
+  void recordVectorRead(const std::string &endpoint, dav_size_t rangesRequested,
+    dav_size_t rangesIssued, dav_size_t bytesRequested, dav_size_t bytesWasted);
+
+  //----------------------------------------------------------------------------
+  // Merge window to use towards the given endpoint - fallback, if we don't
+  // know enough about the link yet.
+  //----------------------------------------------------------------------------
+  dav_size_t getMergeWindow(const std::string &endpoint, dav_size_t fallback) const;
+
+  //----------------------------------------------------------------------------
+  // Collect statistics of all known endpoints
+  //----------------------------------------------------------------------------
+  void collectStats(std::map<std::string, LinkStats> &stats) const;
+
+  //----------------------------------------------------------------------------
+  // Forget everything
+  //----------------------------------------------------------------------------
+  void clear();
+
+private:
+  struct Entry {
+    Entry() : latency(0), bandwidth(0), vectorReads(0), rangesRequested(0),
+      rangesIssued(0), bytesRequested(0), bytesWasted(0) {}
+
+    // microseconds, 0 if unknown
+    double latency;
+    // bytes per second, 0 if unknown
+    double bandwidth;
+
+    dav_size_t vectorReads;
+    dav_size_t rangesRequested;
+    dav_size_t rangesIssued;
+    dav_size_t bytesRequested;
+    dav_size_t bytesWasted;
+  };
+
+  //----------------------------------------------------------------------------
+  // Find or create the entry of the given endpoint - lock must be held
+  //----------------------------------------------------------------------------
+  std::shared_ptr<Entry> getEntry(const std::string &endpoint);
+
+  //----------------------------------------------------------------------------
+  // Merge window derived from the given entry - fallback if unknown
+  //----------------------------------------------------------------------------
+  static dav_size_t computeMergeWindow(const Entry &entry, dav_size_t fallback);
+
+  // guards the contents of the entries
+  mutable std::mutex _mtx;
+  mutable Cache<std::string, Entry> _entries;
+};
+
+}
+
+#endif
@@ -34,7 +34,22 @@ static const std::pair<std::string, std::string> makeKey(const std::string & met
     return std::make_pair(origin.getString(), mymethod);
 }
 
-RedirectionResolver::RedirectionResolver(bool act) : active(act), redirCache(256) {
+static std::string makeServer(const Uri & uri){
+    std::string server = uri.getProtocol() + "://" + uri.getHost();
+    if(uri.getPort() != 0)
+        server += ":" + std::to_string(uri.getPort());
+    return server;
+}
+
+// server and directory of the uri
+static std::string makeDirectoryKey(const Uri & uri){
+    const std::string & path = uri.getPath();
+    return makeServer(uri) + path.substr(0, path.rfind('/') + 1);
+}
+
+RedirectionResolver::RedirectionResolver(bool act, size_t maxEntries) : active(act),
+  redirCache(maxEntries, std::chrono::seconds(DAVIX_REDIRECT_CACHE_TTL), DAVIX_REDIRECT_CACHE_SHARDS),
+  hostCache(maxEntries, std::chrono::seconds(DAVIX_REDIRECT_CACHE_TTL), DAVIX_REDIRECT_CACHE_SHARDS) {
   DAVIX_SLOG(DAVIX_LOG_TRACE, DAVIX_LOG_CORE, "Redirection Session caching {}", (active?"ENABLED":"DISABLED"));
 }
 
@@ -46,6 +61,19 @@ void RedirectionResolver::addRedirection(const std::string & method, const Uri &
 
   DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_HTTP, "Add cached redirection <{} {} {}>", method.c_str(), origin.getString().c_str(), dest->getString().c_str());
   redirCache.insert(makeKey(method, origin), dest);
+
+  // only redirections to the same path, query and fragment on another server
+  // can be predicted - a token added by the origin is only good for one file.
+  // Not for directories where a prediction already failed either.
+  const std::string server = makeServer(*dest);
+  if(dest->getPath() == origin.getPath() && dest->getQuery() == origin.getQuery() &&
+     dest->getFragment() == origin.getFragment() && server != makeServer(origin)) {
+    const std::string key = makeDirectoryKey(origin);
+    std::shared_ptr<std::string> known = hostCache.find(key);
+    if(!known || (!known->empty() && *known != server)) {
+      hostCache.insert(key, std::make_shared<std::string>(server));
+    }
+  }
 }
 
 // try to find cached redirection, resolve a full chain
@@ -70,16 +98,58 @@ std::shared_ptr<Uri> RedirectionResolver::resolveSingle(const std::string & meth
   return res;
 }
 
+// predict a redirection from the ones of the same directory
+std::shared_ptr<Uri> RedirectionResolver::redirectionPredict(const std::string & method, const Uri & origin) {
+  if(!active || (method != "GET" && method != "HEAD")) {
+    return std::shared_ptr<Uri>();
+  }
+
+  std::shared_ptr<std::string> server = hostCache.find(makeDirectoryKey(origin));
+  if(!server || server->empty()) {
+    return std::shared_ptr<Uri>();
+  }
+
+  std::shared_ptr<Uri> res(new Uri(*server + origin.getPathAndQuery()));
+  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_HTTP, "Predicted redirection  <{} {} {}>", method, origin.getString(), res->getString());
+  return res;
+}
+
+// the origin answered a request predicted to be redirected by itself
+void RedirectionResolver::predictionFailed(const Uri & origin) {
+  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_HTTP, "Origin answered {} without redirecting, no longer predicting for its directory", origin.getString());
+  hostCache.insert(makeDirectoryKey(origin), std::make_shared<std::string>());
+}
+
 // check if redirections are active
 bool RedirectionResolver::isActive() const {
   return active;
 }
 
+void RedirectionResolver::setCacheSize(size_t maxEntries) {
+  redirCache.setMaxSize(maxEntries);
+  hostCache.setMaxSize(maxEntries);
+}
+
+size_t RedirectionResolver::getCacheSize() const {
+  return redirCache.getMaxSize();
+}
+
+size_t RedirectionResolver::hits() const {
+  return redirCache.hits();
+}
+
+size_t RedirectionResolver::misses() const {
+  return redirCache.misses();
+}
+
+size_t RedirectionResolver::evictions() const {
+  return redirCache.evictions();
+}
+
 void RedirectionResolver::redirectionClean(const std::string & method, const Uri & origin) {
-  std::shared_ptr<Uri> res = redirCache.find(makeKey(method, origin));
+  std::shared_ptr<Uri> res = redirCache.take(makeKey(method, origin));
   if(res.get() != NULL){
       DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_HTTP, "Delete Cached redirection for <{} {} {}>", method.c_str(), origin.getString().c_str(), res->getString().c_str());
-      redirCache.erase(makeKey(method, origin));
       redirectionClean(method, *res);
   }
 }
@@ -22,6 +22,7 @@
 #ifndef DAVIX_CORE_REDIRECTION_RESOLVER_HPP
 #define DAVIX_CORE_REDIRECTION_RESOLVER_HPP
 
+#include <davix_internal.hpp>
 #include <map>
 #include <mutex>
 #include <utils/davix_uri.hpp>
@@ -32,7 +33,7 @@ namespace Davix {
 
 class RedirectionResolver {
 public:
-  RedirectionResolver(bool active);
+  RedirectionResolver(bool active, size_t maxEntries = DAVIX_DEFAULT_REDIRECT_CACHE_SIZE);
 
   // add cached redirection
   void addRedirection(const std::string & method, const Uri & origin, std::shared_ptr<Uri> dest);
@@ -43,15 +44,46 @@ public:
   // check if redirections are active
   bool isActive() const;
 
+  // maximum number of cached redirections
+  void setCacheSize(size_t maxEntries);
+  size_t getCacheSize() const;
+
+  // cache statistics
+  size_t hits() const;
+  size_t misses() const;
+  size_t evictions() const;
+
   // clean redirections
   void redirectionClean(const std::string & method, const Uri & origin);
   void redirectionClean(const Uri & origin);
 
+  // predict where a request would be redirected to, from the redirections of
+  // other files of the same directory - NULL if unknown
+  std::shared_ptr<Uri> redirectionPredict(const std::string & method, const Uri & origin);
+
+  // a predicted redirection failed, and the origin then answered the request
+  // itself instead of redirecting it: stop predicting for this directory. When
+  // the origin redirects somewhere else, addRedirection learns the new server.
+  void predictionFailed(const Uri & origin);
+
 private:
+  typedef std::pair<std::string, std::string> Key;
+
+  // no std::hash for pairs - the origin is enough to spread entries over shards
+  struct OriginHash {
+    size_t operator()(const Key & key) const {
+      return std::hash<std::string>()(key.first);
+    }
+  };
+
   bool active;
 
   // redirection pool
-  Davix::Cache<std::pair<std::string, std::string>, Uri> redirCache;
+  Davix::Cache<Key, Uri, std::less<Key>, OriginHash> redirCache;
+
+  // servers requests are redirected to, by origin directory - an empty
+  // server once a prediction failed
+  Davix::Cache<std::string, std::string> hostCache;
 
   // resolve a single redirection chunk
   std::shared_ptr<Uri> resolveSingle(const std::string & method, const Uri & origin);
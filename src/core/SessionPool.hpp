@@ -22,19 +22,57 @@
 #ifndef DAVIX_CORE_SESSION_POOL_HPP
 #define DAVIX_CORE_SESSION_POOL_HPP
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <davix_internal_config.hpp>
+#include <davixcontext.hpp>
+
+//------------------------------------------------------------------------------
+// Per-endpoint session counters. Sessions keep a reference to the counters
+// of their endpoint, and decrement "live" once destroyed.
+//------------------------------------------------------------------------------
+struct SessionCounters {
+  SessionCounters() : live(0), created(0), reused(0), multiplexed(0) {}
+
+  std::atomic<uint64_t> live;
+  std::atomic<uint64_t> created;
+  std::atomic<uint64_t> reused;
+  std::atomic<uint64_t> multiplexed;
+};
 
 //------------------------------------------------------------------------------
 // Utility class to juggle sessions based on URI and parameters.
+//
+// Idle sessions are keyed by protocol, host and port, and spread across a
+// fixed number of shards, each with its own lock - concurrent requests
+// towards different hosts rarely contend.
+//
+// Reuse is LIFO: the session which went idle most recently is handed out
+// first, since it's the one most likely to still be alive on the server side.
+// Sessions idle for longer than the idle timeout are evicted, as are the
+// oldest ones once the per-host or global limit is reached.
 //------------------------------------------------------------------------------
 template<typename T>
 class SessionPool {
 public:
+  typedef std::chrono::steady_clock Clock;
+
   //----------------------------------------------------------------------------
   // Constructor
   //----------------------------------------------------------------------------
-  SessionPool() {}
+  SessionPool(size_t maxIdlePerHost = DAVIX_DEFAULT_SESSION_POOL_MAX_IDLE_PER_HOST,
+    size_t maxIdle = DAVIX_DEFAULT_SESSION_POOL_MAX_IDLE,
+    std::chrono::milliseconds idleTimeout = std::chrono::seconds(DAVIX_DEFAULT_SESSION_POOL_IDLE_TIMEOUT))
+  : _maxIdlePerHost(maxIdlePerHost), _maxIdle(maxIdle), _idleTimeout(idleTimeout),
+    _idle(0) {}
 
   //----------------------------------------------------------------------------
   // Destructor
@@ -44,43 +82,275 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  // Insert
+  // Insert an idle session. Returns false if the pool is configured to keep
+  // no idle sessions at all, in which case the item is dropped.
   //----------------------------------------------------------------------------
-  void insert(const std::string &key, T item) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _map.insert(std::pair<std::string, T>(key, std::move(item)));
+  bool insert(const std::string &key, T item) {
+    if(_maxIdlePerHost == 0 || _maxIdle == 0) {
+      return false;
+    }
+
+    const Clock::time_point now = Clock::now();
+    std::vector<T> evicted;
+    Shard &shard = getShard(key);
+
+    {
+      std::lock_guard<std::mutex> lock(shard.mtx);
+      expireShard(shard, now, evicted);
+
+      std::deque<Entry> &entries = shard.map[key];
+      while(entries.size() >= _maxIdlePerHost) {
+        evicted.emplace_back(std::move(entries.front().item));
+        entries.pop_front();
+        _idle--;
+      }
+
+      entries.emplace_back(Entry { std::move(item), now });
+      _idle++;
+    }
+
+    //--------------------------------------------------------------------------
+    // Over the global limit: evict the oldest idle sessions, without holding
+    // our own shard lock - avoids lock ordering issues.
+    //--------------------------------------------------------------------------
+    while(_idle > _maxIdle && evictOldest(evicted)) {}
+
+    return true;
   }
 
   //----------------------------------------------------------------------------
   // Clear
   //----------------------------------------------------------------------------
   void clear() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _map.clear();
+    for(size_t i = 0; i < kShards; i++) {
+      std::unordered_map<std::string, std::deque<Entry>> tmp;
+
+      {
+        std::lock_guard<std::mutex> lock(_shards[i].mtx);
+        tmp.swap(_shards[i].map);
+
+        for(auto it = tmp.begin(); it != tmp.end(); it++) {
+          _idle -= it->second.size();
+        }
+      }
+    }
   }
 
   //----------------------------------------------------------------------------
-  // Retrieve: Remove from the map and copy value onto caller variable.
+  // Retrieve: Remove the most recently inserted, non-expired value for the
+  // given key, and copy it onto caller variable.
   // Return true if value was found, returned and erased, and false otherwise.
   //----------------------------------------------------------------------------
   bool retrieve(const std::string &key, T& item) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    auto it = _map.find(key);
+    const Clock::time_point now = Clock::now();
+    std::vector<T> evicted;
+    Shard &shard = getShard(key);
 
-    if(it == _map.end()) {
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.map.find(key);
+
+    if(it == shard.map.end()) {
+      return false;
+    }
+
+    std::deque<Entry> &entries = it->second;
+    expireEntries(entries, now, evicted);
+
+    if(entries.empty()) {
+      shard.map.erase(it);
       return false;
     }
 
-    item = it->second;
-    _map.erase(it);
+    item = std::move(entries.back().item);
+    entries.pop_back();
+    _idle--;
+
+    auto counters = shard.counters.find(key);
+    if(counters != shard.counters.end()) {
+      counters->second->reused++;
+    }
+
+    if(entries.empty()) {
+      shard.map.erase(it);
+    }
+
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  // Number of idle sessions currently pooled, in total
+  //----------------------------------------------------------------------------
+  size_t size() const {
+    return _idle;
+  }
+
+  //----------------------------------------------------------------------------
+  // Number of idle sessions currently pooled for the given key
+  //----------------------------------------------------------------------------
+  size_t size(const std::string &key) const {
+    const Shard &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+
+    auto it = shard.map.find(key);
+    if(it == shard.map.end()) {
+      return 0;
+    }
+
+    return it->second.size();
+  }
+
+  //----------------------------------------------------------------------------
+  // Account for a brand-new session towards the given key. The caller
+  // attaches the returned counters to the session.
+  //----------------------------------------------------------------------------
+  std::shared_ptr<SessionCounters> registerSession(const std::string &key) {
+    Shard &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+
+    std::shared_ptr<SessionCounters> &counters = shard.counters[key];
+    if(!counters) {
+      counters = std::make_shared<SessionCounters>();
+    }
+
+    counters->created++;
+    counters->live++;
+    return counters;
+  }
+
+  //----------------------------------------------------------------------------
+  // Add the statistics of every key seen so far onto the given map
+  //----------------------------------------------------------------------------
+  void collectStats(std::map<std::string, Davix::SessionPoolStats> &stats) const {
+    for(size_t i = 0; i < kShards; i++) {
+      std::lock_guard<std::mutex> lock(_shards[i].mtx);
+
+      for(auto it = _shards[i].counters.begin(); it != _shards[i].counters.end(); it++) {
+        Davix::SessionPoolStats &out = stats[it->first];
+        out.live += it->second->live;
+        out.created += it->second->created;
+        out.reused += it->second->reused;
+        out.multiplexed += it->second->multiplexed;
+      }
+
+      for(auto it = _shards[i].map.begin(); it != _shards[i].map.end(); it++) {
+        stats[it->first].idle += it->second.size();
+      }
+    }
+  }
+
 private:
-  std::multimap<std::string, T> _map;
-  std::mutex _mutex;
+  static const size_t kShards = 16;
+
+  struct Entry {
+    T item;
+    Clock::time_point lastUsed;
+  };
+
+  struct Shard {
+    mutable std::mutex mtx;
+    std::unordered_map<std::string, std::deque<Entry>> map;
+    std::unordered_map<std::string, std::shared_ptr<SessionCounters>> counters;
+  };
+
+  size_t shardIndex(const std::string &key) const {
+    return std::hash<std::string>()(key) % kShards;
+  }
+
+  Shard& getShard(const std::string &key) {
+    return _shards[shardIndex(key)];
+  }
+
+  const Shard& getShard(const std::string &key) const {
+    return _shards[shardIndex(key)];
+  }
+
+  //----------------------------------------------------------------------------
+  // Drop expired entries - entries are ordered by insertion time, so expired
+  // ones are all at the front. Shard lock must be held.
+  //----------------------------------------------------------------------------
+  void expireEntries(std::deque<Entry> &entries, Clock::time_point now, std::vector<T> &evicted) {
+    while(!entries.empty() && now - entries.front().lastUsed >= _idleTimeout) {
+      evicted.emplace_back(std::move(entries.front().item));
+      entries.pop_front();
+      _idle--;
+    }
+  }
+
+  void expireShard(Shard &shard, Clock::time_point now, std::vector<T> &evicted) {
+    for(auto it = shard.map.begin(); it != shard.map.end(); ) {
+      expireEntries(it->second, now, evicted);
+
+      if(it->second.empty()) {
+        it = shard.map.erase(it);
+      }
+      else {
+        it++;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Find the oldest entry of a shard. Shard lock must be held.
+  //----------------------------------------------------------------------------
+  typename std::unordered_map<std::string, std::deque<Entry>>::iterator findOldest(Shard &shard) {
+    auto oldest = shard.map.end();
+
+    for(auto it = shard.map.begin(); it != shard.map.end(); it++) {
+      if(!it->second.empty() && (oldest == shard.map.end() ||
+         it->second.front().lastUsed < oldest->second.front().lastUsed)) {
+        oldest = it;
+      }
+    }
+
+    return oldest;
+  }
+
+  //----------------------------------------------------------------------------
+  // Evict the oldest idle entry across all shards. Shards are locked one at
+  // a time, so the choice is approximate under concurrent inserts.
+  // Returns false if there was nothing to evict.
+  //----------------------------------------------------------------------------
+  bool evictOldest(std::vector<T> &evicted) {
+    Shard *victim = NULL;
+    Clock::time_point victimTime;
+
+    for(size_t i = 0; i < kShards; i++) {
+      std::lock_guard<std::mutex> lock(_shards[i].mtx);
+      auto it = findOldest(_shards[i]);
+
+      if(it != _shards[i].map.end() && (!victim || it->second.front().lastUsed < victimTime)) {
+        victim = &_shards[i];
+        victimTime = it->second.front().lastUsed;
+      }
+    }
+
+    if(!victim) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(victim->mtx);
+    auto oldest = findOldest(*victim);
+
+    if(oldest != victim->map.end()) {
+      evicted.emplace_back(std::move(oldest->second.front().item));
+      oldest->second.pop_front();
+      _idle--;
+
+      if(oldest->second.empty()) {
+        victim->map.erase(oldest);
+      }
+    }
+
+    return true;
+  }
+
+  const size_t _maxIdlePerHost;
+  const size_t _maxIdle;
+  const std::chrono::milliseconds _idleTimeout;
+
+  Shard _shards[kShards];
+  std::atomic<size_t> _idle;
 
 };
 
 #endif
-
@@ -0,0 +1,180 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "StatCache.hpp"
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StatCache::StatCache(unsigned int ttl, unsigned int negativeTtl)
+: _ttl(ttl), _negativeTtl(negativeTtl),
+  _entries(DAVIX_STAT_CACHE_SIZE, Cache<std::string, Entry>::Duration::zero(), DAVIX_STAT_CACHE_SHARDS) {}
+
+//------------------------------------------------------------------------------
+// Change the TTLs
+//------------------------------------------------------------------------------
+void StatCache::setTTL(unsigned int ttl, unsigned int negativeTtl) {
+  _ttl = ttl;
+  _negativeTtl = negativeTtl;
+
+  if(ttl == 0) {
+    _entries.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the TTLs
+//------------------------------------------------------------------------------
+unsigned int StatCache::getTTL() const {
+  return _ttl;
+}
+
+unsigned int StatCache::getNegativeTTL() const {
+  return _negativeTtl;
+}
+
+//------------------------------------------------------------------------------
+// Server part of a key
+//------------------------------------------------------------------------------
+static std::string makeServer(const Uri &uri) {
+  std::string server = uri.getProtocol() + "://" + uri.getHost();
+  if(uri.getPort() != 0) {
+    server += ":" + std::to_string(uri.getPort());
+  }
+  return server;
+}
+
+//------------------------------------------------------------------------------
+// Path without its trailing slashes
+//------------------------------------------------------------------------------
+static std::string trimPath(const std::string &path) {
+  std::string::size_type end = path.find_last_not_of('/');
+  return (end == std::string::npos) ? std::string("/") : path.substr(0, end + 1);
+}
+
+//------------------------------------------------------------------------------
+// Build the key of a URL
+//------------------------------------------------------------------------------
+std::string StatCache::makeKey(const Uri &uri) {
+  std::string key = makeServer(uri) + trimPath(uri.getPath());
+  if(!uri.getQuery().empty()) {
+    key += "?" + uri.getQuery();
+  }
+  return key;
+}
+
+//------------------------------------------------------------------------------
+// Look up the metadata of the given URL
+//------------------------------------------------------------------------------
+StatCache::Lookup StatCache::lookup(const Uri &uri, StatInfo &info) {
+  if(_ttl == 0) {
+    return Miss;
+  }
+
+  std::shared_ptr<Entry> entry = _entries.find(makeKey(uri));
+  if(!entry) {
+    return Miss;
+  }
+
+  if(!entry->exists) {
+    return NotFound;
+  }
+
+  info = entry->info;
+  return Found;
+}
+
+//------------------------------------------------------------------------------
+// Store the metadata of the given URL
+//------------------------------------------------------------------------------
+void StatCache::insert(const Uri &uri, const StatInfo &info) {
+  const unsigned int ttl = _ttl;
+  if(ttl == 0) {
+    return;
+  }
+
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->exists = true;
+  entry->info = info;
+  _entries.insert(makeKey(uri), entry, std::chrono::seconds(ttl));
+}
+
+//------------------------------------------------------------------------------
+// Store the metadata of an entry of the given directory
+//------------------------------------------------------------------------------
+void StatCache::insertChild(const Uri &directory, const std::string &name, const StatInfo &info) {
+  if(_ttl == 0 || name.empty() || name == "." || name == ".." || name.find('/') != std::string::npos) {
+    return;
+  }
+
+  insert(Uri(Uri::join(makeServer(directory) + trimPath(directory.getPath()), name)), info);
+}
+
+//------------------------------------------------------------------------------
+// Remember the given URL as missing
+//------------------------------------------------------------------------------
+void StatCache::insertNotFound(const Uri &uri) {
+  const unsigned int ttl = _negativeTtl;
+  if(_ttl == 0 || ttl == 0) {
+    return;
+  }
+
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->exists = false;
+  _entries.insert(makeKey(uri), entry, std::chrono::seconds(ttl));
+}
+
+//------------------------------------------------------------------------------
+// Drop the metadata of the given URL, and of its parent directory
+//------------------------------------------------------------------------------
+void StatCache::invalidate(const Uri &uri) {
+  _entries.erase(makeKey(uri));
+
+  const std::string path = trimPath(uri.getPath());
+  if(path != "/") {
+    _entries.erase(makeServer(uri) + trimPath(path.substr(0, path.rfind('/') + 1)));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop everything
+//------------------------------------------------------------------------------
+void StatCache::clear() {
+  _entries.clear();
+}
+
+//------------------------------------------------------------------------------
+// Statistics
+//------------------------------------------------------------------------------
+size_t StatCache::size() const {
+  return _entries.getSize();
+}
+
+size_t StatCache::hits() const {
+  return _entries.hits();
+}
+
+size_t StatCache::misses() const {
+  return _entries.misses();
+}
+
+}
@@ -0,0 +1,123 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_CORE_STAT_CACHE_HPP
+#define DAVIX_CORE_STAT_CACHE_HPP
+
+#include <davix_internal.hpp>
+#include <libs/alibxx/containers/cache.hpp>
+#include <atomic>
+#include <string>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// In-memory cache of file and directory metadata, shared by every file of a
+// Context. Owned by the Context, disabled as long as its TTL is 0.
+//
+// Entries are keyed by URL, and used for the TTL given when they were stored.
+// Resources found missing may be remembered as well, for their own, usually
+// shorter, TTL, and the entries returned by directory listings are stored as
+// if each had been stat'ed. Entries are evicted in LRU order beyond DAVIX_STAT_CACHE_SIZE.
+//------------------------------------------------------------------------------
+class StatCache {
+public:
+  enum Lookup {
+    Miss,
+    Found,
+    NotFound
+  };
+
+  //----------------------------------------------------------------------------
+  // Constructor - TTLs in seconds, 0 disables the cache, or the caching of
+  // missing resources
+  //----------------------------------------------------------------------------
+  StatCache(unsigned int ttl = 0, unsigned int negativeTtl = 0);
+
+  //----------------------------------------------------------------------------
+  // Change the TTLs - entries already cached keep theirs
+  //----------------------------------------------------------------------------
+  void setTTL(unsigned int ttl, unsigned int negativeTtl);
+
+  //----------------------------------------------------------------------------
+  // Get the TTLs
+  //----------------------------------------------------------------------------
+  unsigned int getTTL() const;
+  unsigned int getNegativeTTL() const;
+
+  //----------------------------------------------------------------------------
+  // Build the key of a URL - a trailing slash or a fragment make no difference
+  //----------------------------------------------------------------------------
+  static std::string makeKey(const Uri &uri);
+
+  //----------------------------------------------------------------------------
+  // Look up the metadata of the given URL, filling info when Found
+  //----------------------------------------------------------------------------
+  Lookup lookup(const Uri &uri, StatInfo &info);
+
+  //----------------------------------------------------------------------------
+  // Store the metadata of the given URL
+  //----------------------------------------------------------------------------
+  void insert(const Uri &uri, const StatInfo &info);
+
+  //----------------------------------------------------------------------------
+  // Store the metadata of an entry of the given directory, as returned by a
+  // listing - names which are not plain file names are ignored
+  //----------------------------------------------------------------------------
+  void insertChild(const Uri &directory, const std::string &name, const StatInfo &info);
+
+  //----------------------------------------------------------------------------
+  // Remember the given URL as missing
+  //----------------------------------------------------------------------------
+  void insertNotFound(const Uri &uri);
+
+  //----------------------------------------------------------------------------
+  // Drop the metadata of the given URL, and of its parent directory, whose
+  // size or modification time may have changed as well
+  //----------------------------------------------------------------------------
+  void invalidate(const Uri &uri);
+
+  //----------------------------------------------------------------------------
+  // Drop everything
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  // Statistics: entries cached, lookups answered from the cache, and lookups
+  // which were not
+  //----------------------------------------------------------------------------
+  size_t size() const;
+  size_t hits() const;
+  size_t misses() const;
+
+private:
+  struct Entry {
+    bool exists;
+    StatInfo info;
+  };
+
+  std::atomic<unsigned int> _ttl;
+  std::atomic<unsigned int> _negativeTtl;
+  Cache<std::string, Entry> _entries;
+};
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Constructor - threads are spawned lazily, on first submission
+//------------------------------------------------------------------------------
+WorkerPool::WorkerPool(size_t nthreads) : _nthreads(nthreads == 0 ? 1 : nthreads),
+  _idle(0), _shutdown(false) {}
+
+//------------------------------------------------------------------------------
+// Destructor - runs all pending tasks to completion, then joins
+//------------------------------------------------------------------------------
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _shutdown = true;
+  }
+
+  _cv.notify_all();
+
+  for(size_t i = 0; i < _threads.size(); i++) {
+    _threads[i].join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Queue a task for execution
+//------------------------------------------------------------------------------
+void WorkerPool::submit(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _tasks.emplace_back(std::move(task));
+
+    if(_idle < _tasks.size() && _threads.size() < _nthreads) {
+      _threads.emplace_back(&WorkerPool::work, this);
+    }
+  }
+
+  _cv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Run the given function on the pool, deliver its result to the callback
+//------------------------------------------------------------------------------
+void WorkerPool::async(std::function<dav_ssize_t()> fn, const AsyncCompletionCallback &callback) {
+  submit([fn, callback]() {
+    DavixError* err = NULL;
+    dav_ssize_t result = -1;
+
+    TRY_DAVIX{
+      result = fn();
+    }CATCH_DAVIX(&err)
+
+    if(err != NULL) {
+      result = -1;
+    }
+
+    if(callback) {
+      callback(result, err);
+    }
+
+    DavixError::clearError(&err);
+  });
+}
+
+//------------------------------------------------------------------------------
+// State shared between the caller of parallelFor and its helpers - helpers
+// may outlive the call, and must only touch fn once they've claimed an index.
+//------------------------------------------------------------------------------
+struct ParallelForState {
+  ParallelForState(size_t c, const std::function<void(size_t)> &f)
+  : count(c), fn(f), next(0), active(0) {}
+
+  const size_t count;
+  std::function<void(size_t)> fn;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  size_t next;
+  size_t active;
+  std::exception_ptr exc;
+};
+
+static void runParallelFor(std::shared_ptr<ParallelForState> state) {
+  while(true) {
+    size_t index;
+
+    {
+      std::lock_guard<std::mutex> lock(state->mtx);
+      if(state->next >= state->count || state->exc) {
+        return;
+      }
+
+      index = state->next++;
+      state->active++;
+    }
+
+    std::exception_ptr exc;
+    try {
+      state->fn(index);
+    }
+    catch(...) {
+      exc = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(state->mtx);
+      state->active--;
+      if(exc && !state->exc) {
+        state->exc = exc;
+      }
+    }
+
+    state->cv.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Call fn for every index in [0, count), up to `parallelism` at a time
+//------------------------------------------------------------------------------
+void WorkerPool::parallelFor(size_t count, size_t parallelism, const std::function<void(size_t)> &fn) {
+  std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>(count, fn);
+
+  // more helpers than threads would only sit in the queue
+  size_t helpers = std::min(std::min(parallelism, count), _nthreads + 1);
+  for(size_t i = 1; i < helpers; i++) {
+    submit([state]() { runParallelFor(state); });
+  }
+
+  runParallelFor(state);
+
+  std::unique_lock<std::mutex> lock(state->mtx);
+  state->cv.wait(lock, [&] { return state->active == 0; });
+
+  if(state->exc) {
+    std::rethrow_exception(state->exc);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Number of threads in the pool
+//------------------------------------------------------------------------------
+size_t WorkerPool::size() const {
+  return _nthreads;
+}
+
+//------------------------------------------------------------------------------
+// Default pool size
+//------------------------------------------------------------------------------
+size_t WorkerPool::defaultSize() {
+  const char* env = getenv("DAVIX_WORKER_THREADS");
+  if(env != NULL && atoi(env) > 0) {
+    return std::min<size_t>(atoi(env), DAVIX_MAX_WORKER_THREADS);
+  }
+
+  return DAVIX_DEFAULT_WORKER_THREADS;
+}
+
+//------------------------------------------------------------------------------
+// Worker thread main loop
+//------------------------------------------------------------------------------
+void WorkerPool::work() {
+  while(true) {
+    Task task;
+
+    {
+      std::unique_lock<std::mutex> lock(_mtx);
+      _idle++;
+      _cv.wait(lock, [&] { return _shutdown || !_tasks.empty(); });
+      _idle--;
+
+      if(_tasks.empty()) {
+        return;
+      }
+
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+}
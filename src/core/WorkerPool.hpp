@@ -0,0 +1,141 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_CORE_WORKER_POOL_HPP
+#define DAVIX_CORE_WORKER_POOL_HPP
+
+#include <davix_internal.hpp>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Fixed-size pool of threads executing tasks in FIFO order. Owned by the
+// Context, used to run blocking operations on behalf of asynchronous API
+// callers, so that the number of threads stays bounded no matter how many
+// operations are outstanding.
+//------------------------------------------------------------------------------
+class WorkerPool {
+public:
+  typedef std::function<void()> Task;
+
+  //----------------------------------------------------------------------------
+  // Constructor - threads are spawned lazily, on first submission
+  //----------------------------------------------------------------------------
+  WorkerPool(size_t nthreads);
+
+  //----------------------------------------------------------------------------
+  // Destructor - runs all pending tasks to completion, then joins
+  //----------------------------------------------------------------------------
+  ~WorkerPool();
+
+  //----------------------------------------------------------------------------
+  // No copying, no moving.
+  //----------------------------------------------------------------------------
+  WorkerPool(const WorkerPool& other) = delete;
+  WorkerPool& operator=(const WorkerPool& other) = delete;
+
+  //----------------------------------------------------------------------------
+  // Queue a task for execution. Tasks must not throw.
+  //----------------------------------------------------------------------------
+  void submit(Task task);
+
+  //----------------------------------------------------------------------------
+  // Run the given function on the pool, deliver its result or the exception
+  // it threw through a future.
+  //----------------------------------------------------------------------------
+  template<typename T>
+  std::future<T> async(std::function<T()> fn) {
+    std::shared_ptr<std::promise<T> > promise = std::make_shared<std::promise<T> >();
+    std::future<T> future = promise->get_future();
+
+    submit([promise, fn]() {
+      try {
+        promise->set_value(fn());
+      }
+      catch(...) {
+        promise->set_exception(std::current_exception());
+      }
+    });
+
+    return future;
+  }
+
+  //----------------------------------------------------------------------------
+  // Run the given function on the pool, deliver its result to the callback.
+  // An exception thrown by the function is converted into a DavixError,
+  // and the callback receives -1.
+  //----------------------------------------------------------------------------
+  void async(std::function<dav_ssize_t()> fn, const AsyncCompletionCallback &callback);
+
+  //----------------------------------------------------------------------------
+  // Call fn(0) ... fn(count-1), with up to `parallelism` calls in flight:
+  // the calling thread plus parallelism-1 helper tasks pick the next index
+  // as soon as they're done with the previous one. Blocks until every
+  // picked index has been processed. Parallelism is capped to the pool
+  // size plus one, the calling thread.
+  //
+  // The calling thread takes part, so this can never deadlock, even when
+  // called from within a pool task while the pool is saturated - helpers
+  // which start late simply find nothing left to do.
+  //
+  // The first exception thrown by fn stops the dispatch of further indices,
+  // and is rethrown to the caller.
+  //----------------------------------------------------------------------------
+  void parallelFor(size_t count, size_t parallelism, const std::function<void(size_t)> &fn);
+
+  //----------------------------------------------------------------------------
+  // Number of threads in the pool
+  //----------------------------------------------------------------------------
+  size_t size() const;
+
+  //----------------------------------------------------------------------------
+  // Default pool size - DAVIX_WORKER_THREADS if set, capped to
+  // DAVIX_MAX_WORKER_THREADS, DAVIX_DEFAULT_WORKER_THREADS otherwise
+  //----------------------------------------------------------------------------
+  static size_t defaultSize();
+
+private:
+  //----------------------------------------------------------------------------
+  // Worker thread main loop
+  //----------------------------------------------------------------------------
+  void work();
+
+  size_t _nthreads;
+
+  std::mutex _mtx;
+  std::condition_variable _cv;
+  std::deque<Task> _tasks;
+  size_t _idle;
+  bool _shutdown;
+
+  std::vector<std::thread> _threads;
+};
+
+}
+
+#endif
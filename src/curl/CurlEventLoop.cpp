@@ -0,0 +1,251 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "CurlEventLoop.hpp"
+#include <utils/davix_logger_internal.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Upper bound on how long the I/O thread sleeps in curl_multi_poll - curl
+// may need to act on internal timers even when no socket is ready.
+//------------------------------------------------------------------------------
+static const int kPollTimeoutMs = 1000;
+
+static std::once_flag curl_once;
+
+static void init_curl() {
+  curl_global_init(CURL_GLOBAL_ALL);
+}
+
+//------------------------------------------------------------------------------
+// Constructor - spawns the I/O thread
+//------------------------------------------------------------------------------
+CurlEventLoop::CurlEventLoop() : _enqueued_seq(0), _executed_seq(0), _shutdown(false) {
+  std::call_once(curl_once, init_curl);
+
+  _multi = curl_multi_init();
+  curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+  _share = curl_share_init();
+  curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, &CurlEventLoop::lockShare);
+  curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, &CurlEventLoop::unlockShare);
+  curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+  curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+  _thread = std::thread(&CurlEventLoop::run, this);
+}
+
+//------------------------------------------------------------------------------
+// Destructor - stops the I/O thread, detaches any transfers still running
+//------------------------------------------------------------------------------
+CurlEventLoop::~CurlEventLoop() {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _shutdown = true;
+  }
+
+  // wake up anyone blocked in remove()
+  _cv.notify_all();
+  curl_multi_wakeup(_multi);
+  _thread.join();
+
+  for(auto it = _active.begin(); it != _active.end(); it++) {
+    curl_multi_remove_handle(_multi, it->first);
+  }
+
+  _active.clear();
+  curl_multi_cleanup(_multi);
+  curl_share_cleanup(_share);
+}
+
+//------------------------------------------------------------------------------
+// Queue a command for the I/O thread, return its sequence number
+//------------------------------------------------------------------------------
+uint64_t CurlEventLoop::enqueue(Command &&cmd) {
+  uint64_t seq;
+
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _commands.emplace_back(std::move(cmd));
+    seq = ++_enqueued_seq;
+  }
+
+  curl_multi_wakeup(_multi);
+  return seq;
+}
+
+//------------------------------------------------------------------------------
+// Start driving the given easy handle
+//------------------------------------------------------------------------------
+void CurlEventLoop::add(CURL *handle, CompletionCallback callback) {
+  curl_easy_setopt(handle, CURLOPT_SHARE, _share);
+  enqueue(Command { Command::kAdd, handle, std::move(callback) });
+}
+
+//------------------------------------------------------------------------------
+// Stop driving the given easy handle, block until the I/O thread lets go
+//------------------------------------------------------------------------------
+void CurlEventLoop::remove(CURL *handle) {
+  Command cmd { Command::kRemove, handle, CompletionCallback() };
+
+  if(std::this_thread::get_id() == _thread.get_id()) {
+    execute(cmd);
+    return;
+  }
+
+  uint64_t seq = enqueue(std::move(cmd));
+
+  std::unique_lock<std::mutex> lock(_mtx);
+  _cv.wait(lock, [&] { return _executed_seq >= seq || _shutdown; });
+}
+
+//------------------------------------------------------------------------------
+// Resume a paused transfer
+//------------------------------------------------------------------------------
+void CurlEventLoop::unpause(CURL *handle) {
+  enqueue(Command { Command::kUnpause, handle, CompletionCallback() });
+}
+
+//------------------------------------------------------------------------------
+// Execute a single command - I/O thread only
+//------------------------------------------------------------------------------
+void CurlEventLoop::execute(Command &cmd) {
+  switch(cmd.type) {
+    case Command::kAdd: {
+      CURLMcode rc = curl_multi_add_handle(_multi, cmd.handle);
+
+      if(rc != CURLM_OK) {
+        DAVIX_SLOG(DAVIX_LOG_WARNING, DAVIX_LOG_HTTP, "Unable to add easy handle to multi handle: {}", curl_multi_strerror(rc));
+        cmd.callback(CURLE_FAILED_INIT);
+        return;
+      }
+
+      _active[cmd.handle] = std::move(cmd.callback);
+      return;
+    }
+    case Command::kRemove: {
+      auto it = _active.find(cmd.handle);
+      if(it != _active.end()) {
+        curl_multi_remove_handle(_multi, cmd.handle);
+        _active.erase(it);
+      }
+
+      return;
+    }
+    case Command::kUnpause: {
+      if(_active.find(cmd.handle) != _active.end()) {
+        curl_easy_pause(cmd.handle, CURLPAUSE_CONT);
+      }
+
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drain command queue - I/O thread only. Returns false on shutdown.
+//------------------------------------------------------------------------------
+bool CurlEventLoop::processCommands() {
+  std::deque<Command> pending;
+  uint64_t seq;
+
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if(_shutdown) {
+      return false;
+    }
+
+    pending.swap(_commands);
+    seq = _enqueued_seq;
+  }
+
+  for(auto it = pending.begin(); it != pending.end(); it++) {
+    execute(*it);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _executed_seq = seq;
+  }
+
+  _cv.notify_all();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Dispatch completion callbacks of finished transfers - I/O thread only
+//------------------------------------------------------------------------------
+void CurlEventLoop::processCompletions() {
+  CURLMsg *msg;
+  int msgs_left = 0;
+
+  while((msg = curl_multi_info_read(_multi, &msgs_left))) {
+    if(msg->msg != CURLMSG_DONE) {
+      continue;
+    }
+
+    //--------------------------------------------------------------------------
+    // msg is invalidated by curl_multi_remove_handle, copy what we need
+    //--------------------------------------------------------------------------
+    CURL *handle = msg->easy_handle;
+    CURLcode result = msg->data.result;
+
+    auto it = _active.find(handle);
+    if(it == _active.end()) {
+      continue;
+    }
+
+    CompletionCallback callback = std::move(it->second);
+    _active.erase(it);
+    curl_multi_remove_handle(_multi, handle);
+
+    callback(result);
+  }
+}
+
+//------------------------------------------------------------------------------
+// I/O thread main loop
+//------------------------------------------------------------------------------
+void CurlEventLoop::run() {
+  while(processCommands()) {
+    int still_running = 0;
+    curl_multi_perform(_multi, &still_running);
+    processCompletions();
+
+    int numfds = 0;
+    curl_multi_poll(_multi, NULL, 0, kPollTimeoutMs, &numfds);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Locking callbacks for the share handle
+//------------------------------------------------------------------------------
+void CurlEventLoop::lockShare(CURL *, curl_lock_data data, curl_lock_access, void *userptr) {
+  CurlEventLoop *loop = static_cast<CurlEventLoop*>(userptr);
+  loop->_share_mtx[data].lock();
+}
+
+void CurlEventLoop::unlockShare(CURL *, curl_lock_data data, void *userptr) {
+  CurlEventLoop *loop = static_cast<CurlEventLoop*>(userptr);
+  loop->_share_mtx[data].unlock();
+}
+
+}
@@ -0,0 +1,156 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_CURL_EVENT_LOOP_HPP
+#define DAVIX_CURL_EVENT_LOOP_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <curl/curl.h>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Drives all in-flight curl transfers of a single CurlSessionFactory through
+// one shared multi handle, from a dedicated I/O thread.
+//
+// Easy handles are configured by the calling thread, then handed over through
+// add(). From that point on, all curl callbacks of the handle (header, write,
+// read, debug) run on the I/O thread, until either the transfer completes
+// (the completion callback fires) or remove() returns.
+//
+// Since all transfers share the multi handle, they also share its connection
+// cache and DNS cache. TLS sessions are shared through a share handle. HTTP/2
+// transfers towards the same endpoint are multiplexed over one connection.
+//------------------------------------------------------------------------------
+class CurlEventLoop {
+public:
+  //----------------------------------------------------------------------------
+  // Called on the I/O thread once a transfer is done, with its result code.
+  // The handle has already been detached from the multi handle at this point.
+  //----------------------------------------------------------------------------
+  typedef std::function<void(CURLcode)> CompletionCallback;
+
+  //----------------------------------------------------------------------------
+  // Constructor - spawns the I/O thread
+  //----------------------------------------------------------------------------
+  CurlEventLoop();
+
+  //----------------------------------------------------------------------------
+  // Destructor - stops the I/O thread, detaches any transfers still running
+  //----------------------------------------------------------------------------
+  ~CurlEventLoop();
+
+  //----------------------------------------------------------------------------
+  // No copying, no moving.
+  //----------------------------------------------------------------------------
+  CurlEventLoop(const CurlEventLoop& other) = delete;
+  CurlEventLoop& operator=(const CurlEventLoop& other) = delete;
+
+  //----------------------------------------------------------------------------
+  // Start driving the given easy handle. Returns immediately, the handle
+  // must not be touched by the caller until it's been removed, or the
+  // completion callback has fired.
+  //----------------------------------------------------------------------------
+  void add(CURL *handle, CompletionCallback callback);
+
+  //----------------------------------------------------------------------------
+  // Stop driving the given easy handle. Blocks until the I/O thread has let
+  // go of it: once this returns, no more callbacks will be invoked for the
+  // handle. Removing a handle which is not active is a no-op.
+  //----------------------------------------------------------------------------
+  void remove(CURL *handle);
+
+  //----------------------------------------------------------------------------
+  // Resume a transfer paused from within its write callback. Returns
+  // immediately.
+  //----------------------------------------------------------------------------
+  void unpause(CURL *handle);
+
+private:
+  struct Command {
+    enum Type { kAdd, kRemove, kUnpause };
+
+    Type type;
+    CURL *handle;
+    CompletionCallback callback;
+  };
+
+  //----------------------------------------------------------------------------
+  // Queue a command for the I/O thread, return its sequence number
+  //----------------------------------------------------------------------------
+  uint64_t enqueue(Command &&cmd);
+
+  //----------------------------------------------------------------------------
+  // Execute a single command - I/O thread only
+  //----------------------------------------------------------------------------
+  void execute(Command &cmd);
+
+  //----------------------------------------------------------------------------
+  // Drain command queue - I/O thread only. Returns false on shutdown.
+  //----------------------------------------------------------------------------
+  bool processCommands();
+
+  //----------------------------------------------------------------------------
+  // Dispatch completion callbacks of finished transfers - I/O thread only
+  //----------------------------------------------------------------------------
+  void processCompletions();
+
+  //----------------------------------------------------------------------------
+  // I/O thread main loop
+  //----------------------------------------------------------------------------
+  void run();
+
+  //----------------------------------------------------------------------------
+  // Locking callbacks for the share handle
+  //----------------------------------------------------------------------------
+  static void lockShare(CURL *, curl_lock_data data, curl_lock_access, void *userptr);
+  static void unlockShare(CURL *, curl_lock_data data, void *userptr);
+
+  CURLM *_multi;
+  CURLSH *_share;
+  std::mutex _share_mtx[CURL_LOCK_DATA_LAST];
+
+  //----------------------------------------------------------------------------
+  // Command queue, shared between I/O thread and callers
+  //----------------------------------------------------------------------------
+  std::mutex _mtx;
+  std::condition_variable _cv;
+  std::deque<Command> _commands;
+  uint64_t _enqueued_seq;
+  uint64_t _executed_seq;
+  bool _shutdown;
+
+  //----------------------------------------------------------------------------
+  // Active transfers - I/O thread only
+  //----------------------------------------------------------------------------
+  std::map<CURL*, CompletionCallback> _active;
+
+  std::thread _thread;
+};
+
+}
+
+#endif
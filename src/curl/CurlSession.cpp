@@ -20,20 +20,14 @@
 */
 
 #include "CurlSession.hpp"
+#include "CurlSessionFactory.hpp"
 #include <curl/curl.h>
 #include <params/davixrequestparams.hpp>
-#include <mutex>
 
 #define DBG(message) std::cerr << __FILE__ << ":" << __LINE__ << " -- " << #message << " = " << message << std::endl;
 
 namespace Davix {
 
-static std::once_flag curl_once;
-
-void init_curl() {
-  curl_global_init(CURL_GLOBAL_ALL);
-}
-
 //------------------------------------------------------------------------------
 // CurlHandle: Destructor
 //------------------------------------------------------------------------------
@@ -42,43 +36,48 @@ CurlHandle::~CurlHandle() {
     curl_easy_cleanup(handle);
   }
 
-  if(mhandle) {
-    curl_multi_cleanup(mhandle);
+  if(counters) {
+    counters->live--;
   }
 }
 
 //------------------------------------------------------------------------------
 // CurlHandle: Constructor
 //------------------------------------------------------------------------------
-CurlHandle::CurlHandle(const std::string &k, CURLM *mh, CURL *h) : key(k), mhandle(mh), handle(h) {
-  curl_multi_add_handle(mhandle, handle);
-}
+CurlHandle::CurlHandle(const std::string &k, CURL *h) : key(k), handle(h) {}
 
 //------------------------------------------------------------------------------
-// Renew curl handle
+// Renew curl handle - resets all options, but keeps the handle's caches
+// (DNS, TLS session ids, connection state) around for the next transfer.
 //------------------------------------------------------------------------------
 void CurlHandle::renewHandle() {
   if(handle) {
-    curl_easy_cleanup(handle);
+    curl_easy_reset(handle);
+  }
+  else {
+    handle = curl_easy_init();
   }
-
-  handle = curl_easy_init();
-  curl_multi_add_handle(mhandle, handle);
 }
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 CurlSession::CurlSession(CurlSessionFactory &f, CurlHandlePtr h, const Uri & uri, const RequestParams & p, Status &st)
-: _factory(f), _handle(h) {
+: _factory(f), _handle(h), _session_recycling(f.getSessionCaching() && p.getKeepAlive()),
+  _transfer_succeeded(false) {
 
   configureSession(p, st);
 }
 
 //------------------------------------------------------------------------------
-// Destructor
+// Destructor - a handle whose transfer failed or was cut short might sit
+// on a broken connection, it's cleaned up instead of recycled
 //------------------------------------------------------------------------------
-CurlSession::~CurlSession() {}
+CurlSession::~CurlSession() {
+  if(_handle && _session_recycling && _transfer_succeeded) {
+    _factory.storeCurlHandle(std::move(_handle));
+  }
+}
 
 //------------------------------------------------------------------------------
 // Configure session
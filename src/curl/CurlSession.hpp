@@ -24,9 +24,9 @@
 
 #include <memory>
 #include <string>
+#include <core/SessionPool.hpp>
 
 typedef void CURL;
-typedef void CURLM;
 
 namespace Davix {
 
@@ -40,12 +40,12 @@ class Status;
 //------------------------------------------------------------------------------
 struct CurlHandle {
   std::string key;
-  CURLM *mhandle;
   CURL *handle;
+  std::shared_ptr<SessionCounters> counters;
 
   void renewHandle();
-  CurlHandle(const std::string &k, CURLM *mh, CURL *h);
-  CurlHandle() : mhandle(NULL), handle(NULL) {}
+  CurlHandle(const std::string &k, CURL *h);
+  CurlHandle() : handle(NULL) {}
   ~CurlHandle();
 };
 
@@ -71,6 +71,20 @@ public:
     return _handle.get();
   }
 
+  //----------------------------------------------------------------------------
+  // The transfer completed successfully, the handle can be recycled
+  //----------------------------------------------------------------------------
+  void markTransferSucceeded() {
+    _transfer_succeeded = true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Never recycle the handle
+  //----------------------------------------------------------------------------
+  void doNotReuse() {
+    _session_recycling = false;
+  }
+
 private:
   //----------------------------------------------------------------------------
   // Configure session
@@ -79,6 +93,8 @@ private:
 
   CurlSessionFactory &_factory;
   CurlHandlePtr _handle;
+  bool _session_recycling;
+  bool _transfer_succeeded;
 };
 
 }
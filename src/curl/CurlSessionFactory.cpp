@@ -21,6 +21,7 @@
 
 #include "CurlSessionFactory.hpp"
 #include "CurlSession.hpp"
+#include "CurlEventLoop.hpp"
 #include <backend/SessionFactory.hpp>
 #include <curl/curl.h>
 
@@ -38,7 +39,8 @@ static bool isSessionCachingDisabled(){
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-CurlSessionFactory::CurlSessionFactory() : _session_caching(!isSessionCachingDisabled()) {}
+CurlSessionFactory::CurlSessionFactory() : _session_caching(!isSessionCachingDisabled()),
+  _buffered_bytes(0) {}
 
 //------------------------------------------------------------------------------
 // Destructor
@@ -48,8 +50,11 @@ CurlSessionFactory::~CurlSessionFactory() {}
 //------------------------------------------------------------------------------
 // Create a CurlSession tied to this class.
 //------------------------------------------------------------------------------
-std::unique_ptr<CurlSession> CurlSessionFactory::provideCurlSession(const Uri &uri, const RequestParams &params, Status &st) {
-  CurlHandlePtr handle = getCachedHandle(uri, params);
+std::unique_ptr<CurlSession> CurlSessionFactory::provideCurlSession(const Uri &uri, const RequestParams &params, Status &st, bool fresh) {
+  CurlHandlePtr handle;
+  if(!fresh) {
+    handle = getCachedHandle(uri, params);
+  }
 
   if(!handle) {
     handle = makeNewHandle(uri, params);
@@ -84,11 +89,65 @@ bool CurlSessionFactory::getSessionCaching() const {
   return _session_caching;
 }
 
+//------------------------------------------------------------------------------
+// Store a curl handle for reuse purposes
+//------------------------------------------------------------------------------
+void CurlSessionFactory::storeCurlHandle(CurlHandlePtr handle) {
+  std::string key = handle->key;
+  _session_pool.insert(key, std::move(handle));
+}
+
+//------------------------------------------------------------------------------
+// Add session pool statistics onto the given map
+//------------------------------------------------------------------------------
+void CurlSessionFactory::collectSessionPoolStats(std::map<std::string, SessionPoolStats> &stats) const {
+  _session_pool.collectStats(stats);
+}
+
+//------------------------------------------------------------------------------
+// Get the event loop driving all transfers of this factory, start it if needed
+//------------------------------------------------------------------------------
+CurlEventLoop& CurlSessionFactory::getEventLoop() {
+  std::lock_guard<std::mutex> lock(_event_loop_mtx);
+
+  if(!_event_loop) {
+    _event_loop.reset(new CurlEventLoop());
+  }
+
+  return *_event_loop;
+}
+
+//------------------------------------------------------------------------------
+// Get the pool of response body blocks shared by all requests
+//------------------------------------------------------------------------------
+ResponseBlockPool& CurlSessionFactory::getResponseBlockPool() {
+  return _response_block_pool;
+}
+
+//------------------------------------------------------------------------------
+// Keep track of response body bytes buffered across all requests
+//------------------------------------------------------------------------------
+void CurlSessionFactory::addBufferedBytes(size_t bytes) {
+  _buffered_bytes += bytes;
+}
+
+void CurlSessionFactory::removeBufferedBytes(size_t bytes) {
+  _buffered_bytes -= bytes;
+}
+
+size_t CurlSessionFactory::getBufferedBytes() const {
+  return _buffered_bytes;
+}
+
 //------------------------------------------------------------------------------
 // Retrieve cached handle, if possible
 //------------------------------------------------------------------------------
 CurlHandlePtr CurlSessionFactory::getCachedHandle(const Uri &uri, const RequestParams &params) {
   CurlHandlePtr out;
+  if(!params.getKeepAlive()) {
+    return out;
+  }
+
   std::string sessionKey = SessionFactory::makeSessionKey(uri);
 
   if(_session_pool.retrieve(sessionKey, out)) {
@@ -105,9 +164,9 @@ CurlHandlePtr CurlSessionFactory::makeNewHandle(const Uri &uri, const RequestPar
   std::string sessionKey = SessionFactory::makeSessionKey(uri);
 
   CURL *handle = curl_easy_init();
-  CURLM *mhandle = curl_multi_init();
-
-  return CurlHandlePtr(new CurlHandle(sessionKey, mhandle, handle));
+  CurlHandlePtr out(new CurlHandle(sessionKey, handle));
+  out->counters = _session_pool.registerSession(sessionKey);
+  return out;
 }
 
 }
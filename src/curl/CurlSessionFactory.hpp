@@ -25,6 +25,8 @@
 #include "../backend/SessionFactory.hpp"
 #include <status/DavixStatus.hpp>
 #include <core/SessionPool.hpp>
+#include "ResponseBuffer.hpp"
+#include <atomic>
 
 namespace Davix {
 
@@ -32,6 +34,7 @@ struct CurlHandle;
 typedef std::shared_ptr<CurlHandle> CurlHandlePtr;
 
 class CurlSession;
+class CurlEventLoop;
 
 class CurlSessionFactory {
 public:
@@ -46,9 +49,10 @@ public:
     virtual ~CurlSessionFactory();
 
     //--------------------------------------------------------------------------
-    // Create a CurlSession tied to this class.
+    // Create a CurlSession tied to this class. A fresh session never comes
+    // from the pool of idle ones.
     //--------------------------------------------------------------------------
-    std::unique_ptr<CurlSession> provideCurlSession(const Uri &uri, const RequestParams &params, Status &st);
+    std::unique_ptr<CurlSession> provideCurlSession(const Uri &uri, const RequestParams &params, Status &st, bool fresh = false);
 
     //--------------------------------------------------------------------------
     // Set caching on or off
@@ -60,6 +64,35 @@ public:
     //--------------------------------------------------------------------------
     bool getSessionCaching() const;
 
+    //--------------------------------------------------------------------------
+    // Store a curl handle for reuse purposes
+    //--------------------------------------------------------------------------
+    void storeCurlHandle(CurlHandlePtr handle);
+
+    //--------------------------------------------------------------------------
+    // Add session pool statistics onto the given map
+    //--------------------------------------------------------------------------
+    void collectSessionPoolStats(std::map<std::string, SessionPoolStats> &stats) const;
+
+    //--------------------------------------------------------------------------
+    // Get the event loop driving all transfers of this factory - started
+    // lazily, so that contexts which never use libcurl don't pay for an
+    // extra thread.
+    //--------------------------------------------------------------------------
+    CurlEventLoop& getEventLoop();
+
+    //--------------------------------------------------------------------------
+    // Get the pool of response body blocks shared by all requests
+    //--------------------------------------------------------------------------
+    ResponseBlockPool& getResponseBlockPool();
+
+    //--------------------------------------------------------------------------
+    // Keep track of response body bytes buffered across all requests
+    //--------------------------------------------------------------------------
+    void addBufferedBytes(size_t bytes);
+    void removeBufferedBytes(size_t bytes);
+    size_t getBufferedBytes() const;
+
 private:
     //--------------------------------------------------------------------------
     // Retrieve cached handle, if possible
@@ -77,6 +110,19 @@ private:
     mutable std::mutex _session_caching_mtx;
     bool _session_caching;
 
+    //--------------------------------------------------------------------------
+    // Shared event loop - declared before the session pool, so that pooled
+    // handles are cleaned up while the loop's share handle still exists.
+    //--------------------------------------------------------------------------
+    std::mutex _event_loop_mtx;
+    std::unique_ptr<CurlEventLoop> _event_loop;
+
+    //--------------------------------------------------------------------------
+    // Recycled response body blocks
+    //--------------------------------------------------------------------------
+    ResponseBlockPool _response_block_pool;
+    std::atomic<size_t> _buffered_bytes;
+
     //--------------------------------------------------------------------------
     // Session pool
     //--------------------------------------------------------------------------
@@ -20,23 +20,124 @@
 */
 
 #include "ResponseBuffer.hpp"
+#include <utils/davix_logger_internal.hpp>
 #include <string.h>
+#include <algorithm>
 #include <iostream>
 
 #define DBG(message) std::cerr << __FILE__ << ":" << __LINE__ << " -- " << #message << " = " << message << std::endl;
 
 namespace Davix {
 
+//------------------------------------------------------------------------------
+// ResponseBlockPool: Constructor
+//------------------------------------------------------------------------------
+ResponseBlockPool::ResponseBlockPool(size_t maxCachedBytes)
+: _max_cached_bytes(maxCachedBytes), _cached_bytes(0), _allocated(0), _reused(0) {}
+
+//------------------------------------------------------------------------------
+// ResponseBlockPool: Destructor
+//------------------------------------------------------------------------------
+ResponseBlockPool::~ResponseBlockPool() {
+  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_HTTP, "Response block pool: {} blocks allocated, {} reused",
+    _allocated.load(), _reused.load());
+
+  for(auto it = _free.begin(); it != _free.end(); it++) {
+    for(size_t i = 0; i < it->second.size(); i++) {
+      delete[] it->second[i];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// ResponseBlockPool: Get a block of exactly the given size
+//------------------------------------------------------------------------------
+char* ResponseBlockPool::acquire(size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto it = _free.find(size);
+
+    if(it != _free.end() && !it->second.empty()) {
+      char *block = it->second.back();
+      it->second.pop_back();
+      _cached_bytes -= size;
+      _reused++;
+      return block;
+    }
+  }
+
+  _allocated++;
+  return new char[size];
+}
+
+//------------------------------------------------------------------------------
+// ResponseBlockPool: Give back a block obtained through acquire
+//------------------------------------------------------------------------------
+void ResponseBlockPool::release(char *block, size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+
+    if(_cached_bytes + size <= _max_cached_bytes) {
+      _free[size].push_back(block);
+      _cached_bytes += size;
+      return;
+    }
+  }
+
+  delete[] block;
+}
+
+//------------------------------------------------------------------------------
+// ResponseBlockPool: Get allocation counters
+//------------------------------------------------------------------------------
+ResponseBlockPool::Stats ResponseBlockPool::getStats() const {
+  Stats stats;
+  stats.allocated = _allocated;
+  stats.reused = _reused;
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  stats.cachedBytes = _cached_bytes;
+  return stats;
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-ResponseBuffer::ResponseBuffer(size_t bsize) : bufferSize(bsize), posWrite(0),
-    posRead(0) {}
+ResponseBuffer::ResponseBuffer(size_t bsize, ResponseBlockPool *p, size_t maxBsize)
+: pool(p), nextBlockSize(bsize), maxBlockSize(std::max(bsize, maxBsize)), posWrite(0),
+  posRead(0), stored(0) {}
 
 //------------------------------------------------------------------------------
 // Destructor
 //------------------------------------------------------------------------------
-ResponseBuffer::~ResponseBuffer() {}
+ResponseBuffer::~ResponseBuffer() {
+  for(size_t i = 0; i < buffers.size(); i++) {
+    releaseBlock(buffers[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Allocate a block, through the pool if we have one
+//------------------------------------------------------------------------------
+char* ResponseBuffer::allocateBlock(size_t size) {
+  if(pool) {
+    return pool->acquire(size);
+  }
+
+  return new char[size];
+}
+
+//------------------------------------------------------------------------------
+// Release a block, through the pool if we have one
+//------------------------------------------------------------------------------
+void ResponseBuffer::releaseBlock(const Block &block) {
+  if(pool) {
+    pool->release(block.data, block.capacity);
+    return;
+  }
+
+  delete[] block.data;
+}
 
 //------------------------------------------------------------------------------
 // Feed len bytes into the buffer
@@ -45,18 +146,26 @@ void ResponseBuffer::feed(const char *buff, size_t len) {
   size_t buffPos = 0;
 
   while(len > 0) {
-    if(buffers.size() == 0 || posWrite == bufferSize) {
-      buffers.emplace_back();
-      buffers.back().resize(bufferSize);
+    if(buffers.size() == 0 || posWrite == buffers.back().capacity) {
+      Block block;
+      block.capacity = nextBlockSize;
+      block.data = allocateBlock(block.capacity);
+      buffers.push_back(block);
       posWrite = 0;
+
+      //------------------------------------------------------------------------
+      // Data keeps piling up - use bigger blocks from now on
+      //------------------------------------------------------------------------
+      nextBlockSize = std::min(nextBlockSize * 2, maxBlockSize);
     }
 
-    size_t bytesToWrite = std::min(len, bufferSize - posWrite);
+    size_t bytesToWrite = std::min(len, buffers.back().capacity - posWrite);
 
-    ::memcpy(buffers.back().data()+posWrite, buff+buffPos, bytesToWrite);
+    ::memcpy(buffers.back().data+posWrite, buff+buffPos, bytesToWrite);
     buffPos += bytesToWrite;
     len -= bytesToWrite;
     posWrite += bytesToWrite;
+    stored += bytesToWrite;
   }
 }
 
@@ -66,34 +175,32 @@ void ResponseBuffer::feed(const char *buff, size_t len) {
 size_t ResponseBuffer::consume(char *target, size_t maxlen) {
   size_t bytesDelivered = 0;
 
-  while(maxlen > 0) {
-    if(buffers.size() == 0) {
-      break;
-    }
-
-    if(buffers.size() == 1 && posRead >= posWrite) {
-      break;
-    }
-
-    if(posRead == bufferSize) {
-      buffers.pop_front();
-      posRead = 0;
-    }
-
-    size_t bytesToCopy = 0;
-    if(buffers.size() == 1) {
-      bytesToCopy = posWrite - posRead;
-    }
-    else {
-      bytesToCopy = bufferSize - posRead;
-    }
+  while(maxlen > 0 && stored > 0) {
+    Block &front = buffers.front();
+    size_t end = (buffers.size() == 1) ? posWrite : front.capacity;
 
-    bytesToCopy = std::min(maxlen, bytesToCopy);
-    ::memcpy(target+bytesDelivered, buffers.front().data()+posRead, bytesToCopy);
+    size_t bytesToCopy = std::min(maxlen, end - posRead);
+    ::memcpy(target+bytesDelivered, front.data+posRead, bytesToCopy);
 
     posRead += bytesToCopy;
     maxlen -= bytesToCopy;
     bytesDelivered += bytesToCopy;
+    stored -= bytesToCopy;
+
+    if(posRead == end) {
+      if(buffers.size() == 1) {
+        //----------------------------------------------------------------------
+        // Drained completely - keep the last block around for further writes
+        //----------------------------------------------------------------------
+        posRead = 0;
+        posWrite = 0;
+      }
+      else {
+        releaseBlock(front);
+        buffers.pop_front();
+        posRead = 0;
+      }
+    }
   }
 
   return bytesDelivered;
@@ -103,17 +210,7 @@ size_t ResponseBuffer::consume(char *target, size_t maxlen) {
 // Check total stored bytes
 //------------------------------------------------------------------------------
 size_t ResponseBuffer::size() const {
-  size_t total = 0;
-
-  if(buffers.size() == 0) {
-    return total;
-  }
-
-  total += bufferSize * buffers.size();
-
-  total -= posRead;
-  total -= (bufferSize - posWrite);
-  return total;
+  return stored;
 }
 
 }
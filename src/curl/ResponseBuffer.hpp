@@ -22,19 +22,83 @@
 #ifndef DAVIX_CURL_RESPONSE_BUFFER_HPP
 #define DAVIX_CURL_RESPONSE_BUFFER_HPP
 
-#include <vector>
+#include <atomic>
+#include <cstdint>
 #include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
 #include <stddef.h>
 
 namespace Davix {
 
+//------------------------------------------------------------------------------
+// Free list of memory blocks backing ResponseBuffer, shared by all requests
+// of a session factory, so that long transfers don't allocate and free a
+// block for every few kilobytes received. Blocks are bucketed by size.
+//------------------------------------------------------------------------------
+class ResponseBlockPool {
+public:
+  struct Stats {
+    uint64_t allocated;    // blocks obtained from the heap
+    uint64_t reused;       // blocks handed out from the free list
+    uint64_t cachedBytes;  // bytes currently sitting in the free list
+  };
+
+  //----------------------------------------------------------------------------
+  // Constructor - keep up to maxCachedBytes worth of free blocks around
+  //----------------------------------------------------------------------------
+  ResponseBlockPool(size_t maxCachedBytes = 67108864u);
+
+  //----------------------------------------------------------------------------
+  // Destructor
+  //----------------------------------------------------------------------------
+  ~ResponseBlockPool();
+
+  //----------------------------------------------------------------------------
+  // No copying, no moving.
+  //----------------------------------------------------------------------------
+  ResponseBlockPool(const ResponseBlockPool& other) = delete;
+  ResponseBlockPool& operator=(const ResponseBlockPool& other) = delete;
+
+  //----------------------------------------------------------------------------
+  // Get a block of exactly the given size
+  //----------------------------------------------------------------------------
+  char* acquire(size_t size);
+
+  //----------------------------------------------------------------------------
+  // Give back a block obtained through acquire
+  //----------------------------------------------------------------------------
+  void release(char *block, size_t size);
+
+  //----------------------------------------------------------------------------
+  // Get allocation counters
+  //----------------------------------------------------------------------------
+  Stats getStats() const;
+
+private:
+  size_t _max_cached_bytes;
+
+  mutable std::mutex _mtx;
+  std::map<size_t, std::vector<char*> > _free;
+  size_t _cached_bytes;
+
+  std::atomic<uint64_t> _allocated;
+  std::atomic<uint64_t> _reused;
+};
+
 //------------------------------------------------------------------------------
 // Utility class to buffer HTTP response body
 //------------------------------------------------------------------------------
 class ResponseBuffer {
 public:
 
-  ResponseBuffer(size_t bsize = 16384u);
+  //----------------------------------------------------------------------------
+  // Constructor - the first block is bsize bytes long, each subsequent one
+  // doubles in size up to maxBlockSize. If given, blocks are drawn from and
+  // returned to pool, otherwise they're heap-allocated.
+  //----------------------------------------------------------------------------
+  ResponseBuffer(size_t bsize = 16384u, ResponseBlockPool *pool = NULL, size_t maxBlockSize = 0u);
   ~ResponseBuffer();
 
   //----------------------------------------------------------------------------
@@ -53,13 +117,23 @@ public:
   size_t size() const;
 
 private:
-  std::deque<std::vector<char>> buffers;
-  size_t bufferSize;
+  struct Block {
+    char *data;
+    size_t capacity;
+  };
+
+  char* allocateBlock(size_t size);
+  void releaseBlock(const Block &block);
+
+  ResponseBlockPool *pool;
+  std::deque<Block> buffers;
+  size_t nextBlockSize;
+  size_t maxBlockSize;
   size_t posWrite;
   size_t posRead;
+  size_t stored;
 };
 
 }
 
 #endif
-
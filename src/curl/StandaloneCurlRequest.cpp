@@ -22,6 +22,7 @@
 #include "StandaloneCurlRequest.hpp"
 #include "CurlSessionFactory.hpp"
 #include "CurlSession.hpp"
+#include "CurlEventLoop.hpp"
 #include "HeaderlineParser.hpp"
 #include <utils/davix_logger_internal.hpp>
 #include <core/ContentProvider.hpp>
@@ -154,9 +155,8 @@ static size_t header_callback(char *buffer, size_t size, size_t nitems, void *us
 static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
   size_t bytes = size * nmemb;
 
-  ResponseBuffer* buff = (ResponseBuffer*) userdata;
-  buff->feed(ptr, bytes);
-  return bytes;
+  StandaloneCurlRequest* req = (StandaloneCurlRequest*) userdata;
+  return req->feedResponseBody(ptr, bytes);
 }
 
 //------------------------------------------------------------------------------
@@ -186,12 +186,18 @@ StandaloneCurlRequest::StandaloneCurlRequest(CurlSessionFactory &sessionFactory,
 : _session_factory(sessionFactory), _reuse_session(reuseSession), _bound_hooks(boundHooks),
   _uri(uri), _verb(verb), _params(params), _headers(headers), _req_flag(reqFlag),
   _content_provider(contentProvider), _deadline(deadline), _state(RequestState::kNotStarted),
-  _chunklist(NULL), _received_headers(false) {}
+  _chunklist(NULL), _received_headers(false), _status_code(0),
+  _response_buffer(params.getResponseBlockSize(), &sessionFactory.getResponseBlockPool(), params.getMaxResponseBlockSize()),
+  _paused(false),
+  _transfer_done(false), _direct_buffer(NULL), _direct_capacity(0), _direct_filled(0),
+  _attached(false) {}
 
 //------------------------------------------------------------------------------
 // Destructor
 //------------------------------------------------------------------------------
 StandaloneCurlRequest::~StandaloneCurlRequest() {
+    detachFromEventLoop();
+    _session_factory.removeBufferedBytes(_response_buffer.size());
     curl_slist_free_all(_chunklist);
 }
 
@@ -207,6 +213,7 @@ bool StandaloneCurlRequest::getAnswerHeader(const std::string &header_name, std:
 
   auto header_lower = _tolower(header_name);
 
+  std::lock_guard<std::mutex> lock(_mtx);
   for (const auto& it: _response_headers) {
     if (header_lower == _tolower(it.first)) {
       value = it.second;
@@ -221,6 +228,7 @@ bool StandaloneCurlRequest::getAnswerHeader(const std::string &header_name, std:
 // Get all response headers
 //------------------------------------------------------------------------------
 size_t StandaloneCurlRequest::getAnswerHeaders(std::vector<std::pair<std::string, std::string > > & vec_headers) const {
+  std::lock_guard<std::mutex> lock(_mtx);
   vec_headers = _response_headers;
   return vec_headers.size();
 }
@@ -303,7 +311,8 @@ Status StandaloneCurlRequest::startRequest() {
   //----------------------------------------------------------------------------
   // Retrieve a session, create request
   //----------------------------------------------------------------------------
-  _session = _session_factory.provideCurlSession(_uri, _params, st);
+  _session = _session_factory.provideCurlSession(_uri, _params, st,
+    (_req_flag & RequestFlag::FreshConnection) != 0);
   if(!st.ok()) {
     // markCompleted();
     return st;
@@ -330,7 +339,7 @@ Status StandaloneCurlRequest::startRequest() {
   // Set up callback to consume response body
   //----------------------------------------------------------------------------
   curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(handle, CURLOPT_WRITEDATA, &_response_buffer);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, this);
 
   //----------------------------------------------------------------------------
   // Set up callback to provide request body
@@ -416,6 +425,25 @@ Status StandaloneCurlRequest::startRequest() {
     curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
   }
 
+  //----------------------------------------------------------------------------
+  // Don't pick an idle connection from the multi handle's cache
+  //----------------------------------------------------------------------------
+  if(_req_flag & RequestFlag::FreshConnection) {
+    curl_easy_setopt(handle, CURLOPT_FRESH_CONNECT, 1L);
+  }
+
+  //----------------------------------------------------------------------------
+  // HTTP version - with HTTP/2, wait for an existing connection to the same
+  // endpoint which can take one more stream, rather than opening a new one.
+  //----------------------------------------------------------------------------
+  if(_params.getHttp2Support()) {
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+  }
+  else {
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_1_1);
+  }
+
   //----------------------------------------------------------------------------
   // Set up debugging
   //----------------------------------------------------------------------------
@@ -423,44 +451,96 @@ Status StandaloneCurlRequest::startRequest() {
   curl_easy_setopt(handle, CURLOPT_VERBOSE, 1L);
 
   //----------------------------------------------------------------------------
-  // Start request
+  // Callbacks will fire from the event loop thread, no signals please
+  //----------------------------------------------------------------------------
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+
+  //----------------------------------------------------------------------------
+  // Start request - hand over the handle to the event loop, wait until
+  // headers are dealt with and body data starts coming in, or the transfer
+  // is over.
   //----------------------------------------------------------------------------
   _state = RequestState::kStarted;
+  _attached = true;
+  _session_factory.getEventLoop().add(handle, [this](CURLcode code) {
+    markTransferDone(curlCodeToStatus(code));
+  });
 
-  while(true) {
-    int still_running = 1;
-    Status st = performBlockingRound(still_running);
+  std::unique_lock<std::mutex> lock(_mtx);
+  st = waitForBodyOrCompletion(lock);
 
-    if(!st.ok()) {
-      _state = RequestState::kFinished;
-      return st;
-    }
+  if(!st.ok()) {
+    _state = RequestState::kFinished;
+    return st;
+  }
 
-    if(still_running == 0) {
-      return checkErrors();
-    }
+  if(_transfer_done && !sessionError.ok()) {
+    _state = RequestState::kFinished;
+    return sessionError;
+  }
 
-    if(_response_buffer.size() != 0u) {
-      //------------------------------------------------------------------------
-      // We've dealt with the headers already, startRequest() is done. Switch
-      // to readBlock() mode.
-      //------------------------------------------------------------------------
-      _state = RequestState::kStarted;
-      return checkErrors();
-    }
+  return Status();
+}
+
+//------------------------------------------------------------------------------
+// Transfer completion, called from the event loop thread
+//------------------------------------------------------------------------------
+void StandaloneCurlRequest::markTransferDone(const Status &st) {
+  CurlHandle *handle = _session->getHandle();
+
+  long response_code = 0;
+  curl_easy_getinfo(handle->handle, CURLINFO_RESPONSE_CODE, &response_code);
+
+  // an HTTP/2 transfer which didn't open a connection of its own shared an
+  // existing one with other streams
+  long http_version = 0;
+  long new_connections = 0;
+  curl_easy_getinfo(handle->handle, CURLINFO_HTTP_VERSION, &http_version);
+  curl_easy_getinfo(handle->handle, CURLINFO_NUM_CONNECTS, &new_connections);
+  if(http_version == CURL_HTTP_VERSION_2_0 && new_connections == 0 && handle->counters) {
+    handle->counters->multiplexed++;
+  }
+
+  if(st.ok()) {
+    _session->markTransferSucceeded();
+  }
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  _transfer_done = true;
+  _status_code = response_code;
+  sessionError = st;
+  _cv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Stop the event loop from driving our handle, if it still is. Must not be
+// called with _mtx held, as the event loop thread might be waiting for it
+// inside one of our callbacks.
+//------------------------------------------------------------------------------
+void StandaloneCurlRequest::detachFromEventLoop() {
+  if(_attached) {
+    _session_factory.getEventLoop().remove(_session->getHandle()->handle);
+    _attached = false;
   }
 }
 
 //------------------------------------------------------------------------------
-// Check internal mhandle errors
+// Block until the response buffer or the direct destination buffer has
+// data, or the transfer is over. Fails only on timeout.
 //------------------------------------------------------------------------------
-Status StandaloneCurlRequest::checkErrors() {
-  CURLMsg *msg;
-  int msgs_left = 0;
-  while((msg = curl_multi_info_read(_session->getHandle()->mhandle, &msgs_left))) {
-    if(msg->msg == CURLMSG_DONE && msg->data.result != CURLE_OK) {
-      sessionError = curlCodeToStatus(msg->data.result);
-      return sessionError;
+Status StandaloneCurlRequest::waitForBodyOrCompletion(std::unique_lock<std::mutex> &lock) {
+  while(_response_buffer.size() == 0u && _direct_filled == 0u && !_transfer_done) {
+    Status st = checkTimeout();
+    if(!st.ok()) {
+      return st;
+    }
+
+    uint64_t remaining = getRemainingMs();
+    if(remaining == std::numeric_limits<std::uint64_t>::max()) {
+      _cv.wait(lock);
+    }
+    else {
+      _cv.wait_for(lock, std::chrono::milliseconds(remaining + 1));
     }
   }
 
@@ -484,90 +564,106 @@ uint64_t StandaloneCurlRequest::getRemainingMs() const {
 }
 
 //------------------------------------------------------------------------------
-// Perform a single blocking round of network I/O
+// Major read function - read a block of max_size bytes (at max) into buffer.
 //------------------------------------------------------------------------------
-Status StandaloneCurlRequest::performBlockingRound(int &still_running) {
-  still_running = 0;
-
+dav_ssize_t StandaloneCurlRequest::readBlock(char* buffer, dav_size_t max_size, Status& st) {
   if(!_session) {
-    return Status(davix_scope_http_request(), StatusCode::InvalidArgument, "Request not active");
+    st = Status(davix_scope_http_request(), StatusCode::AlreadyRunning, "Request has not been started yet");
+    return -1;
   }
 
-  while(true) {
-    Status st = checkTimeout();
-    if(!st.ok()) {
-      return st;
-    }
+  if(max_size == 0) {
+    return 0;
+  }
 
-    size_t prevSize = _response_buffer.size();
+  st = checkTimeout();
+  if(!st.ok()) {
+    return -1;
+  }
 
-    CURLM* mhandle = _session->getHandle()->mhandle;
-    curl_multi_perform(mhandle, &still_running);
+  std::unique_lock<std::mutex> lock(_mtx);
+  resumeIfWithinBudget();
 
-    //--------------------------------------------------------------------------
-    // Any errors from this round?
-    //--------------------------------------------------------------------------
-    Status errs = checkErrors();
-    if(!errs.ok()) {
-      return errs;
-    }
+  //----------------------------------------------------------------------------
+  // Nothing buffered yet: let the write callback deliver straight into the
+  // caller's buffer while we wait, saving a copy through _response_buffer.
+  //----------------------------------------------------------------------------
+  if(_response_buffer.size() == 0u && !_transfer_done) {
+    _direct_buffer = buffer;
+    _direct_capacity = max_size;
+    _direct_filled = 0;
 
-    //--------------------------------------------------------------------------
-    // Are we done?
-    //--------------------------------------------------------------------------
-    if(still_running == 0) {
-      return Status();
+    st = waitForBodyOrCompletion(lock);
+
+    dav_ssize_t filled = _direct_filled;
+    _direct_buffer = NULL;
+    _direct_capacity = 0;
+    _direct_filled = 0;
+
+    if(!st.ok()) {
+      return -1;
     }
 
     //--------------------------------------------------------------------------
-    // Was anything actually read? If so, our work here is done, we're
-    // only supposed to do a single blocking round.
+    // Any overflow went into _response_buffer, and will be served next time
     //--------------------------------------------------------------------------
-    if(prevSize != _response_buffer.size()) {
-      return Status();
+    if(filled != 0) {
+      return filled;
     }
+  }
 
-    //--------------------------------------------------------------------------
-    // Nope, we made no progress during this round, retry
-    //--------------------------------------------------------------------------
-    int numfds;
-    curl_multi_poll(_session->getHandle()->mhandle, NULL, 0, getRemainingMs(), &numfds);
+  st = waitForBodyOrCompletion(lock);
+  if(!st.ok()) {
+    return -1;
   }
+
+  if(_response_buffer.size() == 0u && !sessionError.ok()) {
+    st = sessionError;
+    return -1;
+  }
+
+  dav_ssize_t retval = _response_buffer.consume(buffer, max_size);
+  _session_factory.removeBufferedBytes(retval);
+
+  resumeIfWithinBudget();
+  return retval;
 }
 
 //------------------------------------------------------------------------------
-// Major read function - read a block of max_size bytes (at max) into buffer.
+// Is there room to buffer more response data? A request with nothing
+// buffered is always allowed to proceed, even if the context-wide budget
+// is exhausted - otherwise its reader could wait forever.
 //------------------------------------------------------------------------------
-dav_ssize_t StandaloneCurlRequest::readBlock(char* buffer, dav_size_t max_size, Status& st) {
-  if(!_session) {
-    st = Status(davix_scope_http_request(), StatusCode::AlreadyRunning, "Request has not been started yet");
-    return -1;
-  }
+bool StandaloneCurlRequest::withinBufferBudget() const {
+  size_t buffered = _response_buffer.size();
 
-  if(max_size == 0) {
-    return 0;
+  if(buffered > _params.getResponseBufferLimit()) {
+    return false;
   }
 
-  st = checkTimeout();
-  if(!st.ok()) {
-    return -1;
+  if(buffered != 0u && _params.getContextResponseBufferLimit() != 0u &&
+     _session_factory.getBufferedBytes() > _params.getContextResponseBufferLimit()) {
+    return false;
   }
 
-  //----------------------------------------------------------------------------
-  // Keep some data cached inside the response buffer, but not too much
-  //----------------------------------------------------------------------------
-  if(_response_buffer.size() <= 33554432) {
-    int still_running = 0;
-    st = performBlockingRound(still_running);
-  }
+  return true;
+}
 
-  return _response_buffer.consume(buffer, max_size);
+//------------------------------------------------------------------------------
+// Caught up with the network? Let the event loop resume the transfer.
+//------------------------------------------------------------------------------
+void StandaloneCurlRequest::resumeIfWithinBudget() {
+  if(_paused && withinBufferBudget()) {
+    _paused = false;
+    _session_factory.getEventLoop().unpause(_session->getHandle()->handle);
+  }
 }
 
 //------------------------------------------------------------------------------
 // Finish an already started request.
 //------------------------------------------------------------------------------
 Status StandaloneCurlRequest::endRequest() {
+  detachFromEventLoop();
   _state = RequestState::kFinished;
   return Status();
 }
@@ -596,21 +692,17 @@ Status StandaloneCurlRequest::checkTimeout() {
 // Get status code - returns 0 if impossible to determine
 //------------------------------------------------------------------------------
 int StandaloneCurlRequest::getStatusCode() const {
-  long response_code = 0;
-
-  if(_session) {
-    CURL* handle = _session->getHandle()->handle;
-    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response_code);
-  }
-
-  return response_code;
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _status_code;
 }
 
 //------------------------------------------------------------------------------
 // Do not re-use underlying session
 //------------------------------------------------------------------------------
 void StandaloneCurlRequest::doNotReuseSession() {
-
+  if(_session) {
+    _session->doNotReuse();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -628,6 +720,7 @@ Status StandaloneCurlRequest::obtainRedirectedLocation(Uri &out) {
     return Status(davix_scope_http_request(), StatusCode::InvalidArgument, "Request not active, impossible to obtain redirected location");
   }
 
+  std::lock_guard<std::mutex> lock(_mtx);
   for(auto it = _response_headers.begin(); it != _response_headers.end(); it++) {
     if(strcasecmp("location", it->first.c_str()) == 0) {
       auto location = it->second;
@@ -652,6 +745,7 @@ Status StandaloneCurlRequest::obtainRedirectedLocation(Uri &out) {
 // Get session error, if available
 //------------------------------------------------------------------------------
 std::string StandaloneCurlRequest::getSessionError() const {
+  std::lock_guard<std::mutex> lock(_mtx);
   return sessionError.getErrorMessage();
 }
 
@@ -667,13 +761,56 @@ Status StandaloneCurlRequest::readResponseHeaders() {
 //------------------------------------------------------------------------------
 void StandaloneCurlRequest::feedResponseHeader(const std::string &header) {
   if(header == "\r\n") {
+    long response_code = 0;
+    curl_easy_getinfo(_session->getHandle()->handle, CURLINFO_RESPONSE_CODE, &response_code);
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    _status_code = response_code;
     _received_headers = true;
     return;
   }
 
   HeaderlineParser parser(header);
+
+  std::lock_guard<std::mutex> lock(_mtx);
   _response_headers.push_back(std::pair<std::string, std::string>(parser.getKey(), parser.getValue()));
 }
 
+//------------------------------------------------------------------------------
+// Feed response body
+//------------------------------------------------------------------------------
+size_t StandaloneCurlRequest::feedResponseBody(const char *data, size_t len) {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  //----------------------------------------------------------------------------
+  // A reader is waiting with its own buffer - fill it directly, only the
+  // bytes which don't fit go to the response buffer. Once it's full, we're
+  // back to regular buffering until the reader picks up its data.
+  //----------------------------------------------------------------------------
+  if(_direct_buffer != NULL && _direct_filled < _direct_capacity) {
+    size_t direct = std::min(len, _direct_capacity - _direct_filled);
+    memcpy(_direct_buffer + _direct_filled, data, direct);
+    _direct_filled += direct;
+
+    if(direct < len) {
+      _response_buffer.feed(data + direct, len - direct);
+      _session_factory.addBufferedBytes(len - direct);
+    }
+
+    _cv.notify_all();
+    return len;
+  }
+
+  if(!withinBufferBudget()) {
+    _paused = true;
+    return CURL_WRITEFUNC_PAUSE;
+  }
+
+  _response_buffer.feed(data, len);
+  _session_factory.addBufferedBytes(len);
+  _cv.notify_all();
+  return len;
+}
+
 
 }
@@ -27,6 +27,8 @@
 #include <backend/StandaloneRequest.hpp>
 #include <backend/BoundHooks.hpp>
 #include <params/davixrequestparams.hpp>
+#include <condition_variable>
+#include <mutex>
 
 struct curl_slist;
 
@@ -118,10 +120,17 @@ public:
   virtual std::string getSessionError() const;
 
   //----------------------------------------------------------------------------
-  // Feed response header
+  // Feed response header - called from the event loop thread
   //----------------------------------------------------------------------------
   void feedResponseHeader(const std::string &header);
 
+  //----------------------------------------------------------------------------
+  // Feed response body - called from the event loop thread. Returns the
+  // number of bytes consumed, or CURL_WRITEFUNC_PAUSE if we're already
+  // buffering too much and the transfer should be paused.
+  //----------------------------------------------------------------------------
+  size_t feedResponseBody(const char *data, size_t len);
+
 private:
   CurlSessionFactory &_session_factory;
   bool _reuse_session;
@@ -150,9 +159,25 @@ private:
   uint64_t getRemainingMs() const;
 
   //----------------------------------------------------------------------------
-  // Check internal mhandle errors
+  // Transfer completion, called from the event loop thread
+  //----------------------------------------------------------------------------
+  void markTransferDone(const Status &st);
+
+  //----------------------------------------------------------------------------
+  // Stop the event loop from driving our handle, if it still is
   //----------------------------------------------------------------------------
-  Status checkErrors();
+  void detachFromEventLoop();
+
+  //----------------------------------------------------------------------------
+  // Is there room to buffer more response data, according to the per-request
+  // and per-context limits in _params? Call with _mtx held.
+  //----------------------------------------------------------------------------
+  bool withinBufferBudget() const;
+
+  //----------------------------------------------------------------------------
+  // Resume a paused transfer if we're back within budget. Call with _mtx held.
+  //----------------------------------------------------------------------------
+  void resumeIfWithinBudget();
 
   //----------------------------------------------------------------------------
   // Linked list for storing request headers
@@ -160,12 +185,32 @@ private:
   struct curl_slist *_chunklist;
 
   //----------------------------------------------------------------------------
-  // Response variables
+  // Response variables - populated by the event loop thread, protected by
+  // _mtx. _cv is signalled whenever any of them changes.
   //----------------------------------------------------------------------------
+  mutable std::mutex _mtx;
+  std::condition_variable _cv;
+
   std::vector<std::pair<std::string, std::string > > _response_headers;
   bool _received_headers;
+  long _status_code;
 
   ResponseBuffer _response_buffer;
+  bool _paused;
+  bool _transfer_done;
+
+  //----------------------------------------------------------------------------
+  // Destination buffer registered by a blocked readBlock() call - the write
+  // callback fills it directly, bypassing _response_buffer.
+  //----------------------------------------------------------------------------
+  char *_direct_buffer;
+  size_t _direct_capacity;
+  size_t _direct_filled;
+
+  //----------------------------------------------------------------------------
+  // Is our handle currently owned by the event loop? Caller thread only.
+  //----------------------------------------------------------------------------
+  bool _attached;
 
   //----------------------------------------------------------------------------
   // Block until all response headers have been received
@@ -173,9 +218,11 @@ private:
   Status readResponseHeaders();
 
   //----------------------------------------------------------------------------
-  // Perform a single blocking round of network I/O
+  // Block until the response buffer or the direct destination buffer has
+  // data, or the transfer is over.
+  // Fails only on timeout.
   //----------------------------------------------------------------------------
-  Status performBlockingRound(int &still_running);
+  Status waitForBodyOrCompletion(std::unique_lock<std::mutex> &lock);
 
 };
 
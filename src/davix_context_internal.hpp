@@ -35,12 +35,22 @@ namespace Davix {
 
 class RedirectionResolver;
 class SessionFactory;
+class WorkerPool;
+class LinkEstimator;
+class BlockCache;
+class DiskCache;
+class StatCache;
 
 
 struct ContextExplorer{
 
 static SessionFactory & SessionFactoryFromContext(Context & c);
 static RedirectionResolver & RedirectionResolverFromContext(Context &c);
+static WorkerPool & WorkerPoolFromContext(Context &c);
+static LinkEstimator & LinkEstimatorFromContext(Context &c);
+static BlockCache & BlockCacheFromContext(Context &c);
+static DiskCache & DiskCacheFromContext(Context &c);
+static StatCache & StatCacheFromContext(Context &c);
 
 };
 
@@ -28,10 +28,16 @@
 #include <backend/SessionFactory.hpp>
 #include <davix_context_internal.hpp>
 #include <core/RedirectionResolver.hpp>
+#include <core/LinkEstimator.hpp>
+#include <core/BlockCache.hpp>
+#include <core/DiskCache.hpp>
+#include <core/StatCache.hpp>
+#include <core/WorkerPool.hpp>
 
 #include <curl/curl.h>
 
 #include <set>
+#include <algorithm>
 #include <mutex>
 
 namespace Davix{
@@ -59,9 +65,13 @@ struct ContextInternal
 
     ContextInternal(const ContextInternal & orig) :
         _fsess(new SessionFactory()),
-        _redirectionResolver(new RedirectionResolver(!redirCachingDisabled())),
-        _hook_list(orig._hook_list)
+        _redirectionResolver(new RedirectionResolver(!redirCachingDisabled(), orig._redirectionResolver->getCacheSize())),
+        _hook_list(orig._hook_list),
+        _blockCache(orig._blockCache.getCapacity()),
+        _statCache(orig._statCache.getTTL(), orig._statCache.getNegativeTTL()),
+        _workerThreads(orig.getWorkerThreads())
     {
+        _diskCache.configure(orig._diskCache.getDirectory(), orig._diskCache.getLimit());
     }
 
     virtual ~ContextInternal(){}
@@ -75,9 +85,41 @@ struct ContextInternal
         return _redirectionResolver.get();
     }
 
+    // worker pool is started lazily, most contexts never need it
+    inline WorkerPool* getWorkerPool() {
+        std::lock_guard<std::mutex> lock(_workerPoolMtx);
+        if(!_workerPool) {
+            _workerPool.reset(new WorkerPool(_workerThreads != 0 ? _workerThreads : WorkerPool::defaultSize()));
+        }
+        return _workerPool.get();
+    }
+
+    // only honoured until the worker pool is started
+    inline void setWorkerThreads(size_t n) {
+        std::lock_guard<std::mutex> lock(_workerPoolMtx);
+        _workerThreads = std::min<size_t>(n, DAVIX_MAX_WORKER_THREADS);
+    }
+
+    inline size_t getWorkerThreads() const {
+        std::lock_guard<std::mutex> lock(_workerPoolMtx);
+        if(_workerPool) {
+            return _workerPool->size();
+        }
+        return _workerThreads != 0 ? _workerThreads : WorkerPool::defaultSize();
+    }
+
     std::unique_ptr<SessionFactory>  _fsess;
     std::unique_ptr<RedirectionResolver> _redirectionResolver;
     HookList _hook_list;
+    LinkEstimator _linkEstimator;
+    BlockCache _blockCache;
+    DiskCache _diskCache;
+    StatCache _statCache;
+
+    // declared last: pending tasks still need everything above on shutdown
+    mutable std::mutex _workerPoolMtx;
+    size_t _workerThreads = 0;
+    std::unique_ptr<WorkerPool> _workerPool;
 };
 
 ///////////////////////////////////////////////////////////////
@@ -122,6 +164,117 @@ bool Context::getSessionCaching() const{
 
 void Context::clearCache() {
   _intern->_fsess.reset(new SessionFactory());
+  _intern->_blockCache.clear();
+  _intern->_diskCache.forget();
+  _intern->_statCache.clear();
+}
+
+void Context::setRedirectionCacheSize(size_t entries){
+    _intern->_redirectionResolver->setCacheSize(entries);
+}
+
+size_t Context::getRedirectionCacheSize() const{
+    return _intern->_redirectionResolver->getCacheSize();
+}
+
+void Context::setBlockCacheLimit(dav_size_t bytes){
+    _intern->_blockCache.setCapacity(bytes);
+}
+
+dav_size_t Context::getBlockCacheLimit() const{
+    return _intern->_blockCache.getCapacity();
+}
+
+void Context::setDiskCache(const std::string & directory, dav_size_t limit){
+    _intern->_diskCache.configure(directory, limit);
+}
+
+std::string Context::getDiskCacheDirectory() const{
+    return _intern->_diskCache.getDirectory();
+}
+
+dav_size_t Context::getDiskCacheLimit() const{
+    return _intern->_diskCache.getLimit();
+}
+
+void Context::setStatCacheTTL(unsigned int ttl, unsigned int negative_ttl){
+    _intern->_statCache.setTTL(ttl, negative_ttl);
+}
+
+unsigned int Context::getStatCacheTTL() const{
+    return _intern->_statCache.getTTL();
+}
+
+unsigned int Context::getStatCacheNegativeTTL() const{
+    return _intern->_statCache.getNegativeTTL();
+}
+
+void Context::setWorkerThreads(size_t n){
+    _intern->setWorkerThreads(n);
+}
+
+size_t Context::getWorkerThreads() const{
+    return _intern->getWorkerThreads();
+}
+
+int Context::prewarmConnections(const Uri & uri, int n, const RequestParams* params, DavixError** err){
+    if(n <= 0)
+        return 0;
+
+    // sessions beyond the idle limit of the pool would be dropped right away
+    n = std::min(n, DAVIX_DEFAULT_SESSION_POOL_MAX_IDLE_PER_HOST);
+
+    const RequestParams p(params);
+    std::mutex mtx;
+    int opened = 0;
+    DavixError* first_err = NULL;
+
+    // every request opens a session of its own, so they don't need to overlap
+    ContextExplorer::WorkerPoolFromContext(*this).parallelFor(n, n, [&](size_t){
+        DavixError* tmp_err = NULL;
+        HttpRequest req(*this, uri, &tmp_err);
+
+        if(tmp_err == NULL){
+            req.setParameters(p);
+            req.setRequestMethod("HEAD");
+            // HTTP/2 requests share one connection, no point in forcing more
+            req.setFlag(RequestFlag::FreshConnection, !p.getHttp2Support());
+            req.executeRequest(&tmp_err);
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if(tmp_err == NULL){
+            opened++;
+        }else if(first_err == NULL){
+            first_err = tmp_err;
+        }else{
+            DavixError::clearError(&tmp_err);
+        }
+    });
+
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CORE, "prewarmed {} out of {} sessions to {}", opened, n, uri.getString());
+
+    if(opened == 0){
+        DavixError::propagatePrefixedError(err, first_err, "prewarmConnections");
+        return -1;
+    }
+
+    DavixError::clearError(&first_err);
+    return opened;
+}
+
+std::map<std::string, SessionPoolStats> Context::getSessionPoolStats() const{
+    return _intern->_fsess->getSessionPoolStats();
+}
+
+ResponseBufferStats Context::getResponseBufferStats() const{
+    return _intern->_fsess->getResponseBufferStats();
+}
+
+std::map<std::string, LinkStats> Context::getLinkStats() const{
+    std::map<std::string, LinkStats> stats;
+    _intern->_linkEstimator.collectStats(stats);
+    return stats;
 }
 
 HttpRequest* Context::createRequest(const std::string & url, DavixError** err){
@@ -154,6 +307,26 @@ RedirectionResolver & ContextExplorer::RedirectionResolverFromContext(Context &c
     return *c._intern->getRedirectionResolver();
 }
 
+WorkerPool & ContextExplorer::WorkerPoolFromContext(Context &c) {
+    return *c._intern->getWorkerPool();
+}
+
+LinkEstimator & ContextExplorer::LinkEstimatorFromContext(Context &c) {
+    return c._intern->_linkEstimator;
+}
+
+BlockCache & ContextExplorer::BlockCacheFromContext(Context &c) {
+    return c._intern->_blockCache;
+}
+
+DiskCache & ContextExplorer::DiskCacheFromContext(Context &c) {
+    return c._intern->_diskCache;
+}
+
+StatCache & ContextExplorer::StatCacheFromContext(Context &c) {
+    return c._intern->_statCache;
+}
+
 LibPath::LibPath(){
     Dl_info shared_lib_infos;
 
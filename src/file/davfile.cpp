@@ -23,6 +23,8 @@
 #include <core/ContentProvider.hpp>
 #include <file/davfile.hpp>
 #include <fileops/chain_factory.hpp>
+#include <core/WorkerPool.hpp>
+#include <davix_context_internal.hpp>
 
 namespace Davix{
 
@@ -169,6 +171,34 @@ dav_ssize_t DavFile::readPartial(const RequestParams *params, void* buff, dav_si
     return -1;
 }
 
+static dav_ssize_t readPartialWithParams(Context & c, const Uri & u, const RequestParams & params,
+                                          void* buff, dav_size_t count, dav_off_t offset){
+    HttpIOChain chain;
+    IOChainContext io_context(c, u, &params);
+    return ChainFactory::instanceChain(CreationFlags(), chain).pread(io_context, buff, count, offset);
+}
+
+std::future<dav_ssize_t> DavFile::readPartialAsync(const RequestParams *params, void* buff, dav_size_t count, dav_off_t offset){
+    Context & c = d_ptr->_c;
+    const Uri u = d_ptr->_u;
+    const RequestParams p = (params)?(*params):(d_ptr->_params);
+
+    return ContextExplorer::WorkerPoolFromContext(c).async<dav_ssize_t>([&c, u, p, buff, count, offset]() {
+        return readPartialWithParams(c, u, p, buff, count, offset);
+    });
+}
+
+void DavFile::readPartialAsync(const RequestParams *params, void* buff, dav_size_t count, dav_off_t offset,
+                               const AsyncCompletionCallback & callback){
+    Context & c = d_ptr->_c;
+    const Uri u = d_ptr->_u;
+    const RequestParams p = (params)?(*params):(d_ptr->_params);
+
+    ContextExplorer::WorkerPoolFromContext(c).async([&c, u, p, buff, count, offset]() {
+        return readPartialWithParams(c, u, p, buff, count, offset);
+    }, callback);
+}
+
 int DavFile::deletion(const RequestParams *params, DavixError **err) throw(){
     TRY_DAVIX{
         deletion(params);
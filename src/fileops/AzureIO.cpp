@@ -20,6 +20,7 @@
 */
 
 #include "AzureIO.hpp"
+#include "ChunkedUpload.hpp"
 #include <utils/davix_logger_internal.hpp>
 #include <core/ContentProvider.hpp>
 
@@ -128,33 +129,29 @@ dav_ssize_t AzureIO::writeFromProvider(IOChainContext & iocontext, ContentProvid
     CHAIN_FORWARD(writeFromProvider(iocontext, provider));
   }
 
-  std::vector<std::string> blockIDs;
-
-  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Azure write: size {}, splitting into blocks", provider.getSize());
-  std::vector<char> buffer;
+  dav_size_t blockSize = iocontext._reqparams->getUploadChunkSize();
+  if(blockSize == 0) {
+    blockSize = 1024 * 1024 * 100; // 100 MB
+  }
 
-  const dav_size_t MAX_CHUNK_SIZE = 1024 * 1024 * 100; // 100 MB
-  buffer.resize(std::min(MAX_CHUNK_SIZE, (dav_size_t) provider.getSize()) + 10);
+  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Azure write: size {}, splitting into blocks of {}", provider.getSize(), blockSize);
 
   // generate UUID to use as blockid prefix
-  std::string prefix = get_uuid();
-
-  size_t blockid = 0;
-  size_t remaining = provider.getSize();
-  while(remaining > 0) {
-    size_t toRead = std::min( (dav_size_t) provider.getSize(), MAX_CHUNK_SIZE);
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Azure write: toRead from cb {}", toRead);
+  const std::string prefix = get_uuid();
 
-    size_t bytesRead = provider.pullBytes(buffer.data(), toRead);
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Azure write: bytesRead from cb {}", bytesRead);
-    if(bytesRead == 0) break; // EOF?
-
-    blockIDs.push_back(stringifyBlockID(prefix, blockid));
-    writeChunk(iocontext, buffer.data(), bytesRead, blockIDs.back());
-    blockid++;
-
-    remaining -= bytesRead;
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Azure write: remaining bytes {}", remaining);
+  // an empty block list commits an empty blob
+  std::vector<std::string> blockIDs;
+  if(provider.getSize() != 0) {
+    std::vector<UploadedChunk> blocks = uploadChunks(iocontext, provider, blockSize,
+      [&](const char *buffer, dav_size_t size, size_t index) {
+        std::string blockid = stringifyBlockID(prefix, index);
+        writeChunk(iocontext, buffer, size, blockid);
+        return blockid;
+      });
+
+    for(size_t i = 0; i < blocks.size(); i++) {
+      blockIDs.emplace_back(blocks[i].tag);
+    }
   }
 
   // Now let's commit the blobs
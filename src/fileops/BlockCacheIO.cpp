@@ -0,0 +1,249 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "BlockCacheIO.hpp"
+#include <fileops/iobuffmap.hpp>
+#include <utils/davix_logger_internal.hpp>
+#include <davix_context_internal.hpp>
+#include <core/WorkerPool.hpp>
+#include <cstring>
+
+namespace Davix {
+
+static const dav_size_t kBlockSize = DAVIX_BLOCK_CACHE_BLOCK_SIZE;
+
+//------------------------------------------------------------------------------
+// Reads started over because the file changed, before giving up
+//------------------------------------------------------------------------------
+static const size_t kMaxRestarts = 3;
+
+BlockCacheIO::BlockCacheIO() : HttpIOChain() {}
+
+BlockCacheIO::~BlockCacheIO() {}
+
+//------------------------------------------------------------------------------
+// Fetch a block from the server, along with the ETag of the file
+//------------------------------------------------------------------------------
+BlockCache::Block BlockCacheIO::fetchBlock(IOChainContext & iocontext, dav_off_t index, std::string &etag) {
+  DavixError *tmp_err = NULL;
+  BlockCache::Block block = fetch_range_request(iocontext._context, iocontext._uri, *iocontext._reqparams,
+                                                index * kBlockSize, kBlockSize, &etag, &tmp_err);
+  checkDavixError(&tmp_err);
+
+  if(!block) {
+    // whole file returned, ranges not supported - leave it to the rest of the chain
+    iocontext.rangeIgnored = true;
+  }
+
+  return block;
+}
+
+//------------------------------------------------------------------------------
+// Get a block from the cache, fetching it if needed
+//------------------------------------------------------------------------------
+BlockCache::Block BlockCacheIO::getBlock(IOChainContext & iocontext, BlockCache &cache, dav_off_t index, std::string &validator) {
+  const std::string url = iocontext._uri.getString();
+  validator = cache.getValidator(url);
+  const std::string key = BlockCache::makeKey(url, validator, index);
+
+  // not checked for a while: fetch the block again, and see whether the
+  // file changed
+  const bool validated = cache.isValidated(url, std::chrono::seconds(DAVIX_BLOCK_CACHE_REVALIDATE));
+  if(!validated) {
+    cache.drop(key);
+  }
+
+  std::string etag;
+  bool fetched = false;
+  BlockCache::Block block = cache.get(key, [&]() {
+    fetched = true;
+    return fetchBlock(iocontext, index, etag);
+  });
+
+  if(block && fetched && (!validated || etag != validator)) {
+    cache.setValidator(url, etag);
+
+    // a new ETag means the file changed, and everything cached under the
+    // old one is stale
+    if(etag != validator) {
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "ETag of {} is now {}, dropping its cached blocks", url, etag);
+      cache.insert(BlockCache::makeKey(url, etag, index), block);
+      validator = etag;
+    }
+  }
+
+  return block;
+}
+
+//------------------------------------------------------------------------------
+// Positional read through the block cache
+//------------------------------------------------------------------------------
+dav_ssize_t BlockCacheIO::pread(IOChainContext & iocontext, void* buf, dav_size_t count, dav_off_t offset) {
+  BlockCache &cache = ContextExplorer::BlockCacheFromContext(iocontext._context);
+  const dav_size_t capacity = cache.getCapacity();
+
+  // large reads would only flush the cache, and without range support each
+  // block would cost a download of the whole file
+  const std::string url = iocontext._uri.getString();
+  if(count == 0 || capacity == 0 || count > capacity / 4 || iocontext.bypassCaches || cache.isRangeless(url)) {
+    const dav_ssize_t ret = HttpIOChain::pread(iocontext, buf, count, offset);
+    if(iocontext.rangeIgnored && capacity != 0) {
+      cache.setRangeless(url);
+    }
+    return ret;
+  }
+
+  char *out = static_cast<char*>(buf);
+  dav_size_t done = 0;
+  std::string version;
+  size_t restarts = 0;
+
+  while(done < count) {
+    const dav_off_t pos = offset + done;
+    const dav_off_t index = pos / kBlockSize;
+
+    std::string validator;
+    BlockCache::Block block = getBlock(iocontext, cache, index, validator);
+
+    // the file changed since the previous blocks: start over, not to mix
+    // two versions of it
+    if(block && done > 0 && validator != version) {
+      if(++restarts > kMaxRestarts) {
+        throw DavixException(davix_scope_io_buff(), StatusCode::InvalidServerResponse,
+                             fmt::format("{} keeps changing while being read", iocontext._uri));
+      }
+
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "{} changed during a read, reading again from {}", iocontext._uri, offset);
+      done = 0;
+      continue;
+    }
+    version = validator;
+
+    if(!block) {
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "No range support for {}, bypassing the block cache", iocontext._uri);
+      cache.setRangeless(url);
+      return done + HttpIOChain::pread(iocontext, out + done, count - done, pos);
+    }
+
+    const dav_size_t inBlock = pos - index * kBlockSize;
+    if(inBlock >= block->size()) {
+      break;
+    }
+
+    const dav_size_t n = std::min<dav_size_t>(count - done, block->size() - inBlock);
+    memcpy(out + done, block->data() + inBlock, n);
+    done += n;
+
+    // a short block is the last one
+    if(block->size() < kBlockSize) {
+      break;
+    }
+  }
+
+  return done;
+}
+
+//------------------------------------------------------------------------------
+// Fetch the blocks covering the given range into the cache, in the background
+//------------------------------------------------------------------------------
+void BlockCacheIO::prefetchBlocks(IOChainContext & iocontext, dav_off_t offset, dav_size_t size) {
+  // the task may outlive the descriptor
+  Context &context = iocontext._context;
+  const Uri uri = iocontext._uri;
+  const RequestParams params(*iocontext._reqparams);
+  const dav_off_t first = offset / kBlockSize;
+  const dav_off_t last = (offset + size - 1) / kBlockSize;
+
+  ContextExplorer::WorkerPoolFromContext(context).submit([&context, uri, params, first, last]() {
+    BlockCache &cache = ContextExplorer::BlockCacheFromContext(context);
+    IOChainContext prefetch_context(context, uri, &params);
+
+    try {
+      for(dav_off_t index = first; index <= last; index++) {
+        std::string validator;
+        BlockCache::Block block = getBlock(prefetch_context, cache, index, validator);
+        if(!block) {
+          cache.setRangeless(uri.getString());
+          return;
+        }
+
+        // a short block is the last one
+        if(block->size() < kBlockSize) {
+          return;
+        }
+      }
+    }
+    catch(DavixException &e) {
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Prefetch of {} into the block cache failed: {}", uri, e.what());
+    }
+  });
+}
+
+//------------------------------------------------------------------------------
+// Fetch announced ranges into the block cache
+//------------------------------------------------------------------------------
+void BlockCacheIO::prefetchInfo(IOChainContext & iocontext, off_t offset, dav_size_t size_read, advise_t adv) {
+  BlockCache &cache = ContextExplorer::BlockCacheFromContext(iocontext._context);
+  const dav_size_t capacity = cache.getCapacity();
+
+  // only ranges which pread will take from the cache, the access pattern
+  // still goes down the chain
+  if((adv == AdviseRandom || adv == AdviseWillNeed) && size_read > 0 && capacity != 0 && size_read <= capacity / 4 &&
+     !iocontext.bypassCaches && !cache.isRangeless(iocontext._uri.getString())) {
+    prefetchBlocks(iocontext, offset, size_read);
+    size_read = 0;
+  }
+
+  HttpIOChain::prefetchInfo(iocontext, offset, size_read, adv);
+}
+
+//------------------------------------------------------------------------------
+// Write, dropping the cached blocks of the file
+//------------------------------------------------------------------------------
+dav_ssize_t BlockCacheIO::writeFromProvider(IOChainContext & iocontext, ContentProvider &provider) {
+  BlockCache &cache = ContextExplorer::BlockCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri.getString());
+  dav_ssize_t ret = HttpIOChain::writeFromProvider(iocontext, provider);
+  // blocks read while the upload was in progress may be stale as well
+  cache.invalidate(iocontext._uri.getString());
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+// Delete, dropping the cached blocks of the file
+//------------------------------------------------------------------------------
+void BlockCacheIO::deleteResource(IOChainContext & iocontext) {
+  ContextExplorer::BlockCacheFromContext(iocontext._context).invalidate(iocontext._uri.getString());
+  HttpIOChain::deleteResource(iocontext);
+}
+
+//------------------------------------------------------------------------------
+// Move, dropping the cached blocks of both source and target
+//------------------------------------------------------------------------------
+void BlockCacheIO::move(IOChainContext & iocontext, const std::string & target_url) {
+  BlockCache &cache = ContextExplorer::BlockCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri.getString());
+  cache.invalidate(Uri(target_url).getString());
+  HttpIOChain::move(iocontext, target_url);
+}
+
+}
@@ -0,0 +1,89 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_FILEOPS_BLOCK_CACHE_IO_HPP
+#define DAVIX_FILEOPS_BLOCK_CACHE_IO_HPP
+
+#include <fileops/httpiochain.hpp>
+#include <core/BlockCache.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Serves positional reads out of the block cache of the Context, when the
+// cache is enabled. Reads are split into aligned blocks of
+// DAVIX_BLOCK_CACHE_BLOCK_SIZE bytes, missing blocks are fetched with one
+// range request each. Files whose server ignores range requests are
+// remembered, and read through the rest of the chain from then on.
+//
+// Cached blocks are used for DAVIX_BLOCK_CACHE_REVALIDATE seconds after the
+// ETag of their file was last seen, the next block is fetched after that. A
+// read spanning blocks of two versions of a file starts over.
+//
+// Ranges announced with AdviseRandom or AdviseWillNeed which the cache will
+// serve are fetched into it in the background, rather than by the prefetching
+// of HttpIOBuffer further down, so that they are downloaded once.
+//
+// Writes, deletions and moves going through the chain drop the cached blocks
+// of the affected files.
+//------------------------------------------------------------------------------
+class BlockCacheIO : public HttpIOChain {
+public:
+  BlockCacheIO();
+  ~BlockCacheIO();
+
+  // position independant read operation
+  virtual dav_ssize_t pread(IOChainContext & iocontext, void* buf, dav_size_t count, dav_off_t offset);
+
+  // fetch announced ranges into the block cache
+  virtual void prefetchInfo(IOChainContext & iocontext, off_t offset, dav_size_t size_read, advise_t adv);
+
+  // write from content provider
+  virtual dav_ssize_t writeFromProvider(IOChainContext & iocontext, ContentProvider &provider);
+
+  // delete resource
+  virtual void deleteResource(IOChainContext & iocontext);
+
+  // move/rename resource
+  virtual void move(IOChainContext & iocontext, const std::string & target_url);
+
+private:
+  //----------------------------------------------------------------------------
+  // Get a block from the cache, fetching it if needed, along with the
+  // validator of the version of the file it belongs to - NULL if the server
+  // doesn't support range requests
+  //----------------------------------------------------------------------------
+  static BlockCache::Block getBlock(IOChainContext & iocontext, BlockCache &cache, dav_off_t index, std::string &validator);
+
+  //----------------------------------------------------------------------------
+  // Fetch a block from the server, along with the ETag of the file
+  //----------------------------------------------------------------------------
+  static BlockCache::Block fetchBlock(IOChainContext & iocontext, dav_off_t index, std::string &etag);
+
+  //----------------------------------------------------------------------------
+  // Fetch the blocks covering the given range into the cache, in the
+  // background
+  //----------------------------------------------------------------------------
+  static void prefetchBlocks(IOChainContext & iocontext, dav_off_t offset, dav_size_t size);
+};
+
+}
+
+#endif
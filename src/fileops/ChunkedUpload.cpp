@@ -0,0 +1,158 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "ChunkedUpload.hpp"
+#include <core/ContentProvider.hpp>
+#include <core/WorkerPool.hpp>
+#include <utils/davix_logger_internal.hpp>
+#include <davix_context_internal.hpp>
+#include <atomic>
+#include <mutex>
+#include <unistd.h>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Fill the buffer from the provider - returns less than its size on EOF only
+//------------------------------------------------------------------------------
+static dav_size_t fillChunk(std::vector<char> &buffer, ContentProvider &provider) {
+  dav_size_t filled = 0;
+
+  while(filled < buffer.size()) {
+    ssize_t bytesRead = provider.pullBytes(buffer.data() + filled, buffer.size() - filled);
+    if(bytesRead < 0) {
+      throw DavixException(davix_scope_io_buff(), StatusCode::InvalidFileHandle, fmt::format("Error when reading from callback: {}", bytesRead));
+    }
+
+    if(bytesRead == 0) {
+      break; // EOF
+    }
+
+    filled += bytesRead;
+  }
+
+  return filled;
+}
+
+//------------------------------------------------------------------------------
+// Upload a chunk, retrying on recoverable errors
+//------------------------------------------------------------------------------
+static std::string uploadChunk(const RequestParams &params, const ChunkUploader &upload,
+                               const char *buffer, dav_size_t size, size_t index) {
+  const int maxAttempts = std::max(params.getOperationRetry(), 1);
+
+  for(int attempt = 1; ; attempt++) {
+    try {
+      return upload(buffer, size, index);
+    }
+    catch(DavixException &e) {
+      if(attempt >= maxAttempts || e.code() == StatusCode::PermissionRefused ||
+         e.code() == StatusCode::AuthenticationError || e.code() == StatusCode::OperationTimeout) {
+        throw;
+      }
+
+      DAVIX_SLOG(DAVIX_LOG_VERBOSE, DAVIX_LOG_CHAIN, "Upload of chunk #{} failed: {}. After {} attempts", index, e.what(), attempt);
+    }
+
+    sleep(params.getOperationRetryDelay());
+  }
+}
+
+std::vector<UploadedChunk> uploadChunks(IOChainContext & iocontext, ContentProvider &provider,
+                                        dav_size_t chunkSize, const ChunkUploader &upload) {
+  const RequestParams &params = *iocontext._reqparams;
+
+  // a buffer per stream
+  size_t streams = std::max(params.getUploadStreams(), 1u);
+  if(params.getUploadBufferLimit() > 0) {
+    streams = std::min<size_t>(streams, std::max<dav_size_t>(params.getUploadBufferLimit() / chunkSize, 1));
+  }
+
+  // no need for large buffers if the content is small
+  dav_size_t bufferSize = chunkSize;
+  if(provider.getSize() >= 0) {
+    bufferSize = std::max<dav_size_t>(std::min<dav_size_t>(chunkSize, provider.getSize()), 1);
+  }
+
+  DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Uploading {} bytes to {} in chunks of {}, {} at a time",
+             provider.getSize(), iocontext._uri, chunkSize, streams);
+
+  // guards the provider and the chunk numbering
+  std::mutex readMutex;
+  size_t nextIndex = 0;
+  bool eof = false;
+  std::atomic<bool> failed(false);
+
+  std::mutex resultMutex;
+  std::vector<UploadedChunk> chunks;
+
+  ContextExplorer::WorkerPoolFromContext(iocontext._context).parallelFor(streams, streams, [&](size_t) {
+    std::vector<char> buffer(bufferSize);
+
+    while(true) {
+      size_t index;
+      dav_size_t size;
+
+      {
+        std::lock_guard<std::mutex> lock(readMutex);
+        if(eof || failed) {
+          return;
+        }
+
+        try {
+          size = fillChunk(buffer, provider);
+        }
+        catch(...) {
+          failed = true;
+          throw;
+        }
+
+        // an empty content is still uploaded as one empty chunk
+        if(size == 0 && nextIndex > 0) {
+          eof = true;
+          return;
+        }
+
+        index = nextIndex++;
+        eof = (size < buffer.size());
+      }
+
+      UploadedChunk chunk;
+      chunk.size = size;
+      try {
+        chunk.tag = uploadChunk(params, upload, buffer.data(), size, index);
+      }
+      catch(...) {
+        failed = true;
+        throw;
+      }
+
+      std::lock_guard<std::mutex> lock(resultMutex);
+      if(chunks.size() <= index) {
+        chunks.resize(index + 1);
+      }
+      chunks[index] = chunk;
+    }
+  });
+
+  return chunks;
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_FILEOPS_CHUNKED_UPLOAD_HPP
+#define DAVIX_FILEOPS_CHUNKED_UPLOAD_HPP
+
+#include <fileops/httpiochain.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Davix {
+
+class ContentProvider;
+
+//------------------------------------------------------------------------------
+// A chunk of an upload, once written: what the server returned to identify
+// it when committing the upload (ETag, block ID...), and its size
+//------------------------------------------------------------------------------
+struct UploadedChunk {
+  std::string tag;
+  dav_size_t size;
+};
+
+//------------------------------------------------------------------------------
+// Upload a chunk, given its index - returns its tag
+//------------------------------------------------------------------------------
+typedef std::function<std::string(const char *buffer, dav_size_t size, size_t index)> ChunkUploader;
+
+//------------------------------------------------------------------------------
+// Upload the content of the provider as a sequence of chunks of the given
+// size - S3 parts, Azure blocks, Swift segments. Chunks are read from the
+// provider one after the other, and written by up to getUploadStreams()
+// concurrent requests on the worker pool of the Context, while the next ones
+// are being read. Each request owns a buffer, reused from one chunk to the
+// next, and fewer run if needed to stay within getUploadBufferLimit().
+//
+// A failed chunk is uploaded again, up to getOperationRetry() times. The first
+// chunk to fail for good stops the upload, and its error is rethrown.
+//
+// Returns the chunks in order, for the caller to commit the upload.
+//------------------------------------------------------------------------------
+std::vector<UploadedChunk> uploadChunks(IOChainContext & iocontext, ContentProvider &provider,
+                                        dav_size_t chunkSize, const ChunkUploader &upload);
+
+}
+
+#endif
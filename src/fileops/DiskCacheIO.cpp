@@ -0,0 +1,211 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "DiskCacheIO.hpp"
+#include <utils/davix_logger_internal.hpp>
+#include <davix_context_internal.hpp>
+#include <set>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Most blocks fetched by a single vectored read
+//------------------------------------------------------------------------------
+static const size_t kFetchBatch = 16;
+
+DiskCacheIO::DiskCacheIO() : HttpIOChain() {}
+
+DiskCacheIO::~DiskCacheIO() {}
+
+//------------------------------------------------------------------------------
+// Cache entry of the file, validating it if needed
+//------------------------------------------------------------------------------
+std::shared_ptr<DiskCache::Entry> DiskCacheIO::getEntry(IOChainContext & iocontext, DiskCache &cache) {
+  const std::string url = iocontext._uri.getString();
+
+  std::shared_ptr<DiskCache::Entry> entry;
+  if(cache.lookup(url, std::chrono::seconds(DAVIX_DISK_CACHE_REVALIDATE), entry)) {
+    return entry;
+  }
+
+  StatInfo st;
+  HttpIOChain::statInfo(iocontext, st);
+
+  // without a modification time, we'd never notice the file changed
+  std::string validator;
+  if(st.mtime != 0) {
+    validator = std::to_string(st.size) + ":" + std::to_string(st.mtime);
+  }
+
+  return cache.open(url, validator, st.size);
+}
+
+//------------------------------------------------------------------------------
+// Fetch the given blocks and store them
+//------------------------------------------------------------------------------
+void DiskCacheIO::fetchBlocks(IOChainContext & iocontext, DiskCache &cache, DiskCache::Entry &entry,
+                              const std::vector<dav_off_t> &blocks) {
+  const dav_size_t blockSize = entry.blockSize();
+  std::vector<char> buffer(std::min(blocks.size(), kFetchBatch) * blockSize);
+
+  for(size_t start = 0; start < blocks.size(); start += kFetchBatch) {
+    const size_t n = std::min(blocks.size() - start, kFetchBatch);
+
+    std::vector<DavIOVecInput> input(n);
+    std::vector<DavIOVecOuput> output(n);
+
+    for(size_t i = 0; i < n; i++) {
+      const dav_off_t offset = blocks[start + i] * blockSize;
+      input[i].diov_buffer = buffer.data() + i * blockSize;
+      input[i].diov_offset = offset;
+      input[i].diov_size = std::min<dav_size_t>(blockSize, entry.fileSize() - offset);
+    }
+
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Fetching {} blocks of {} into the disk cache", n, iocontext._uri);
+    // a context of its own: the caller's one may be shared by concurrent reads
+    IOChainContext fetch_context(iocontext._context, iocontext._uri, iocontext._reqparams);
+    fetch_context.bypassCaches = true;
+    HttpIOChain::preadVec(fetch_context, input.data(), output.data(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      // a short block means the file changed under our feet, leave it out
+      if(output[i].diov_size == (dav_ssize_t) input[i].diov_size &&
+         entry.writeBlock(blocks[start + i], static_cast<const char*>(input[i].diov_buffer), input[i].diov_size)) {
+        cache.written(input[i].diov_size);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Serve the given ranges from the cache, fetching missing blocks first
+//------------------------------------------------------------------------------
+dav_ssize_t DiskCacheIO::readThrough(IOChainContext & iocontext, DiskCache &cache, DiskCache::Entry &entry,
+                                     const DavIOVecInput * input_vec, DavIOVecOuput * output_vec, const dav_size_t count_vec) {
+  const dav_size_t fileSize = entry.fileSize();
+  const dav_size_t blockSize = entry.blockSize();
+
+  std::set<dav_off_t> missing;
+  for(dav_size_t i = 0; i < count_vec; i++) {
+    const dav_off_t offset = input_vec[i].diov_offset;
+    if(input_vec[i].diov_size == 0 || offset >= (dav_off_t) fileSize) {
+      continue;
+    }
+
+    const dav_size_t size = std::min<dav_size_t>(input_vec[i].diov_size, fileSize - offset);
+    std::vector<dav_off_t> blocks = entry.missingBlocks(offset / blockSize, (offset + size - 1) / blockSize);
+    missing.insert(blocks.begin(), blocks.end());
+  }
+
+  if(!missing.empty()) {
+    fetchBlocks(iocontext, cache, entry, std::vector<dav_off_t>(missing.begin(), missing.end()));
+  }
+
+  dav_ssize_t total = 0;
+  for(dav_size_t i = 0; i < count_vec; i++) {
+    const dav_off_t offset = input_vec[i].diov_offset;
+    char *buffer = static_cast<char*>(input_vec[i].diov_buffer);
+
+    dav_size_t size = 0;
+    if(offset < (dav_off_t) fileSize) {
+      size = std::min<dav_size_t>(input_vec[i].diov_size, fileSize - offset);
+    }
+
+    dav_ssize_t ret = size;
+    if(!entry.read(buffer, size, offset)) {
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Disk cache miss after fetch for {}, reading remotely", iocontext._uri);
+      ret = HttpIOChain::pread(iocontext, buffer, input_vec[i].diov_size, offset);
+    }
+
+    output_vec[i].diov_buffer = buffer;
+    output_vec[i].diov_size = ret;
+    total += ret;
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Positional read through the disk cache
+//------------------------------------------------------------------------------
+dav_ssize_t DiskCacheIO::pread(IOChainContext & iocontext, void* buf, dav_size_t count, dav_off_t offset) {
+  DiskCache &cache = ContextExplorer::DiskCacheFromContext(iocontext._context);
+
+  std::shared_ptr<DiskCache::Entry> entry;
+  if(count == 0 || iocontext.bypassCaches || !cache.enabled() || !(entry = getEntry(iocontext, cache))) {
+    CHAIN_FORWARD(pread(iocontext, buf, count, offset));
+  }
+
+  DavIOVecInput input;
+  input.diov_buffer = buf;
+  input.diov_offset = offset;
+  input.diov_size = count;
+
+  DavIOVecOuput output;
+  return readThrough(iocontext, cache, *entry, &input, &output, 1);
+}
+
+//------------------------------------------------------------------------------
+// Vectored read through the disk cache
+//------------------------------------------------------------------------------
+dav_ssize_t DiskCacheIO::preadVec(IOChainContext & iocontext, const DavIOVecInput * input_vec,
+                                  DavIOVecOuput * output_vec, const dav_size_t count_vec) {
+  DiskCache &cache = ContextExplorer::DiskCacheFromContext(iocontext._context);
+
+  std::shared_ptr<DiskCache::Entry> entry;
+  if(count_vec == 0 || iocontext.bypassCaches || !cache.enabled() || !(entry = getEntry(iocontext, cache))) {
+    CHAIN_FORWARD(preadVec(iocontext, input_vec, output_vec, count_vec));
+  }
+
+  return readThrough(iocontext, cache, *entry, input_vec, output_vec, count_vec);
+}
+
+//------------------------------------------------------------------------------
+// Write, dropping the cached blocks of the file
+//------------------------------------------------------------------------------
+dav_ssize_t DiskCacheIO::writeFromProvider(IOChainContext & iocontext, ContentProvider &provider) {
+  DiskCache &cache = ContextExplorer::DiskCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri.getString());
+  dav_ssize_t ret = HttpIOChain::writeFromProvider(iocontext, provider);
+  cache.invalidate(iocontext._uri.getString());
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+// Delete, dropping the cached blocks of the file
+//------------------------------------------------------------------------------
+void DiskCacheIO::deleteResource(IOChainContext & iocontext) {
+  ContextExplorer::DiskCacheFromContext(iocontext._context).invalidate(iocontext._uri.getString());
+  HttpIOChain::deleteResource(iocontext);
+}
+
+//------------------------------------------------------------------------------
+// Move, dropping the cached blocks of both source and target
+//------------------------------------------------------------------------------
+void DiskCacheIO::move(IOChainContext & iocontext, const std::string & target_url) {
+  DiskCache &cache = ContextExplorer::DiskCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri.getString());
+  cache.invalidate(Uri(target_url).getString());
+  HttpIOChain::move(iocontext, target_url);
+}
+
+}
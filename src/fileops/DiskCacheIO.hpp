@@ -0,0 +1,83 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_FILEOPS_DISK_CACHE_IO_HPP
+#define DAVIX_FILEOPS_DISK_CACHE_IO_HPP
+
+#include <fileops/httpiochain.hpp>
+#include <core/DiskCache.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Serves positional and vectored reads out of the disk cache of the Context,
+// when the cache is enabled. Blocks missing from the cache are fetched with
+// a single vectored read through the rest of the chain, and stored.
+//
+// Files are validated by their size and modification time, as reported by
+// statInfo, once every DAVIX_DISK_CACHE_REVALIDATE seconds. Writes,
+// deletions and moves going through the chain drop the cached blocks of the
+// affected files.
+//------------------------------------------------------------------------------
+class DiskCacheIO : public HttpIOChain {
+public:
+  DiskCacheIO();
+  ~DiskCacheIO();
+
+  // position independant read operation
+  virtual dav_ssize_t pread(IOChainContext & iocontext, void* buf, dav_size_t count, dav_off_t offset);
+
+  // vectored read
+  virtual dav_ssize_t preadVec(IOChainContext & iocontext, const DavIOVecInput * input_vec,
+                            DavIOVecOuput * output_vec,
+                            const dav_size_t count_vec);
+
+  // write from content provider
+  virtual dav_ssize_t writeFromProvider(IOChainContext & iocontext, ContentProvider &provider);
+
+  // delete resource
+  virtual void deleteResource(IOChainContext & iocontext);
+
+  // move/rename resource
+  virtual void move(IOChainContext & iocontext, const std::string & target_url);
+
+private:
+  //----------------------------------------------------------------------------
+  // Cache entry of the file, validating it if needed - NULL if the file
+  // can't be cached
+  //----------------------------------------------------------------------------
+  std::shared_ptr<DiskCache::Entry> getEntry(IOChainContext & iocontext, DiskCache &cache);
+
+  //----------------------------------------------------------------------------
+  // Serve the given ranges from the cache, fetching missing blocks first
+  //----------------------------------------------------------------------------
+  dav_ssize_t readThrough(IOChainContext & iocontext, DiskCache &cache, DiskCache::Entry &entry,
+                          const DavIOVecInput * input_vec, DavIOVecOuput * output_vec, const dav_size_t count_vec);
+
+  //----------------------------------------------------------------------------
+  // Fetch the given blocks and store them
+  //----------------------------------------------------------------------------
+  void fetchBlocks(IOChainContext & iocontext, DiskCache &cache, DiskCache::Entry &entry,
+                   const std::vector<dav_off_t> &blocks);
+};
+
+}
+
+#endif
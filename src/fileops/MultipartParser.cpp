@@ -0,0 +1,270 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "MultipartParser.hpp"
+#include <fileops/fileutils.hpp>
+#include <utils/stringutils.hpp>
+#include <cstring>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Longest line accepted outside of payloads
+//------------------------------------------------------------------------------
+static const dav_size_t kMaxLineLength = DAVIX_READ_BLOCK_SIZE;
+
+//------------------------------------------------------------------------------
+// Most lines accepted in between two parts, or in the headers of a part
+//------------------------------------------------------------------------------
+static const int kMaxLines = 100;
+
+static const std::string multipartScope() {
+  return "Davix::HttpIOVecOps";
+}
+
+static void setupErrorMultiPart(DavixError **err) {
+  DavixError::setupError(err, multipartScope(), StatusCode::InvalidServerResponse, "Invalid Multi-Part HTTP response");
+}
+
+static void setupErrorTooLong(DavixError **err) {
+  DavixError::setupError(err, multipartScope(), StatusCode::InvalidServerResponse, "Invalid Multi-Part HTTP, Multi-part header too long");
+}
+
+static bool isBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+//------------------------------------------------------------------------------
+// Parse a decimal number at [p, end), advance p past it
+//------------------------------------------------------------------------------
+static bool parseNumber(const char *&p, const char *end, dav_off_t &value) {
+  const char *start = p;
+  value = 0;
+
+  while(p < end && *p >= '0' && *p <= '9') {
+    if(value > (std::numeric_limits<dav_off_t>::max() - 9) / 10) {
+      return false;
+    }
+
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+
+  return p != start;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+MultipartParser::MultipartParser(const std::string &boundary, const PayloadCallback &callback)
+: _delimiter("--" + boundary), _callback(callback), _state(kDelimiter), _firstPart(true),
+  _hasRange(false), _skipped(0), _offset(0), _remaining(0), _payloadBytes(0) {}
+
+//------------------------------------------------------------------------------
+// Feed the next block of the response body
+//------------------------------------------------------------------------------
+dav_ssize_t MultipartParser::feed(const char *data, dav_size_t size, DavixError **err) {
+  const char *p = data;
+  const char *end = data + size;
+
+  while(p < end && _state != kDone) {
+    if(_state == kPayload) {
+      dav_size_t n = std::min<dav_size_t>(_remaining, end - p);
+      _callback(_offset, p, n);
+
+      _offset += n;
+      _remaining -= n;
+      _payloadBytes += n;
+      p += n;
+
+      if(_remaining == 0) {
+        _state = kDelimiter;
+        _firstPart = false;
+      }
+
+      continue;
+    }
+
+    const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if(eol == NULL) {
+      _line.append(p, end - p);
+      p = end;
+    }
+    else {
+      const char *line = p;
+      dav_size_t len = eol - p;
+
+      if(!_line.empty()) {
+        _line.append(p, len);
+        line = _line.data();
+        len = _line.size();
+      }
+
+      if(len > 0 && line[len-1] == '\r') {
+        len--;
+      }
+
+      p = eol + 1;
+
+      bool ok = (len <= kMaxLineLength) && processLine(line, len, err);
+      _line.clear();
+
+      if(!ok) {
+        if(err != NULL && *err == NULL) {
+          setupErrorTooLong(err);
+        }
+        return -1;
+      }
+    }
+
+    if(_line.size() > kMaxLineLength) {
+      setupErrorTooLong(err);
+      return -1;
+    }
+  }
+
+  return p - data;
+}
+
+//------------------------------------------------------------------------------
+// Process one complete line, CRLF stripped
+//------------------------------------------------------------------------------
+bool MultipartParser::processLine(const char *line, dav_size_t len, DavixError **err) {
+  if(++_skipped > kMaxLines) {
+    setupErrorTooLong(err);
+    return false;
+  }
+
+  if(_state == kHeaders) {
+    if(len != 0) {
+      return processHeader(line, len, err);
+    }
+
+    if(!_hasRange) {
+      setupErrorMultiPart(err);
+      return false;
+    }
+
+    _state = kPayload;
+    _skipped = 0;
+    return true;
+  }
+
+  // _state == kDelimiter: the payload is followed by a CRLF, which belongs
+  // to the delimiter, and there may be a preamble before the first part
+  if(len == 0) {
+    return true;
+  }
+
+  if(len >= _delimiter.size() && memcmp(line, _delimiter.data(), _delimiter.size()) == 0) {
+    const char *tail = line + _delimiter.size();
+    const char *end = line + len;
+
+    if(end - tail >= 2 && tail[0] == '-' && tail[1] == '-') {
+      _state = kDone;
+      return true;
+    }
+
+    while(tail < end && isBlank(*tail)) {
+      tail++;
+    }
+
+    if(tail == end) {
+      _state = kHeaders;
+      _hasRange = false;
+      _skipped = 0;
+      return true;
+    }
+  }
+
+  if(_firstPart) {
+    return true;
+  }
+
+  DavixError::setupError(err, multipartScope(), StatusCode::InvalidServerResponse,
+    std::string("Invalid boundary for multipart http response :").append(_delimiter.substr(2)));
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Parse a part header, pick up the byte range if it's a Content-Range
+//------------------------------------------------------------------------------
+bool MultipartParser::processHeader(const char *line, dav_size_t len, DavixError **err) {
+  const char *end = line + len;
+  const char *colon = static_cast<const char*>(memchr(line, ':', len));
+  if(colon == NULL) {
+    setupErrorMultiPart(err);
+    return false;
+  }
+
+  if((dav_size_t) (colon - line) != ans_header_byte_range.size() ||
+     StrUtil::compare_ncase(ans_header_byte_range, 0, ans_header_byte_range.size(), line) != 0) {
+    return true;
+  }
+
+  // Content-Range: bytes <first>-<last>/<total or *>
+  const char *p = colon + 1;
+  while(p < end && isBlank(*p)) {
+    p++;
+  }
+
+  if(end - p < 5 || strncasecmp(p, "bytes", 5) != 0) {
+    setupErrorMultiPart(err);
+    return false;
+  }
+
+  p += 5;
+  while(p < end && isBlank(*p)) {
+    p++;
+  }
+
+  dav_off_t first, last;
+  if(!parseNumber(p, end, first) || p == end || *p != '-') {
+    setupErrorMultiPart(err);
+    return false;
+  }
+
+  p++;
+  if(!parseNumber(p, end, last) || last < first || (p != end && *p != '/')) {
+    setupErrorMultiPart(err);
+    return false;
+  }
+
+  _offset = first;
+  _remaining = last - first + 1;
+  _hasRange = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Has the closing delimiter been seen?
+//------------------------------------------------------------------------------
+bool MultipartParser::done() const {
+  return _state == kDone;
+}
+
+//------------------------------------------------------------------------------
+// Total size of the part payloads delivered so far
+//------------------------------------------------------------------------------
+dav_size_t MultipartParser::payloadBytes() const {
+  return _payloadBytes;
+}
+
+}
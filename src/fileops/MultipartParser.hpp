@@ -0,0 +1,102 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_FILEOPS_MULTIPART_PARSER_HPP
+#define DAVIX_FILEOPS_MULTIPART_PARSER_HPP
+
+#include <davix_internal.hpp>
+#include <functional>
+#include <string>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Incremental parser of multipart/byteranges response bodies.
+//
+// The body is fed in blocks of any size, as they come off the wire. Part
+// payloads are handed over to the callback as slices of the fed blocks,
+// together with the file offset they start at - no intermediate copy is
+// made. A single part may be delivered in several slices, when it spans
+// several blocks.
+//
+// Only the lines around the payloads - delimiters, part headers - are
+// scanned, payload lengths come from the Content-Range part headers.
+//------------------------------------------------------------------------------
+class MultipartParser {
+public:
+  typedef std::function<void(dav_off_t offset, const char *data, dav_size_t size)> PayloadCallback;
+
+  //----------------------------------------------------------------------------
+  // Constructor - boundary as given in the Content-Type response header
+  //----------------------------------------------------------------------------
+  MultipartParser(const std::string &boundary, const PayloadCallback &callback);
+
+  //----------------------------------------------------------------------------
+  // Feed the next block of the response body. Returns the number of bytes
+  // consumed, which is less than size only once the closing delimiter has
+  // been seen, or -1 on malformed input.
+  //----------------------------------------------------------------------------
+  dav_ssize_t feed(const char *data, dav_size_t size, DavixError **err);
+
+  //----------------------------------------------------------------------------
+  // Has the closing delimiter been seen?
+  //----------------------------------------------------------------------------
+  bool done() const;
+
+  //----------------------------------------------------------------------------
+  // Total size of the part payloads delivered so far
+  //----------------------------------------------------------------------------
+  dav_size_t payloadBytes() const;
+
+private:
+  enum State { kDelimiter, kHeaders, kPayload, kDone };
+
+  //----------------------------------------------------------------------------
+  // Process one complete line, CRLF stripped
+  //----------------------------------------------------------------------------
+  bool processLine(const char *line, dav_size_t len, DavixError **err);
+
+  //----------------------------------------------------------------------------
+  // Parse a part header, pick up the byte range if it's a Content-Range
+  //----------------------------------------------------------------------------
+  bool processHeader(const char *line, dav_size_t len, DavixError **err);
+
+  std::string _delimiter;
+  PayloadCallback _callback;
+
+  State _state;
+  bool _firstPart;
+  bool _hasRange;
+
+  // lines, until complete when they span several blocks
+  std::string _line;
+  // lines skipped while looking for a delimiter
+  int _skipped;
+
+  // current part
+  dav_off_t _offset;
+  dav_size_t _remaining;
+
+  dav_size_t _payloadBytes;
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 */
 
 #include "S3IO.hpp"
+#include "ChunkedUpload.hpp"
 #include <core/ContentProvider.hpp>
 #include <utils/davix_logger_internal.hpp>
 #include <xml/S3MultiPartInitiationParser.hpp>
@@ -28,6 +29,8 @@
 
 namespace Davix{
 
+static const dav_size_t S3_MIN_PART_SIZE = 1024 * 1024 * 5; // 5 MB
+
 static bool is_s3_operation(IOChainContext & context){
   if(context._reqparams->getProtocol() == RequestProtocol::AwsS3) {
     return true;
@@ -46,7 +49,7 @@ static bool should_use_s3_multipart(IOChainContext & context, dav_size_t size) {
     return true;
   }
 
-  return size > (1024 * 1024 * 512); // 512 MB
+  return size > context._reqparams->getUploadThreshold();
 }
 
 S3IO::S3IO() {
@@ -120,6 +123,7 @@ std::string S3IO::writeChunk(IOChainContext & iocontext, const char* buff, dav_s
   if(!req.getAnswerHeader("Etag", etag)) {
     DavixError::setupError(&tmp_err, "S3::MultiPart", StatusCode::InvalidServerResponse, "Unable to retrieve chunk Etag, necessary when committing chunks");
   }
+  checkDavixError(&tmp_err);
 
   DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "chunk #{} written successfully, etag: {}", partNumber, etag);
   return etag;
@@ -163,7 +167,7 @@ static dav_size_t fillBufferWithProviderData(std::vector<char> &buffer, const da
     dav_size_t remaining = maxChunkSize;
 
     while(true) {
-      dav_ssize_t bytesRead = provider.pullBytes(buffer.data(), remaining);
+      dav_ssize_t bytesRead = provider.pullBytes(buffer.data() + written, remaining);
       if(bytesRead < 0) {
         throw DavixException(davix_scope_io_buff(), StatusCode::InvalidFileHandle, fmt::format("Error when reading from callback: {}", bytesRead));
       }
@@ -195,24 +199,25 @@ dav_ssize_t S3IO::writeFromProvider(IOChainContext & iocontext, ContentProvider
   DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Initiating multi-part upload towards {} to upload file with size {}", iocontext._uri, provider.getSize());
   std::string uploadId = initiateMultipart(iocontext);
 
-  size_t remaining = provider.getSize();
-  const dav_size_t MAX_CHUNK_SIZE = 1024 * 1024 * 256; // 256 MB
-
-  std::vector<char> buffer;
-  buffer.resize(std::min(MAX_CHUNK_SIZE, (dav_size_t) provider.getSize()) + 10);
-
-  std::vector<std::string> etags;
+  dav_size_t chunkSize = iocontext._reqparams->getUploadChunkSize();
+  if(chunkSize == 0) {
+    chunkSize = 1024 * 1024 * 256; // 256 MB
+  }
 
-  size_t partNumber = 0;
-  while(remaining > 0) {
-    size_t toRead = std::min( (dav_size_t) provider.getSize(), MAX_CHUNK_SIZE);
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "S3IO write: toRead from cb {}", toRead);
+  // S3 rejects parts under 5 MB, except for the last one
+  if(chunkSize < S3_MIN_PART_SIZE) {
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Part size of {} bytes too small for S3, using {}", chunkSize, S3_MIN_PART_SIZE);
+    chunkSize = S3_MIN_PART_SIZE;
+  }
 
-    dav_size_t bytesRead = fillBufferWithProviderData(buffer, MAX_CHUNK_SIZE, provider);
-    if(bytesRead == 0) break; // EOF
+  std::vector<UploadedChunk> chunks = uploadChunks(iocontext, provider, chunkSize,
+    [&](const char *buffer, dav_size_t size, size_t index) {
+      return writeChunk(iocontext, buffer, size, uploadId, index + 1);
+    });
 
-    partNumber++;
-    etags.emplace_back(writeChunk(iocontext, buffer.data(), bytesRead, uploadId, partNumber));
+  std::vector<std::string> etags;
+  for(size_t i = 0; i < chunks.size(); i++) {
+    etags.emplace_back(chunks[i].tag);
   }
 
   commitChunks(iocontext, uploadId, etags);
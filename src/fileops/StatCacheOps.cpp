@@ -0,0 +1,130 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include "StatCacheOps.hpp"
+#include <utils/davix_logger_internal.hpp>
+#include <davix_context_internal.hpp>
+
+namespace Davix {
+
+StatCacheOps::StatCacheOps() : HttpIOChain() {}
+
+StatCacheOps::~StatCacheOps() {}
+
+//------------------------------------------------------------------------------
+// Stat through the metadata cache
+//------------------------------------------------------------------------------
+StatInfo & StatCacheOps::statInfo(IOChainContext & iocontext, StatInfo & st_info) {
+  StatCache &cache = ContextExplorer::StatCacheFromContext(iocontext._context);
+
+  if(cache.getTTL() == 0 || iocontext.bypassCaches) {
+    CHAIN_FORWARD(statInfo(iocontext, st_info));
+  }
+
+  switch(cache.lookup(iocontext._uri, st_info)) {
+    case StatCache::Found:
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Metadata of {} found in cache", iocontext._uri);
+      return st_info;
+    case StatCache::NotFound:
+      DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "{} known to be missing from cache", iocontext._uri);
+      throw DavixException(davix_scope_stat_str(), StatusCode::FileNotFound,
+                           fmt::format("{} not found (cached)", iocontext._uri.getString()));
+    case StatCache::Miss:
+      break;
+  }
+
+  try {
+    HttpIOChain::statInfo(iocontext, st_info);
+  }
+  catch(DavixException &e) {
+    if(e.code() == StatusCode::FileNotFound) {
+      cache.insertNotFound(iocontext._uri);
+    }
+    throw;
+  }
+
+  cache.insert(iocontext._uri, st_info);
+  return st_info;
+}
+
+//------------------------------------------------------------------------------
+// List, storing the metadata of the entries
+//------------------------------------------------------------------------------
+bool StatCacheOps::nextSubItem(IOChainContext & iocontext, std::string & entry_name, StatInfo & info) {
+  if(!HttpIOChain::nextSubItem(iocontext, entry_name, info)) {
+    return false;
+  }
+
+  if(!iocontext.bypassCaches) {
+    ContextExplorer::StatCacheFromContext(iocontext._context).insertChild(iocontext._uri, entry_name, info);
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write, dropping the cached metadata of the file
+//------------------------------------------------------------------------------
+dav_ssize_t StatCacheOps::writeFromProvider(IOChainContext & iocontext, ContentProvider &provider) {
+  StatCache &cache = ContextExplorer::StatCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri);
+  dav_ssize_t ret = HttpIOChain::writeFromProvider(iocontext, provider);
+  // metadata fetched while the upload was in progress may be stale as well
+  cache.invalidate(iocontext._uri);
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+// Delete, dropping the cached metadata of the resource
+//------------------------------------------------------------------------------
+void StatCacheOps::deleteResource(IOChainContext & iocontext) {
+  StatCache &cache = ContextExplorer::StatCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri);
+  HttpIOChain::deleteResource(iocontext);
+  cache.invalidate(iocontext._uri);
+}
+
+//------------------------------------------------------------------------------
+// Make a collection, dropping a cached "not found"
+//------------------------------------------------------------------------------
+void StatCacheOps::makeCollection(IOChainContext & iocontext) {
+  StatCache &cache = ContextExplorer::StatCacheFromContext(iocontext._context);
+
+  cache.invalidate(iocontext._uri);
+  HttpIOChain::makeCollection(iocontext);
+  cache.invalidate(iocontext._uri);
+}
+
+//------------------------------------------------------------------------------
+// Move, dropping the cached metadata of both source and target
+//------------------------------------------------------------------------------
+void StatCacheOps::move(IOChainContext & iocontext, const std::string & target_url) {
+  StatCache &cache = ContextExplorer::StatCacheFromContext(iocontext._context);
+  const Uri target(target_url);
+
+  cache.invalidate(iocontext._uri);
+  cache.invalidate(target);
+  HttpIOChain::move(iocontext, target_url);
+  cache.invalidate(iocontext._uri);
+  cache.invalidate(target);
+}
+
+}
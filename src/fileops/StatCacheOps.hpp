@@ -0,0 +1,65 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#ifndef DAVIX_FILEOPS_STAT_CACHE_OPS_HPP
+#define DAVIX_FILEOPS_STAT_CACHE_OPS_HPP
+
+#include <fileops/httpiochain.hpp>
+#include <core/StatCache.hpp>
+
+namespace Davix {
+
+//------------------------------------------------------------------------------
+// Serves statInfo out of the metadata cache of the Context, when the cache is
+// enabled. Metadata returned by the rest of the chain is stored, and so are
+// "not found" errors when negative caching is enabled. Directory listings
+// store the metadata of every entry they return, so that listing a directory
+// and then opening its files takes no further stat request.
+//
+// Writes, deletions, moves and collection creations going through the chain
+// drop the cached metadata of the affected resources, and of their parent.
+//------------------------------------------------------------------------------
+class StatCacheOps : public HttpIOChain {
+public:
+  StatCacheOps();
+  ~StatCacheOps();
+
+  // get statInfo
+  virtual StatInfo & statInfo(IOChainContext & iocontext, StatInfo & st_info);
+
+  // listing
+  virtual bool nextSubItem(IOChainContext & iocontext, std::string & entry_name, StatInfo & info);
+
+  // write from content provider
+  virtual dav_ssize_t writeFromProvider(IOChainContext & iocontext, ContentProvider &provider);
+
+  // delete resource
+  virtual void deleteResource(IOChainContext & iocontext);
+
+  // make collection
+  virtual void makeCollection(IOChainContext & iocontext);
+
+  // move/rename resource
+  virtual void move(IOChainContext & iocontext, const std::string & target_url);
+};
+
+}
+
+#endif
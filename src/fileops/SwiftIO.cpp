@@ -20,6 +20,7 @@
 */
 
 #include "SwiftIO.hpp"
+#include "ChunkedUpload.hpp"
 #include <core/ContentProvider.hpp>
 #include <utils/davix_logger_internal.hpp>
 #include <utils/davix_swift_utils.hpp>
@@ -45,7 +46,7 @@ static bool should_use_swift_multipart(IOChainContext & context, dav_size_t size
         return true;
     }
 
-    return size > (1024 * 1024 * 512); // 512 MB
+    return size > context._reqparams->getUploadThreshold();
 }
 
 SwiftIO::SwiftIO() {
@@ -56,34 +57,6 @@ SwiftIO::~SwiftIO() {
 
 }
 
-static dav_size_t fillBufferWithProviderData(std::vector<char> &buffer, const dav_size_t maxChunkSize, ContentProvider &provider) {
-    dav_size_t written = 0u;
-    dav_size_t remaining = maxChunkSize;
-
-    while(true) {
-        dav_ssize_t bytesRead = provider.pullBytes(buffer.data(), remaining);
-        if(bytesRead < 0) {
-            throw DavixException(davix_scope_io_buff(), StatusCode::InvalidFileHandle, fmt::format("Error when reading from callback: {}", bytesRead));
-        }
-
-        remaining -= bytesRead;
-        written += bytesRead;
-
-        if(bytesRead == 0) {
-            DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Reached data provider EOF, received 0 bytes, even though asked for {}", remaining);
-            break; // EOF
-        }
-
-        if(remaining == 0) {
-            DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Data provider buffer has been filled");
-            break; // buffer is full
-        }
-    }
-
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Retrieved {} bytes from data provider", written);
-    return written;
-}
-
 std::string SwiftIO::writeChunk(IOChainContext &iocontext, const char *buff, dav_size_t size, int partNumber) {
     Uri url(iocontext._uri);
     url.setPath(url.getPath() + "/" + std::to_string(partNumber));
@@ -108,6 +81,7 @@ std::string SwiftIO::writeChunk(IOChainContext &iocontext, const char *buff, dav
     if(!req.getAnswerHeader("Etag", etag)) {
         DavixError::setupError(&tmp_err, "Swift::MultiPart", StatusCode::InvalidServerResponse, "Unable to retrieve chunk Etag, necessary when committing chunks");
     }
+    checkDavixError(&tmp_err);
 
     DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "chunk #{} written successfully, etag: {}", partNumber, etag);
     return etag;
@@ -217,26 +191,21 @@ dav_ssize_t SwiftIO::writeFromProvider(IOChainContext & iocontext, ContentProvid
 
     DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Initiating large file upload towards {} to upload file with size {}", iocontext._uri, provider.getSize());
 
-    size_t remaining = provider.getSize();
-    const dav_size_t MAX_CHUNK_SIZE = 1024 * 1024 * 256; // 256 MB
+    dav_size_t segmentSize = iocontext._reqparams->getUploadChunkSize();
+    if(segmentSize == 0) {
+        segmentSize = 1024 * 1024 * 256; // 256 MB
+    }
     const size_t MAX_MANIFEST_SEGMENTS = 1000;
 
-    std::vector<char> buffer;
-    buffer.resize(std::min(MAX_CHUNK_SIZE, (dav_size_t) provider.getSize()) + 10);
+    std::vector<UploadedChunk> segments = uploadChunks(iocontext, provider, segmentSize,
+        [&](const char *buffer, dav_size_t size, size_t index) {
+            return writeChunk(iocontext, buffer, size, index + 1);
+        });
 
+    // the manifest goes up once every segment is in place
     std::vector<Prop> props;
-
-    size_t partNumber = 0;
-
-    while(remaining > 0) {
-        size_t toRead = std::min( (dav_size_t) provider.getSize(), MAX_CHUNK_SIZE);
-        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "SwiftIO write: toRead from cb {}", toRead);
-
-        dav_size_t bytesRead = fillBufferWithProviderData(buffer, MAX_CHUNK_SIZE, provider);
-        if(bytesRead == 0) break; // EOF
-
-        partNumber++;
-        props.emplace_back(writeChunk(iocontext, buffer.data(), bytesRead, partNumber), bytesRead);
+    for(size_t i = 0; i < segments.size(); i++) {
+        props.emplace_back(segments[i].tag, segments[i].size);
     }
 
     if(props.size() > MAX_MANIFEST_SEGMENTS){ // if segment number is larger than max_manifest_segments (by default 1000), use inline segments
@@ -26,7 +26,10 @@
 #include "davix_reliability_ops.hpp"
 #include "iobuffmap.hpp"
 #include "AzureIO.hpp"
+#include "BlockCacheIO.hpp"
+#include "DiskCacheIO.hpp"
 #include "S3IO.hpp"
+#include "StatCacheOps.hpp"
 #include "SwiftIO.hpp"
 
 namespace Davix{
@@ -37,7 +40,7 @@ ChainFactory::ChainFactory(){}
 
 HttpIOChain& ChainFactory::instanceChain(const CreationFlags & flags, HttpIOChain & c){
     HttpIOChain* elem;
-    elem= c.add(new MetalinkOps())->add(new AutoRetryOps())->add(new S3MetaOps())->add(new SwiftMetaOps())->add(new AzureMetaOps())->add(new HttpMetaOps());
+    elem= c.add(new MetalinkOps())->add(new AutoRetryOps())->add(new StatCacheOps())->add(new DiskCacheIO())->add(new BlockCacheIO())->add(new S3MetaOps())->add(new SwiftMetaOps())->add(new AzureMetaOps())->add(new HttpMetaOps());
 
     // add posix to the chain if needed
     if(flags[CHAIN_POSIX] == true){
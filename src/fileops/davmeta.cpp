@@ -136,6 +136,7 @@ int dav_stat_mapper_http(Context& context, const RequestParams* params, const Ur
                 const dav_ssize_t s = req.getAnswerSize();
                 st_info.size = std::max<dav_ssize_t>(0,s);
                 st_info.mode = 0755 | S_IFREG;
+                st_info.mtime = req.getLastModified();
                 ret = 0;
             }else{
                 httpcodeToDavixError(req.getRequestCode(), davix_scope_http_request(), uri.getString() , &tmp_err);
@@ -174,6 +175,7 @@ int dav_stat_mapper_http_get(Context& context, const RequestParams* params, cons
                 long lsize = toType<long, std::string>()(rnge.substr(pos+1));
                 st_info.size = std::max<long>(0,lsize);
                 st_info.mode = 0755 | S_IFREG;
+                st_info.mtime = req.getLastModified();
                 req.discardBody(&tmp_err);
                 ret = 0;
             }else{
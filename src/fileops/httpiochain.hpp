@@ -50,7 +50,7 @@ struct FdHandler {
 
 // parameter handler for any IO Chain operation
 struct IOChainContext{
-    IOChainContext(Context & c, const Uri & u, const RequestParams * p): _context(c), _uri(u), _reqparams(p), _end_time() {
+    IOChainContext(Context & c, const Uri & u, const RequestParams * p): _context(c), _uri(u), _reqparams(p), _end_time(), bypassCaches(false), rangeIgnored(false) {
         if(_reqparams->getOperationTimeout()->tv_sec > 0){
             _end_time = Chrono::Clock(Chrono::Clock::Monolitic).now();
             _end_time += Chrono::Duration(_reqparams->getOperationTimeout()->tv_sec);
@@ -80,6 +80,14 @@ struct IOChainContext{
     // Keep track of how many bytes we've written to an fd, so as to avoid
     // writing the same bytes again in an event of retries / metalink recovery
     FdHandler fdHandler;
+
+    // Set while a cache layer fetches blocks: reads re-entering the chain
+    // from below go straight to the server
+    bool bypassCaches;
+
+    // Set by positional reads when the server ignored the Range header, and
+    // the requested bytes had to be picked out of the whole file
+    bool rangeIgnored;
 };
 
 // Davix IO chain
@@ -21,31 +21,22 @@
 
 #include <davix_internal.hpp>
 #include "httpiovec.hpp"
+#include "MultipartParser.hpp"
 #include <utils/davix_logger_internal.hpp>
 #include <utils/stringutils.hpp>
-#include "libs/IntervalTree.h"
+#include <backend/SessionFactory.hpp>
+#include <core/LinkEstimator.hpp>
+#include <core/WorkerPool.hpp>
+#include <davix_context_internal.hpp>
 
+#include <chrono>
 #include <map>
 
 #define DBG(message) std::cerr << __FILE__ << ":" << __LINE__ << " -- " << #message << " = " << message << std::endl;
 using namespace StrUtil;
 
-// remove trailing crlf
-template<class InputIterator>
-  dav_size_t trim_crlf (InputIterator first, InputIterator last, dav_size_t s)
-{
-  dav_size_t ret = s;
-  while (--last >= first) {
-      if(*last == '\n' || *last == '\r'){
-          *last = '\0';
-          ret--;
-      }else{
-          break;
-      }
-  }
-  return ret;
-}
-
+// part bodies of multi-range responses are read in blocks of this size
+static const dav_size_t multipart_block_size = 262144;
 
 
 namespace Davix{
@@ -59,25 +50,12 @@ void HttpIoVecSetupErrorMultiPart(DavixError** err){
     DavixError::setupError(err, HttpIoVec_scope(), StatusCode::InvalidServerResponse, "Invalid Multi-Part HTTP response");
 }
 
-void HttpIoVecSetupErrorMultiPartTooLong(DavixError** err){
-    DavixError::setupError(err, HttpIoVec_scope(), StatusCode::InvalidServerResponse, "Invalid Multi-Part HTTP, Multi-part header too long");
-}
-
-void HttpIoVecSetupErrorMultiPartBoundary(const std::string & boundary, DavixError** err){
-    DavixError::setupError(err, HttpIoVec_scope(), StatusCode::InvalidServerResponse, std::string("Invalid boundary for multipart http response :").append(boundary));
-}
-
 void HttpIoVecSetupErrorMultiPartSize( DavixError** err, dav_off_t req_offset, dav_size_t req_size, dav_off_t ans_offset, dav_size_t ans_size){
     std::ostringstream ss;
     ss << "Invalid server answer for multi part, request offset:"<< req_offset <<" size:"<< req_size << ", answer offset:"<< ans_offset<< " size:"<< ans_size;
     DavixError::setupError(err, HttpIoVec_scope(), StatusCode::InvalidServerResponse, ss.str());
 }
 
-inline char* header_delimiter(char* buffer, dav_size_t len){
-    char* p = std::find(buffer, buffer + len, ':');
-    return (p < buffer + len)?p:NULL;
-}
-
 // Vector operation option provider
 /*int davIOVecProvider(const DavIOVecInput *input_vec, dav_ssize_t & counter, dav_ssize_t number, dav_off_t & begin, dav_off_t & end){
     if(counter < number){
@@ -98,16 +76,101 @@ int davIOVecProvider(const SortedRanges ranges, dav_size_t & counter, dav_off_t
 }
 
 
+// do a single multi-range GET, covering the batch of ranges starting at first
+MultirangeResult::OperationResult HttpIOVecOps::performMultirangeBatch(IOChainContext & iocontext,
+                                                                       const ChunkIndex & chunks,
+                                                                       const SortedRanges & ranges,
+                                                                       dav_size_t first,
+                                                                       const std::pair<dav_size_t, std::string> & batch,
+                                                                       dav_ssize_t bytes_to_read,
+                                                                       bool allow_full_file,
+                                                                       dav_ssize_t & ret,
+                                                                       DavixError** err) {
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, " -> getPartialVec request for {} chunks", batch.first);
+    ret = 0;
+
+    if(batch.first == 1){ // one chunk only : no need of multi part
+        ret = singleRangeRequest(iocontext, chunks, ranges[first].first, ranges[first].second - ranges[first].first + 1);
+        return MultirangeResult::SUCCESS;
+    }
+
+    GetRequest req (iocontext._context, iocontext._uri, err);
+    if(*err != NULL){
+        ret = -1;
+        return MultirangeResult::SUCCESS;
+    }
+
+    RequestParams request_params(iocontext._reqparams);
+    req.setParameters(request_params);
+    req.addHeaderField(req_header_byte_range, batch.second);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if( req.beginRequest(err) != 0){
+        ret = -1;
+        return MultirangeResult::SUCCESS;
+    }
+
+    const int retcode = req.getRequestCode();
+
+    // looks like the server supports multi-range requests.. yay
+    if(retcode == 206) {
+        const std::chrono::steady_clock::time_point headers = std::chrono::steady_clock::now();
+        ret = parseMultipartRequest(req, chunks, err);
+
+        if(ret > 0) {
+            ContextExplorer::LinkEstimatorFromContext(iocontext._context).recordRequest(
+                SessionFactory::makeSessionKey(iocontext._uri),
+                std::chrono::duration_cast<std::chrono::microseconds>(headers - start), ret,
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - headers));
+        }
+
+        // could not parse multipart response - server's broken?
+        // known to happen with ceph - return code is 206, but only
+        // returns the first range
+        if(ret == -1) {
+            req.endRequest(err);
+            return MultirangeResult::NOMULTIRANGE;
+        }
+        return MultirangeResult::SUCCESS;
+    }
+
+    // no multi-range.. bad server, bad
+    if(retcode == 200) {
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Multi-range request resulted in getting the whole file.");
+        // we have two options: read the entire file or abort current
+        // request and start a multi-range simulation
+
+        // if this is a huge file, reading the entire contents is
+        // definitely not an option - neither is it while other batches
+        // are filling the same chunks concurrently
+        if(!allow_full_file || (req.getAnswerSize() > 1000000 && req.getAnswerSize() > 2*bytes_to_read)) {
+            DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Will not read the entire file, bailing out");
+            req.endRequest(err);
+            return MultirangeResult::NOMULTIRANGE;
+        }
+
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Simulating multi-part response from the contents of the entire file");
+        ret = simulateMultiPartRequest(req, chunks, err);
+        return MultirangeResult::SUCCESS_BUT_NO_MULTIRANGE;
+    }
+
+    if(retcode == 416) {
+        DavixError::clearError(err);
+        return MultirangeResult::SUCCESS;
+    }
+
+    httpcodeToDavixError(req.getRequestCode(),davix_scope_http_request(),", ", err);
+    ret = -1;
+    return MultirangeResult::SUCCESS;
+}
+
 // do a multi-range on selected ranges
 MultirangeResult HttpIOVecOps::performMultirange(IOChainContext & iocontext,
-                                                 const IntervalTree<ElemChunk> &tree,
-                                                 const SortedRanges & ranges) {
+                                                 const ChunkIndex & chunks,
+                                                 const SortedRanges & ranges,
+                                                 uint nconnections) {
 
-    DavixError * tmp_err=NULL;
-    dav_ssize_t tmp_ret=-1, ret = 0;
-    ptrdiff_t p_diff=0;
     dav_size_t counter = 0;
-    MultirangeResult::OperationResult opresult = MultirangeResult::SUCCESS;
 
     // calculate total bytes to be read (approximate, since ranges could overlap)
     dav_ssize_t bytes_to_read = 0;
@@ -122,74 +185,68 @@ MultirangeResult HttpIOVecOps::performMultirange(IOChainContext & iocontext,
     // 3900 bytes maximum for the range seems to be a ood compromise
     std::vector< std::pair<dav_size_t, std::string> > vecRanges = generateRangeHeaders(3900, offsetProvider);
 
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, " -> getPartialVec operation for {} vectors", ranges.size());
-
-    for(std::vector< std::pair<dav_size_t, std::string> >::iterator it = vecRanges.begin(); it < vecRanges.end(); ++it){
-        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, " -> getPartialVec request for {} chunks", it->first);
-
-        if(it->first == 1){ // one chunk only : no need of multi part
-            ret += singleRangeRequest(iocontext, tree, ranges[p_diff].first, ranges[p_diff].second - ranges[p_diff].first + 1);
-            p_diff += 1;
-        }else{
-            GetRequest req (iocontext._context, iocontext._uri, &tmp_err);
-            if(tmp_err == NULL){
-                RequestParams request_params(iocontext._reqparams);
-                req.setParameters(request_params);
-                req.addHeaderField(req_header_byte_range, it->second);
-
-                if( req.beginRequest(&tmp_err) == 0){
-                    const int retcode = req.getRequestCode();
-
-                    // looks like the server supports multi-range requests.. yay
-                    if(retcode == 206) {
-                        ret = parseMultipartRequest(req, tree, &tmp_err);
-
-                        // could not parse multipart response - server's broken?
-                        // known to happen with ceph - return code is 206, but only
-                        // returns the first range
-                        if(ret == -1) {
-                            opresult = MultirangeResult::NOMULTIRANGE;
-                            req.endRequest(&tmp_err);
-                            break;
-                        }
-                    }
-                    // no multi-range.. bad server, bad
-                    else if(retcode == 200) {
-                        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Multi-range request resulted in getting the whole file.");
-                        // we have two options: read the entire file or abort current
-                        // request and start a multi-range simulation
-
-                        // if this is a huge file, reading the entire contents is
-                        // definitely not an option
-                        if(req.getAnswerSize() > 1000000 && req.getAnswerSize() > 2*bytes_to_read) {
-                            DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "File is too large; will not waste bandwidth, bailing out");
-                            opresult = MultirangeResult::NOMULTIRANGE;
-                            req.endRequest(&tmp_err);
-                        }
-                        else {
-                            DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Simulating multi-part response from the contents of the entire file");
-                            opresult = MultirangeResult::SUCCESS_BUT_NO_MULTIRANGE;
-                            ret = simulateMultiPartRequest(req, tree, &tmp_err);
-                        }
-                        break;
-                    }
-                    else if(retcode == 416) {
-                      ret = 0;
-                      DavixError::clearError(&tmp_err);
-                    }
-                    else {
-                        httpcodeToDavixError(req.getRequestCode(),davix_scope_http_request(),", ", &tmp_err);
-                        ret = -1;
-                        break;
-                    }
-
-                    p_diff += it->first;
-                    ret += tmp_ret;
-                } else {
-                   ret = -1;
-                   break;
-                }
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, " -> getPartialVec operation for {} vectors in {} requests", ranges.size(), vecRanges.size());
+
+    // index of the first range of each batch
+    std::vector<dav_size_t> firstRange(vecRanges.size(), 0);
+    for(dav_size_t i = 1; i < vecRanges.size(); i++) {
+        firstRange[i] = firstRange[i-1] + vecRanges[i-1].first;
+    }
+
+    std::vector<MultirangeResult::OperationResult> results(vecRanges.size(), MultirangeResult::SUCCESS);
+    std::vector<dav_ssize_t> sizes(vecRanges.size(), 0);
+    std::vector<DavixError*> errors(vecRanges.size(), NULL);
+
+    // the first batch goes alone: it tells us whether the server supports
+    // multi-range at all, before we fire off the rest over several connections
+    dav_size_t done = 0;
+    if(vecRanges.size() > 0) {
+        results[0] = performMultirangeBatch(iocontext, chunks, ranges, 0, vecRanges[0], bytes_to_read, true, sizes[0], &errors[0]);
+        done = 1;
+
+        if(results[0] != MultirangeResult::SUCCESS || sizes[0] < 0) {
+            done = vecRanges.size();
+        }
+    }
+
+    if(done < vecRanges.size()) {
+        try {
+            ContextExplorer::WorkerPoolFromContext(iocontext._context).parallelFor(vecRanges.size() - done, nconnections,
+                [&](size_t i) {
+                    const dav_size_t batch = done + i;
+                    results[batch] = performMultirangeBatch(iocontext, chunks, ranges, firstRange[batch], vecRanges[batch],
+                                                            bytes_to_read, false, sizes[batch], &errors[batch]);
+                });
+        }
+        catch(...) {
+            // errors of the batches which did complete
+            for(dav_size_t i = 0; i < errors.size(); i++) {
+                DavixError::clearError(&errors[i]);
             }
+            throw;
+        }
+    }
+
+    // aggregate - the first error wins, then the first fallback
+    DavixError * tmp_err=NULL;
+    MultirangeResult::OperationResult opresult = MultirangeResult::SUCCESS;
+    dav_ssize_t ret = 0;
+
+    for(dav_size_t i = 0; i < vecRanges.size(); i++) {
+        if(errors[i] != NULL && tmp_err == NULL) {
+            std::swap(tmp_err, errors[i]);
+        }
+        DavixError::clearError(&errors[i]);
+
+        if(results[i] != MultirangeResult::SUCCESS && opresult == MultirangeResult::SUCCESS) {
+            opresult = results[i];
+        }
+
+        if(sizes[i] < 0 || ret < 0) {
+            ret = -1;
+        }
+        else {
+            ret += sizes[i];
         }
     }
 
@@ -212,128 +269,85 @@ dav_ssize_t HttpIOVecOps::singleRangeRequest(IOChainContext & iocontext,
     return size;
 }
 
-// merge user-provided ranges, add them to intervals
-typedef std::multimap<dav_off_t, dav_size_t> MergedRanges;
-static SortedRanges partialMerging(const IntervalTree<ElemChunk> &tree, const dav_size_t mergedist) {
-    MergedRanges merged;
-
-    std::vector<Interval<ElemChunk> > allranges_unsorted;
-    tree.findContained(0, std::numeric_limits<dav_size_t>::max(), allranges_unsorted);
-
-    MergedRanges allranges;
-    for(std::vector<Interval<ElemChunk> >::iterator it = allranges_unsorted.begin(); it != allranges_unsorted.end(); it++)
-        allranges.insert(std::make_pair(it->start, it->stop));
-
-    dav_off_t offset = allranges.begin()->first;
-    dav_off_t end = allranges.begin()->second;
-
-    for(MergedRanges::iterator it = allranges.begin(); it != allranges.end(); it++) {
-        if(end + (dav_off_t) mergedist >= it->first) {
-            end = it->second;
-        }
-        else {
-            merged.insert(std::make_pair(offset, end));
-            offset = it->first;
-            end = it->second;
-        }
-    }
-    merged.insert(std::make_pair(offset, end));
-
-    SortedRanges output;
-    for(MergedRanges::iterator it = merged.begin(); it != merged.end(); it++)
-        output.push_back(*it);
-
-    return output;
-}
-
-static IntervalTree<ElemChunk> buildIntervalTree(const DavIOVecInput *in, DavIOVecOuput *out, const dav_size_t count_vec) {
-    std::vector<Interval<ElemChunk> > intervals;
-
-    for(dav_size_t i = 0; i < count_vec; i++) {
-        dav_off_t start = in[i].diov_offset;
-        dav_off_t end = start + in[i].diov_size - 1;
-        ElemChunk elem(in+i, out+i);
-
-        intervals.push_back(Interval<ElemChunk>(start, end, elem));
+ChunkIndex::ChunkIndex(const DavIOVecInput *in, DavIOVecOuput *out, const dav_size_t count) {
+    std::vector<dav_size_t> order;
+    order.reserve(count);
+    for(dav_size_t i = 0; i < count; i++) {
+        out[i].diov_size = 0;
+        out[i].diov_buffer = in[i].diov_buffer;
+        if(in[i].diov_size > 0)
+            order.push_back(i);
+    }
+
+    // vectors usually come sorted already
+    auto byOffset = [in](dav_size_t a, dav_size_t b) {
+        return in[a].diov_offset < in[b].diov_offset;
+    };
+    if(!std::is_sorted(order.begin(), order.end(), byOffset))
+        std::stable_sort(order.begin(), order.end(), byOffset);
+
+    _starts.reserve(order.size());
+    _stops.reserve(order.size());
+    _maxStops.reserve(order.size());
+    _chunks.reserve(order.size());
+
+    for(dav_size_t i = 0; i < order.size(); i++) {
+        const dav_size_t n = order[i];
+        const dav_off_t stop = in[n].diov_offset + in[n].diov_size - 1;
+
+        _starts.push_back(in[n].diov_offset);
+        _stops.push_back(stop);
+        _maxStops.push_back(_maxStops.empty() ? stop : std::max(_maxStops.back(), stop));
+        _chunks.push_back(ElemChunk(in + n, out + n));
     }
-    return IntervalTree<ElemChunk>(intervals);
 }
 
-typedef struct thread_data {
-    HttpIOVecOps *ptr;
-    int thread_no;
-    const SortedRanges *ranges;
-    const IntervalTree<ElemChunk> *tree;
-    IOChainContext *iocontext;
-    dav_size_t start, end;
-
-    dav_ssize_t size;
-    std::exception_ptr exc;
-} thdata;
+// merge user-provided ranges
+SortedRanges partialMerging(const ChunkIndex & chunks, const dav_size_t mergedist, dav_size_t & gap_bytes) {
+    SortedRanges output;
+    gap_bytes = 0;
 
-void* parallelSingleRange(void *args) {
+    if(chunks.size() == 0)
+        return output;
 
-    thdata *data = (thdata*) args;
-    const SortedRanges & ranges = *data->ranges;
+    dav_off_t offset = chunks.start(0);
+    dav_off_t end = chunks.stop(0);
 
-    data->size = 0;
-    for(dav_size_t i = data->start; i < data->end; i++) {
-        try {
-          data->size += data->ptr->singleRangeRequest(*data->iocontext, *data->tree,
-                                                      ranges[i].first,
-                                                      ranges[i].second - ranges[i].first + 1);
+    for(dav_size_t i = 1; i < chunks.size(); i++) {
+        if(end + (dav_off_t) mergedist >= chunks.start(i)) {
+            if(chunks.start(i) > end + 1) {
+                gap_bytes += chunks.start(i) - end - 1;
+            }
+            end = std::max<dav_off_t>(end, chunks.stop(i));
         }
-        catch(const Davix::DavixException &err) {
-          data->exc = std::current_exception();
-          return NULL;
+        else {
+            output.push_back(std::make_pair(offset, end));
+            offset = chunks.start(i);
+            end = chunks.stop(i);
         }
     }
+    output.push_back(std::make_pair(offset, end));
 
-    return NULL;
+    return output;
 }
 
-
 dav_ssize_t HttpIOVecOps::simulateMultirange(IOChainContext & iocontext,
-                                     const IntervalTree<ElemChunk> & tree,
+                                     const ChunkIndex & chunks,
                                      const SortedRanges & ranges,
                                      const uint nconnections) {
     DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Simulating a multi-range request with {} vectors", ranges.size());
-    dav_ssize_t size = 0;
-
-    uint num_threads = nconnections;
-    if(num_threads > ranges.size()) {
-        num_threads = ranges.size();
-    }
-    uint queries_per_thread = ranges.size() / num_threads;
-
-    pthread_t threads[num_threads];
-    thdata data[num_threads];
-    for(uint i = 0; i < num_threads; i++) {
-        data[i].ptr = this;
-        data[i].thread_no = i;
-        data[i].ranges = &ranges;
-        data[i].tree = &tree;
-        data[i].iocontext = &iocontext;
 
-        data[i].start = i*queries_per_thread;
-        data[i].end = data[i].start + queries_per_thread;
+    // one request per range, the next free connection takes the next range:
+    // a slow range only holds up its own connection
+    std::vector<dav_ssize_t> sizes(ranges.size(), 0);
+    ContextExplorer::WorkerPoolFromContext(iocontext._context).parallelFor(ranges.size(), nconnections,
+        [&](size_t i) {
+            sizes[i] = singleRangeRequest(iocontext, chunks, ranges[i].first, ranges[i].second - ranges[i].first + 1);
+        });
 
-        if(i == num_threads - 1) {
-            data[i].end = ranges.size();
-        }
-
-        pthread_create(&threads[i], NULL, parallelSingleRange, (void*) &data[i]);
-    }
-
-    for(uint i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
-        size += data[i].size;
-    }
-
-    for(uint i = 0; i < num_threads; i++) {
-        if(data[i].exc != std::exception_ptr()) {
-            std::rethrow_exception(data[i].exc);
-        }
+    dav_ssize_t size = 0;
+    for(dav_size_t i = 0; i < sizes.size(); i++) {
+        size += sizes[i];
     }
 
     return size;
@@ -345,41 +359,62 @@ dav_ssize_t HttpIOVecOps::preadVec(IOChainContext & iocontext, const DavIOVecInp
     if(count_vec ==0)
         return 0;
 
-    for(dav_size_t i = 0; i < count_vec; i++) {
-      output_vec[i].diov_size = 0;
-    }
+    // size of merge window: URL fragment first, then request parameters,
+    // otherwise derived from what we know about the link to the endpoint
+    LinkEstimator & estimator = ContextExplorer::LinkEstimatorFromContext(iocontext._context);
+    const std::string endpoint = SessionFactory::makeSessionKey(iocontext._uri);
 
-    // size of merge window
-    dav_size_t mergewindow = 2000;
+    dav_size_t mergewindow;
     if(iocontext._uri.fragmentParamExists("mergewindow")) {
         mergewindow = atoi(iocontext._uri.getFragmentParam("mergewindow").c_str());
         DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Setting mergewindow to {}", mergewindow);
     }
+    else if(iocontext._reqparams->getMergeWindow() >= 0) {
+        mergewindow = iocontext._reqparams->getMergeWindow();
+    }
+    else {
+        mergewindow = estimator.getMergeWindow(endpoint, DAVIX_DEFAULT_MERGE_WINDOW);
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Using mergewindow of {} for {}", mergewindow, endpoint);
+    }
 
-    // number of parallel connections in case of a simulation
+    // number of parallel connections, used both for multi-range requests
+    // and for their simulation
     uint nconnections = 3;
     if(iocontext._uri.fragmentParamExists("nconnections")) {
         nconnections = atoi(iocontext._uri.getFragmentParam("nconnections").c_str());
         DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Setting number of desired parallel connections to {}", nconnections);
     }
+    if(nconnections == 0) {
+        nconnections = 1;
+    }
+
+    ChunkIndex chunks(input_vec, output_vec, count_vec);
 
-    IntervalTree<ElemChunk> tree = buildIntervalTree(input_vec, output_vec, count_vec);
+    dav_size_t gap_bytes = 0, bytes_requested = 0;
+    SortedRanges sorted = partialMerging(chunks, mergewindow, gap_bytes);
+    for(dav_size_t i = 0; i < count_vec; i++) {
+        bytes_requested += input_vec[i].diov_size;
+    }
+    estimator.recordVectorRead(endpoint, count_vec, sorted.size(), bytes_requested, gap_bytes);
 
     // a lot of servers do not support multirange... should we even try?
     if(count_vec == 1 || iocontext._uri.getFragmentParam("multirange") == "false") {
-        SortedRanges sorted = partialMerging(tree, mergewindow);
-        return simulateMultirange(iocontext, tree, sorted, nconnections);
+        return simulateMultirange(iocontext, chunks, sorted, nconnections);
     }
 
-    SortedRanges sorted = partialMerging(tree, mergewindow);
-    MultirangeResult res = performMultirange(iocontext, tree, sorted);
+    MultirangeResult res = performMultirange(iocontext, chunks, sorted, nconnections);
     if(res.res == MultirangeResult::SUCCESS || res.res == MultirangeResult::SUCCESS_BUT_NO_MULTIRANGE) {
         return res.size_bytes;
     }
     else {
         DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Multi-range request has failed, attempting to recover by using multiple single-range requests");
-        sorted = partialMerging(tree, mergewindow);
-        return simulateMultirange(iocontext, tree, sorted, nconnections);
+
+        // some batches might have gone through already, start over
+        for(dav_size_t i = 0; i < count_vec; i++) {
+          output_vec[i].diov_size = 0;
+        }
+
+        return simulateMultirange(iocontext, chunks, sorted, nconnections);
     }
 }
 
@@ -410,110 +445,8 @@ int get_multi_part_info(const HttpRequest& req, std::string & boundary, DavixErr
     return -1;
 }
 
-// analyze header and try to find size of the part
-// return 0 -> not a content length header, return -1 : not a header or error, return 1 : success
-int find_header_params(char* buffer, dav_size_t buffer_len, dav_size_t* part_size, dav_off_t* part_offset){
-    static const std::string delimiter(" bytes-/\t");
-    char * p = header_delimiter(buffer, buffer_len);
-    if(p == NULL)
-        return -1;
-    std::string header_type(buffer, p - buffer);
-    if( compare_ncase(ans_header_byte_range, 0, p - buffer, buffer) !=0) // check header type
-        return 0;
-
-    std::vector<std::string> tokens = tokenSplit(std::string(p+1),delimiter);     // parse header
-    if(tokens.size() < 2)
-        return -1;
-
-    long chunk_size[2];
-    for(int i =0; i <2;++i){
-        chunk_size[i]= strtol(tokens[i].c_str(), &p, 10);
-        if(chunk_size[i] == LONG_MAX || chunk_size[i] < 0 || *p != '\0'){
-            errno =0;
-            return -1;
-        }
-    }
-    if(chunk_size[1] < chunk_size[0])
-        return -1;
-
-    *part_offset= chunk_size[0];
-    *part_size =  chunk_size[1]-chunk_size[0]+1;
-    return 1;
-}
-
-inline dav_ssize_t parse_multi_part_header_line(HttpRequest& req, char* buffer, DavixError** err){
-    dav_ssize_t ret =0;
-    if( (ret = req.readLine(buffer, DAVIX_READ_BLOCK_SIZE, err)) <0 ){
-        return -1;
-    }
-    ret=  trim_crlf(buffer, buffer + ret, ret);
-    return ret;
-}
-
-enum BoundaryType { NORMAL_BOUNDARY, TERMINATING_BOUNDARY, NOT_A_BOUNDARY };
-
-static BoundaryType parseBoundary(char* buffer, const std::string & boundary) {
-    dav_size_t len = strlen(buffer);
-
-    if(len <= 3)
-        return NOT_A_BOUNDARY;
-
-    char *p = buffer;
-    if(*p != '-' || *(p+1) != '-')
-        return NOT_A_BOUNDARY;
-
-    if(strncmp(buffer+2, boundary.c_str(), boundary.size()) != 0)
-        return NOT_A_BOUNDARY;
-
-    if(boundary.size()+2 == len)
-        return NORMAL_BOUNDARY;
-
-    if(boundary.size()+4 == len && *(p+len-2) == '-' && *(p+len-1) == '-')
-        return TERMINATING_BOUNDARY;
-
-    return NOT_A_BOUNDARY;
-}
-
-int  parse_multi_part_header(HttpRequest& req, const std::string & boundary, ChunkInfo & info,
-                            int & n_try, DavixError** err){
-    dav_ssize_t ret =0;
-    char buffer[DAVIX_READ_BLOCK_SIZE+1] = {0};
-
-    if(n_try > 100){
-        HttpIoVecSetupErrorMultiPartTooLong(err);
-        return -1;
-    }
-
-    if( (ret = parse_multi_part_header_line(req, buffer, err)) <0 ){
-        return -1;
-    }
-
-    if(!info.bounded){
-        if(ret == 0) // start with crlf
-            return parse_multi_part_header(req, boundary, info, ++n_try, err);
-
-        BoundaryType type = parseBoundary(buffer, boundary);
-        if(type == NOT_A_BOUNDARY) return -1;
-        if(type == TERMINATING_BOUNDARY) return -2;
-
-        info.bounded = true;
-        return parse_multi_part_header(req, boundary, info, ++n_try, err);
-    }
-
-    if( info.offset == 0 && info.size == 0){
-        if( find_header_params(buffer, ret, &(info.size), &(info.offset)) < 0)
-            return -1;
-        return parse_multi_part_header(req, boundary, info, ++n_try, err);
-    }
-    if(ret == 0) // end crlf
-        return 0;
-
-    HttpIoVecSetupErrorMultiPart(err);
-    return -1;
-}
-
 // copy from source to chunk
-static void copyBytes(const char *source, dav_off_t offset, dav_size_t size, ElemChunk &chunk) {
+static void copyBytes(const char *source, dav_off_t offset, dav_size_t size, const ElemChunk &chunk) {
     dav_off_t chunkOffset = chunk._in->diov_offset;
     dav_size_t chunkSize = chunk._in->diov_size;
 
@@ -530,56 +463,36 @@ static void copyBytes(const char *source, dav_off_t offset, dav_size_t size, Ele
     chunk._ou->diov_size += intersect_dist;
 }
 
-// find all matching chunks in tree and fill them
-static void fillChunks(const char *source, const IntervalTree<ElemChunk> &tree, dav_off_t offset, dav_size_t size) {
-    std::vector<Interval<ElemChunk> > matches;
-    tree.findOverlapping(offset, offset+size-1, matches);
-
-    for(std::vector<Interval<ElemChunk> >::iterator it = matches.begin(); it != matches.end(); it++) {
-        copyBytes(source, offset, size, it->value);
-    }
-
-    if(matches.size() == 0) {
-        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "WARNING: Received byte-range from server does not match any in the interval tree");
-    }
-}
-
-dav_ssize_t copyChunk(HttpRequest & req, const IntervalTree<ElemChunk> &tree, dav_off_t offset, dav_size_t size,
-                      DavixError** err){
-    DavixError* tmp_err=NULL;
-    dav_ssize_t ret;
-    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Davix::parseMultipartRequest::copyChunk copy {} bytes with offset {}", size, offset);
+// find all matching chunks and fill them
+static void fillChunks(const char *source, const ChunkIndex & chunks, dav_off_t offset, dav_size_t size) {
+    if(size == 0)
+        return;
 
-    std::vector<char> buffer;
-    buffer.resize(size+1);
+    dav_size_t matches = chunks.forEachOverlapping(offset, offset+size-1, [&](const ElemChunk & chunk) {
+        copyBytes(source, offset, size, chunk);
+    });
 
-    ret = req.readSegment(&buffer[0], size, &tmp_err);
-    if(ret != (dav_ssize_t) size || tmp_err) {
-        DavixError::propagateError(err, tmp_err);
+    if(matches == 0) {
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "WARNING: Received byte-range from server does not match any requested chunk");
     }
-    else {
-        fillChunks(&buffer[0], tree, offset, size);
-    }
-
-    return ret;
 }
 
 dav_ssize_t HttpIOVecOps::singleRangeRequest(IOChainContext & iocontext,
-                                             const IntervalTree<ElemChunk> & tree,
+                                             const ChunkIndex & chunks,
                                              dav_off_t offset, dav_size_t size) {
     std::vector<char> buffer;
     buffer.resize(size+1);
 
     dav_ssize_t s = _start->pread(iocontext, &buffer[0], size, offset);
-    fillChunks(&buffer[0], tree, offset, s);
+    fillChunks(&buffer[0], chunks, offset, s);
     return s;
 }
 
 dav_ssize_t HttpIOVecOps::parseMultipartRequest(HttpRequest & _req,
-                                                const IntervalTree<ElemChunk> & tree,
+                                                const ChunkIndex & chunks,
                                                 DavixError** err) {
     std::string boundary;
-    dav_ssize_t ret = 0, tmp_ret =0;
+    dav_ssize_t ret = 0;
     DAVIX_SLOG(DAVIX_LOG_TRACE, DAVIX_LOG_CHAIN, "Davix::parseMultipartRequest multi part parsing");
 
     if(get_multi_part_info(_req, boundary, err) != 0){
@@ -588,35 +501,40 @@ dav_ssize_t HttpIOVecOps::parseMultipartRequest(HttpRequest & _req,
     }
     DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Davix::parseMultipartRequest multi-part boundary {}", boundary);
 
-    while(1) {
-       DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Davix::parseMultipartRequest parsing a new chunk");
-       ChunkInfo infos;
-       int n_try = 0;
+    // payloads go straight from the read buffer into the chunks they belong to
+    MultipartParser parser(boundary, [&chunks](dav_off_t offset, const char *data, dav_size_t size) {
+        fillChunks(data, chunks, offset, size);
+    });
 
-       tmp_ret = parse_multi_part_header(_req, boundary, infos, n_try, err);
-       if(tmp_ret == -2) break; // terminating boundary
-       if(tmp_ret == -1) return -1; // error
+    std::vector<char> buffer(multipart_block_size);
+    while(!parser.done()) {
+        dav_ssize_t read = _req.readBlock(&buffer[0], buffer.size(), err);
+        if(read < 0)
+            return -1;
 
-       if( (tmp_ret = copyChunk(_req, tree, infos.offset, infos.size, err)) <0 )
-           return -1;
+        if(read == 0) { // truncated response
+            HttpIoVecSetupErrorMultiPart(err);
+            return -1;
+        }
 
-       ret += tmp_ret;
-       DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Davix::parseMultipartRequest chunk parsed with success, next chunk..");
+        if(parser.feed(&buffer[0], read, err) < 0)
+            return -1;
     }
+    ret = parser.payloadBytes();
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Davix::parseMultipartRequest {} bytes parsed with success", ret);
 
     // finish with success, dump the remaining part of the query to end the request properly
-    char buffer[255];
-    while( _req.readBlock(buffer, 255, NULL) > 0);
+    while( _req.readBlock(&buffer[0], buffer.size(), NULL) > 0);
 
     return ret;
 }
 
-dav_ssize_t HttpIOVecOps::simulateMultiPartRequest(HttpRequest & _req, const IntervalTree<ElemChunk> & tree, DavixError** err) {
+dav_ssize_t HttpIOVecOps::simulateMultiPartRequest(HttpRequest & _req, const ChunkIndex & chunks, DavixError** err) {
     DAVIX_SLOG(DAVIX_LOG_TRACE, DAVIX_LOG_CHAIN, " -> Davix vec : 200 full file, simulate vec io");
     char buffer[DAVIX_READ_BLOCK_SIZE+1];
     dav_ssize_t partial_read_size = 0, total_read_size = 0;
     while( (partial_read_size = _req.readBlock(buffer, DAVIX_READ_BLOCK_SIZE, err)) >0) {
-        fillChunks(buffer, tree, total_read_size, partial_read_size);
+        fillChunks(buffer, chunks, total_read_size, partial_read_size);
         total_read_size += partial_read_size;
     }
 
@@ -25,21 +25,13 @@
 #include <davix.hpp>
 #include <fileops/iobuffmap.hpp>
 #include <fileops/httpiochain.hpp>
-#include "libs/IntervalTree.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace Davix{
 
 // simple chunk info handler
-struct ChunkInfo {
-    ChunkInfo() :
-        offset(0),
-        size(0),
-        bounded(false){}
-    dav_off_t offset;
-    dav_size_t size;
-    bool bounded;
-};
-
 struct ElemChunk{
     ElemChunk(const DavIOVecInput* in, DavIOVecOuput* ou) :
         _in(in),
@@ -58,6 +50,51 @@ struct ElemChunk{
 typedef std::multimap<dav_off_t, ElemChunk> MapChunk;
 typedef std::vector<std::pair<dav_off_t, dav_size_t> > SortedRanges;
 
+////
+/// \brief The ChunkIndex class
+///
+/// chunks of a vectored read, kept in flat arrays sorted by offset.
+/// Chunks may overlap: along with the inclusive [start, stop] ranges we keep the
+/// running maximum of stop, so the chunks overlapping a range are found with two
+/// binary searches. Empty chunks are left out, they have nothing to receive.
+class ChunkIndex
+{
+public:
+    ChunkIndex(const DavIOVecInput *in, DavIOVecOuput *out, const dav_size_t count);
+
+    dav_size_t size() const { return _starts.size(); }
+
+    dav_off_t start(dav_size_t i) const { return _starts[i]; }
+    dav_off_t stop(dav_size_t i) const { return _stops[i]; }
+
+    /// call fn on every chunk overlapping [start, stop], return how many there were
+    template<typename Fn>
+    dav_size_t forEachOverlapping(dav_off_t start, dav_off_t stop, Fn fn) const {
+        // before first, every chunk stops ahead of start - past the first chunk
+        // starting after stop, every chunk does
+        const dav_size_t first = std::lower_bound(_maxStops.begin(), _maxStops.end(), start) - _maxStops.begin();
+
+        dav_size_t matches = 0;
+        for(dav_size_t i = first; i < _starts.size() && _starts[i] <= stop; i++) {
+            if(_stops[i] >= start) {
+                fn(_chunks[i]);
+                matches++;
+            }
+        }
+        return matches;
+    }
+
+private:
+    std::vector<dav_off_t> _starts;
+    std::vector<dav_off_t> _stops;
+    std::vector<dav_off_t> _maxStops;
+    std::vector<ElemChunk> _chunks;
+};
+
+/// merge the chunks closer than mergedist to each other into ranges,
+/// gap_bytes is set to the number of bytes in between merged chunks
+SortedRanges partialMerging(const ChunkIndex & chunks, const dav_size_t mergedist, dav_size_t & gap_bytes);
+
 struct MultirangeResult {
     enum OperationResult { SUCCESS, NOMULTIRANGE, SUCCESS_BUT_NO_MULTIRANGE };
     OperationResult res;
@@ -81,45 +118,49 @@ public:
                               DavIOVecOuput * output_vec,
                               const dav_size_t count_vec);
 
-    // these two should have been private, but because of pthread we need to call them from
-    // a function
+private:
     dav_ssize_t singleRangeRequest(IOChainContext & iocontext,
                                    const DavIOVecInput * input,
                                    DavIOVecOuput * output);
 
     dav_ssize_t singleRangeRequest(IOChainContext & iocontext,
-                                   const IntervalTree<ElemChunk> & tree,
+                                   const ChunkIndex & chunks,
                                    dav_off_t offset, dav_size_t size);
 
-private:
 
     MultirangeResult performMultirange(IOChainContext & iocontext,
-                                       const IntervalTree<ElemChunk> &tree,
-                                       const SortedRanges & ranges);
+                                       const ChunkIndex & chunks,
+                                       const SortedRanges & ranges,
+                                       uint nconnections);
+
+    MultirangeResult::OperationResult performMultirangeBatch(IOChainContext & iocontext,
+                                                             const ChunkIndex & chunks,
+                                                             const SortedRanges & ranges,
+                                                             dav_size_t first,
+                                                             const std::pair<dav_size_t, std::string> & batch,
+                                                             dav_ssize_t bytes_to_read,
+                                                             bool allow_full_file,
+                                                             dav_ssize_t & ret,
+                                                             DavixError** err);
 
     dav_ssize_t simulateMultirange(IOChainContext & iocontext,
-                                   const IntervalTree<ElemChunk> & tree,
+                                   const ChunkIndex & chunks,
                                    const SortedRanges & ranges,
                                    uint nconnections);
 
     dav_ssize_t parseMultipartRequest(HttpRequest & req,
-                                      const IntervalTree<ElemChunk> & tree,
+                                      const ChunkIndex & chunks,
                                       DavixError** tmp_err);
 
     dav_ssize_t simulateMultiPartRequest(HttpRequest & _req,
-                                         const IntervalTree<ElemChunk> & tree,
+                                         const ChunkIndex & chunks,
                                          DavixError** err);
 };
 
 
-int find_header_params(char* buffer, dav_size_t buffer_len, dav_size_t* part_size, dav_off_t* part_offset);
-
 int http_extract_boundary_from_content_type(const std::string & buffer, std::string & boundary, DavixError** err);
 
 
-int parse_multi_part_header(HttpRequest& req, const std::string & boundary, ChunkInfo & info,
-                            int & n_try, DavixError** err);
-
 void HttpIoVecSetupErrorMultiPart(DavixError** err);
 
 } // Davix
@@ -22,15 +22,22 @@
 #include <davix_internal_config.hpp>
 #include "iobuffmap.hpp"
 
+#include <backend/SessionFactory.hpp>
 #include <core/ContentProvider.hpp>
+#include <core/LinkEstimator.hpp>
 #include <utils/davix_types.hpp>
 #include <request/httprequest.hpp>
 #include <utils/davix_logger_internal.hpp>
 #include <fileops/httpiovec.hpp>
 #include <fileops/davmeta.hpp>
 #include <system_utils/env_utils.hpp>
+#include <davix_context_internal.hpp>
+#include <core/WorkerPool.hpp>
+#include <fileops/chain_factory.hpp>
 
 
+#include <chrono>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -79,6 +86,47 @@ dav_ssize_t read_segment_request(HttpRequest* req, void* buffer, dav_size_t size
     return ret;
 }
 
+std::shared_ptr<std::vector<char> > fetch_range_request(Context & context, const Uri & uri, const RequestParams & reqparams,
+                                                         dav_off_t offset, dav_size_t size, std::string* etag, DavixError** err){
+    DavixError* tmp_err=NULL;
+    std::shared_ptr<std::vector<char> > data;
+
+    HttpRequest req(context, uri, &tmp_err);
+    if(tmp_err == NULL){
+        RequestParams params(reqparams);
+        req.setParameters(params);
+        setup_offset_request(&req, &offset, &size, 1);
+
+        if(req.beginRequest(&tmp_err) == 0){
+            std::string range;
+            const int code = req.getRequestCode();
+
+            if(code == 416){ // out of file
+                data = std::make_shared<std::vector<char> >();
+                DavixError::clearError(&tmp_err);
+            }else if(code == 206 || (code == 200 && req.getAnswerHeader("Content-Range", range))){
+                data = std::make_shared<std::vector<char> >(size);
+                dav_ssize_t ret = read_segment_request(&req, data->data(), size, &tmp_err);
+                if(ret >= 0){
+                    data->resize(ret);
+                    if(etag)
+                        req.getAnswerHeader("ETag", *etag);
+                }
+            }else if(code != 200){
+                httpcodeToDavixError(code, davix_scope_http_request(), ", while reading", &tmp_err);
+            }
+            // else: ranges not supported, the whole file came back
+        }
+        req.endRequest(NULL);
+    }
+
+    if(tmp_err){
+        data.reset();
+        DavixError::propagateError(err, tmp_err);
+    }
+    return data;
+}
+
 
 dav_ssize_t read_truncated_segment_request(HttpRequest* req, void* buffer, dav_size_t size_read,  dav_off_t off_set, DavixError**err){
      DavixError* tmp_err=NULL;
@@ -193,7 +241,9 @@ dav_ssize_t HttpIO::pread(IOChainContext & iocontext, void *buf, dav_size_t coun
         RequestParams params(iocontext._reqparams);
         req.setParameters(params);
         setup_offset_request(&req, &offset, &count,1);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         if(req.beginRequest(&tmp_err) ==0){
+            const std::chrono::steady_clock::time_point headers = std::chrono::steady_clock::now();
             if(req.getRequestCode() == 416 ){ // out of file, end of file
                 ret = 0; // end of file
                 DavixError::clearError(&tmp_err);
@@ -203,6 +253,14 @@ dav_ssize_t HttpIO::pread(IOChainContext & iocontext, void *buf, dav_size_t coun
                     (req.getRequestCode() == 200 && _supports_partial_content(offset, count))) {
                     ret = read_segment_request(&req, buf, count, &tmp_err);
 
+                    // feed the link estimates used to size vectored read merge windows
+                    if(ret > 0) {
+                        ContextExplorer::LinkEstimatorFromContext(iocontext._context).recordRequest(
+                            SessionFactory::makeSessionKey(iocontext._uri),
+                            std::chrono::duration_cast<std::chrono::microseconds>(headers - start), ret,
+                            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - headers));
+                    }
+
                     // clean remaining content
                     if(!tmp_err) {
                         char buffer[255];
@@ -210,6 +268,7 @@ dav_ssize_t HttpIO::pread(IOChainContext & iocontext, void *buf, dav_size_t coun
                     }
 
                 }else if( req.getRequestCode() == 200){ // full request content -> skip useless content
+                    iocontext.rangeIgnored = true;
                     ret = read_truncated_segment_request(&req, buf, count, offset, &tmp_err);
                 }else{
                     httpcodeToDavixError(req.getRequestCode(), davix_scope_http_request(),", while  readding", &tmp_err);
@@ -225,10 +284,128 @@ dav_ssize_t HttpIO::pread(IOChainContext & iocontext, void *buf, dav_size_t coun
 
 #define SSTR(message) static_cast<std::ostringstream&>(std::ostringstream().flush() << message).str()
 
+// read a segment of the file through the chain, and write it at its offset
+static void copySegment(HttpIOChain & chain, IOChainContext & iocontext, int fd, dav_off_t fd_offset,
+                        std::vector<char> & buffer, dav_off_t offset, dav_size_t size){
+    buffer.resize(std::max<dav_size_t>(buffer.size(), size));
+
+    const dav_ssize_t ret = chain.pread(iocontext, buffer.data(), size, offset);
+    if(ret != (dav_ssize_t) size){
+        throw DavixException(davix_scope_io_buff(), StatusCode::InvalidServerResponse,
+                             fmt::format("Got {} bytes instead of {} at offset {}, file changed during the transfer?", ret, size, offset));
+    }
+
+    dav_size_t written = 0;
+    while(written < size){
+        const ssize_t w = ::pwrite(fd, buffer.data() + written, size - written, fd_offset + offset + written);
+        if(w < 0){
+            if(errno == EINTR)
+                continue;
+            throw DavixException(davix_scope_io_buff(), StatusCode::SystemError,
+                                 std::string("Impossible to write to fd: ").append(strerror(errno)));
+        }
+        written += w;
+    }
+}
+
+dav_ssize_t HttpIO::readToFdSegmented(IOChainContext & iocontext, int fd, dav_size_t read_size, unsigned int streams){
+    struct stat fd_st;
+    const off_t fd_offset = ::lseek(fd, 0, SEEK_CUR);
+    if(fstat(fd, &fd_st) != 0 || S_ISREG(fd_st.st_mode) == false || fd_offset < 0){
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Output is not a regular file, downloading {} with a single stream", iocontext._uri);
+        return -1;
+    }
+
+    // the size must be the current one, a stale cached one would truncate
+    // the output - and a server refusing HEAD can still serve a single stream
+    StatInfo st;
+    IOChainContext stat_context(iocontext._context, iocontext._uri, iocontext._reqparams);
+    stat_context.bypassCaches = true;
+    try{
+        _start->statInfo(stat_context, st);
+    }catch(DavixException & e){
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Unable to stat {} ({}), downloading it with a single stream", iocontext._uri, e.what());
+        return -1;
+    }
+
+    const dav_size_t total = (read_size > 0) ? std::min<dav_size_t>(read_size, st.size) : st.size;
+    if(total <= DAVIX_MIN_SEGMENT_SIZE)
+        return -1;
+
+    // the first segment on its own: tells whether the server honours ranges
+    IOChainContext probe(iocontext._context, iocontext._uri, iocontext._reqparams);
+    probe.bypassCaches = true;
+    std::vector<char> first;
+    copySegment(*_start, probe, fd, fd_offset, first, 0, DAVIX_MIN_SEGMENT_SIZE);
+    if(probe.rangeIgnored){
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "No range support for {}, downloading it with a single stream", iocontext._uri);
+        return -1;
+    }
+
+    DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Downloading {} bytes of {} with {} streams", total, iocontext._uri, streams);
+
+    std::mutex mutex;
+    dav_off_t next = DAVIX_MIN_SEGMENT_SIZE;
+    bool failed = false;
+
+    ContextExplorer::WorkerPoolFromContext(iocontext._context).parallelFor(streams, streams, [&](size_t) {
+        // retries of each segment happen within the chain
+        IOChainContext segment_context(iocontext._context, iocontext._uri, iocontext._reqparams);
+        segment_context.bypassCaches = true;
+
+        std::vector<char> buffer;
+        dav_size_t segment = DAVIX_MIN_SEGMENT_SIZE;
+
+        while(true){
+            dav_off_t offset;
+            dav_size_t size;
+            {
+                std::lock_guard<std::mutex> l(mutex);
+                if(failed || next >= (dav_off_t) total)
+                    return;
+
+                // smaller segments towards the end, so that streams finish together
+                size = std::max<dav_size_t>(DAVIX_MIN_SEGMENT_SIZE, (total - next) / streams);
+                size = std::min<dav_size_t>(std::min(segment, size), total - next);
+                offset = next;
+                next += size;
+            }
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try{
+                copySegment(*_start, segment_context, fd, fd_offset, buffer, offset, size);
+            }catch(...){
+                std::lock_guard<std::mutex> l(mutex);
+                failed = true;
+                throw;
+            }
+
+            // size the next segment to take DAVIX_SEGMENT_TARGET_TIME at this rate
+            const dav_size_t elapsed = std::max<dav_size_t>(1, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                                   std::chrono::steady_clock::now() - start).count());
+            segment = std::min<dav_size_t>(DAVIX_MAX_SEGMENT_SIZE,
+                                           std::max<dav_size_t>(DAVIX_MIN_SEGMENT_SIZE, size * DAVIX_SEGMENT_TARGET_TIME / elapsed));
+        }
+    });
+
+    ::lseek(fd, fd_offset + total, SEEK_SET);
+    return total;
+}
+
 dav_ssize_t HttpIO::readToFd(IOChainContext & iocontext, int fd, dav_size_t read_size){
     DavixError * tmp_err=NULL;
     dav_ssize_t ret = -1;
 
+    const unsigned int streams = iocontext._reqparams->getTransferStreams();
+    if(streams > 1 && (iocontext.fdHandler.fd != fd || iocontext.fdHandler.bytes_written_to_fd == 0)){
+        iocontext.fdHandler.fd = fd;
+        iocontext.fdHandler.bytes_written_to_fd = 0;
+        if((ret = readToFdSegmented(iocontext, fd, read_size, streams)) >= 0){
+            iocontext.fdHandler.bytes_written_to_fd = ret;
+            return ret;
+        }
+    }
+
     if(iocontext.fdHandler.fd != fd) {
         iocontext.fdHandler.fd = fd;
         iocontext.fdHandler.bytes_written_to_fd = 0;
@@ -304,6 +481,90 @@ struct IOBufferLocalFile{
     std::string _filepath;
 };
 
+// maximum read-ahead window, DAVIX_READAHEAD_WINDOW bytes if set - 0 disables it
+static dav_size_t readAheadMaxWindow(){
+    const std::string env = EnvUtils::getEnv("DAVIX_READAHEAD_WINDOW", "");
+    if(env.empty())
+        return DAVIX_DEFAULT_MAX_READAHEAD_WINDOW;
+    return strtoull(env.c_str(), NULL, 10);
+}
+
+// fetch a read-ahead chunk, runs on the worker pool of the context - NULL if
+// ranges are not supported, the whole file would come back for each chunk
+static ReadAheadChunk::Data fetchReadAheadChunk(Context & context, const Uri & uri, const RequestParams & reqparams,
+                                                dav_off_t offset, dav_size_t size){
+    DavixError * tmp_err=NULL;
+    ReadAheadChunk::Data data = fetch_range_request(context, uri, reqparams, offset, size, NULL, &tmp_err);
+    checkDavixError(&tmp_err);
+    return data;
+}
+
+// ranges announced through fadvise, waiting to be fetched - shared with the
+// worker pool task fetching them, which may outlive the descriptor
+struct PrefetchQueue{
+    struct Request{
+        dav_off_t offset;
+        dav_size_t size;
+        std::shared_ptr<std::promise<ReadAheadChunk::Data> > promise;
+    };
+
+    PrefetchQueue(IOChainContext & iocontext) :
+        context(iocontext._context), uri(iocontext._uri), params(*iocontext._reqparams), pending(), running(false) {}
+
+    Context & context;
+    const Uri uri;
+    const RequestParams params;
+
+    std::mutex mutex;
+    std::vector<Request> pending;
+    bool running;
+};
+
+// fetch pending ranges with vectored reads until there are none left - ranges
+// announced during a fetch are batched into the next one
+static void drainPrefetchQueue(std::shared_ptr<PrefetchQueue> queue){
+    while(true){
+        std::vector<PrefetchQueue::Request> batch;
+        {
+            std::lock_guard<std::mutex> l(queue->mutex);
+            batch.swap(queue->pending);
+            if(batch.empty()){
+                queue->running = false;
+                return;
+            }
+        }
+
+        std::vector<ReadAheadChunk::Data> buffers(batch.size());
+        std::vector<DavIOVecInput> input(batch.size());
+        std::vector<DavIOVecOuput> output(batch.size());
+        for(size_t i = 0; i < batch.size(); i++){
+            buffers[i] = std::make_shared<std::vector<char> >(batch[i].size);
+            input[i].diov_buffer = buffers[i]->data();
+            input[i].diov_offset = batch[i].offset;
+            input[i].diov_size = batch[i].size;
+        }
+
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Prefetching {} ranges of {}", batch.size(), queue->uri);
+        std::exception_ptr error;
+        try{
+            HttpIOChain chain;
+            IOChainContext iocontext(queue->context, queue->uri, &queue->params);
+            ChainFactory::instanceChain(CreationFlags(), chain).preadVec(iocontext, input.data(), output.data(), batch.size());
+        }catch(...){
+            error = std::current_exception();
+        }
+
+        for(size_t i = 0; i < batch.size(); i++){
+            if(error){
+                batch[i].promise->set_exception(error);
+            }else{
+                buffers[i]->resize(std::max<dav_ssize_t>(output[i].diov_size, 0));
+                batch[i].promise->set_value(buffers[i]);
+            }
+        }
+    }
+}
+
 HttpIOBuffer::HttpIOBuffer() :
     HttpIOChain(),
     _file_size(0),
@@ -314,7 +575,16 @@ HttpIOBuffer::HttpIOBuffer() :
     _rwlock(),
     _read_pos(0),
     _read_endfile(false),
-    _read_req(NULL)
+    _read_req(NULL),
+    _readahead(),
+    _readahead_max(readAheadMaxWindow()),
+    _readahead_window(std::min<dav_size_t>(DAVIX_MIN_READAHEAD_WINDOW, _readahead_max)),
+    _readahead_streak(0),
+    _read_norange(false),
+    _prefetched(),
+    _prefetch_order(),
+    _prefetch_size(0),
+    _prefetch_queue()
 {
 
 }
@@ -395,9 +665,14 @@ dav_ssize_t HttpIOBuffer::read(IOChainContext & iocontext, void *buf, dav_size_t
         resetIO(iocontext);
     if(_pos == _read_pos && isAdviseFullRead()){
         // try read ahead strategie
-        ret = readInternal(iocontext, buf, count);
+        ret = isReadAhead() ? readAhead(iocontext, buf, count) : readInternal(iocontext, buf, count);
     }else{ // fallback on partial read
         ret = _start->pread(iocontext, buf, count, _pos);
+        if(isReadAhead()){
+            // seek: start over from here if the next read follows this one
+            collapseReadAhead();
+            _read_pos = _pos + std::max<dav_ssize_t>(ret, 0);
+        }
     }
     if(ret > 0)
         _pos += ret;
@@ -457,11 +732,261 @@ dav_ssize_t HttpIOBuffer::readInternal(IOChainContext & iocontext, void *buffer,
 
 
 
+dav_ssize_t HttpIOBuffer::readAhead(IOChainContext & iocontext, void *buffer, dav_size_t size_read){
+    char* p_buff = static_cast<char*>(buffer);
+    dav_size_t done = 0;
+
+    try{
+        while(done < size_read && _read_pos < (dav_off_t) _file_size){
+            scheduleReadAhead(iocontext);
+
+            ReadAheadChunk & chunk = _readahead.front();
+            ReadAheadChunk::Data data = chunk.data.get();
+            if(!data){
+                DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "No range support for {}, disable read-ahead", iocontext._uri);
+                collapseReadAhead();
+                _read_norange = true;
+                if(_read_pos == 0)
+                    return readInternal(iocontext, buffer, size_read);
+
+                // no stream to follow from here
+                const dav_off_t offset = _read_pos;
+                _read_pos = -1;
+                if(done > 0)
+                    break;
+                return _start->pread(iocontext, buffer, size_read, offset);
+            }
+
+            const dav_size_t in_chunk = _read_pos - chunk.offset;
+            if(in_chunk >= data->size()){ // short chunk, the file shrunk
+                _file_size = _read_pos;
+                break;
+            }
+
+            const dav_size_t n = std::min<dav_size_t>(size_read - done, data->size() - in_chunk);
+            memcpy(p_buff + done, data->data() + in_chunk, n);
+            done += n;
+            _read_pos += n;
+
+            if(in_chunk + n == data->size()){
+                if(data->size() < chunk.size)
+                    _file_size = _read_pos;
+                _readahead.pop_front();
+            }
+
+            // sustained sequential access: open the window
+            _readahead_streak += n;
+            if(_readahead_streak >= _readahead_window && _readahead_window < _readahead_max){
+                _readahead_window = std::min<dav_size_t>(_readahead_window * 2, _readahead_max);
+                _readahead_streak = 0;
+                DAVIX_SLOG(DAVIX_LOG_TRACE, DAVIX_LOG_CHAIN, "Read-ahead window of {} is now {} bytes", iocontext._uri, _readahead_window);
+            }
+        }
+    }catch(...){
+        collapseReadAhead();
+        throw;
+    }
+
+    return done;
+}
+
+
+void HttpIOBuffer::scheduleReadAhead(IOChainContext & iocontext){
+    const dav_off_t end = std::min<dav_off_t>(_read_pos + _readahead_window, _file_size);
+    dav_off_t next = _readahead.empty() ? _read_pos : (_readahead.back().offset + _readahead.back().size);
+    if(next >= end)
+        return;
+
+    // tasks may outlive this descriptor, give them their own copies
+    Context & context = iocontext._context;
+    const Uri uri(iocontext._uri);
+    std::shared_ptr<RequestParams> params = std::make_shared<RequestParams>(*iocontext._reqparams);
+    WorkerPool & pool = ContextExplorer::WorkerPoolFromContext(context);
+
+    // fewer, larger requests as the window opens
+    const dav_size_t chunk_size = std::max<dav_size_t>(DAVIX_READAHEAD_CHUNK_SIZE, _readahead_window / 8);
+
+    do{
+        ReadAheadChunk chunk;
+        chunk.offset = next;
+        chunk.size = std::min<dav_size_t>(chunk_size, _file_size - next);
+        const dav_off_t offset = chunk.offset;
+        const dav_size_t size = chunk.size;
+        chunk.data = pool.async<ReadAheadChunk::Data>([&context, uri, params, offset, size]() {
+            return fetchReadAheadChunk(context, uri, *params, offset, size);
+        }).share();
+
+        next += chunk.size;
+        _readahead.push_back(std::move(chunk));
+    }while(next < end);
+}
+
+
+void HttpIOBuffer::collapseReadAhead(){
+    // chunks in flight complete in the background, and are thrown away
+    _readahead.clear();
+    _readahead_window = std::min<dav_size_t>(DAVIX_MIN_READAHEAD_WINDOW, _readahead_max);
+    _readahead_streak = 0;
+}
+
+
 void HttpIOBuffer::prefetchInfo(IOChainContext & iocontext, off_t offset, dav_size_t size_read, advise_t adv){
-    (void) iocontext;
-    (void) offset;
-    (void) size_read;
-    _last_advise = adv;
+    std::lock_guard<std::recursive_mutex> l(_rwlock);
+
+    // not an access pattern
+    if(adv != AdviseWillNeed)
+        _last_advise = adv;
+
+    if((adv == AdviseRandom || adv == AdviseWillNeed) && size_read > 0 && size_read <= DAVIX_PREFETCH_MAX_SIZE)
+        prefetch(iocontext, offset, size_read);
+}
+
+
+void HttpIOBuffer::prefetch(IOChainContext & iocontext, dav_off_t offset, dav_size_t size){
+    ReadAheadChunk chunk;
+    if(lookupPrefetched(offset, size, chunk))
+        return;
+
+    std::shared_ptr<std::promise<ReadAheadChunk::Data> > promise = std::make_shared<std::promise<ReadAheadChunk::Data> >();
+    chunk.offset = offset;
+    chunk.size = size;
+    chunk.data = promise->get_future().share();
+
+    // a larger range at the same offset replaces the previous one
+    std::map<dav_off_t, ReadAheadChunk>::iterator it = _prefetched.find(offset);
+    if(it != _prefetched.end()){
+        _prefetch_size -= it->second.size;
+        _prefetched.erase(it);
+    }
+    _prefetched.insert(std::make_pair(offset, chunk));
+    _prefetch_order.push_back(std::make_pair(offset, size));
+    _prefetch_size += size;
+
+    // oldest ranges go first
+    while(_prefetch_size > DAVIX_PREFETCH_MAX_SIZE && _prefetch_order.empty() == false){
+        it = _prefetched.find(_prefetch_order.front().first);
+        if(it != _prefetched.end() && it->second.size == _prefetch_order.front().second){
+            _prefetch_size -= it->second.size;
+            _prefetched.erase(it);
+        }
+        _prefetch_order.pop_front();
+    }
+
+    if(!_prefetch_queue)
+        _prefetch_queue = std::make_shared<PrefetchQueue>(iocontext);
+
+    bool start = false;
+    {
+        std::lock_guard<std::mutex> l(_prefetch_queue->mutex);
+        PrefetchQueue::Request request;
+        request.offset = offset;
+        request.size = size;
+        request.promise = promise;
+        _prefetch_queue->pending.push_back(request);
+
+        start = (_prefetch_queue->running == false);
+        _prefetch_queue->running = true;
+    }
+
+    if(start){
+        std::shared_ptr<PrefetchQueue> queue = _prefetch_queue;
+        ContextExplorer::WorkerPoolFromContext(iocontext._context).submit([queue]() {
+            drainPrefetchQueue(queue);
+        });
+    }
+}
+
+
+bool HttpIOBuffer::lookupPrefetched(dav_off_t offset, dav_size_t size, ReadAheadChunk & chunk){
+    std::lock_guard<std::recursive_mutex> l(_rwlock);
+
+    // the last range starting at or before offset
+    std::map<dav_off_t, ReadAheadChunk>::iterator it = _prefetched.upper_bound(offset);
+    if(it == _prefetched.begin())
+        return false;
+    --it;
+
+    if(offset + size > it->second.offset + it->second.size)
+        return false;
+
+    chunk = it->second;
+    return true;
+}
+
+
+dav_ssize_t HttpIOBuffer::readPrefetched(IOChainContext & iocontext, const ReadAheadChunk & chunk, void* buf, dav_size_t count, dav_off_t offset){
+    ReadAheadChunk::Data data;
+    try{
+        data = chunk.data.get();
+    }catch(DavixException & e){
+        DAVIX_SLOG(DAVIX_LOG_DEBUG, DAVIX_LOG_CHAIN, "Prefetch of {} failed, reading remotely: {}", iocontext._uri, e.what());
+
+        std::lock_guard<std::recursive_mutex> l(_rwlock);
+        std::map<dav_off_t, ReadAheadChunk>::iterator it = _prefetched.find(chunk.offset);
+        if(it != _prefetched.end() && it->second.size == chunk.size){
+            _prefetch_size -= it->second.size;
+            _prefetched.erase(it);
+        }
+        return -1;
+    }
+
+    // a short range ends the file
+    const dav_size_t in_chunk = offset - chunk.offset;
+    if(in_chunk >= data->size())
+        return 0;
+
+    const dav_size_t n = std::min<dav_size_t>(count, data->size() - in_chunk);
+    memcpy(buf, data->data() + in_chunk, n);
+    return n;
+}
+
+
+dav_ssize_t HttpIOBuffer::pread(IOChainContext & iocontext, void* buf, dav_size_t count, dav_off_t offset){
+    ReadAheadChunk chunk;
+    if(count > 0 && lookupPrefetched(offset, count, chunk)){
+        const dav_ssize_t ret = readPrefetched(iocontext, chunk, buf, count, offset);
+        if(ret >= 0)
+            return ret;
+    }
+
+    CHAIN_FORWARD(pread(iocontext, buf, count, offset));
+}
+
+
+dav_ssize_t HttpIOBuffer::preadVec(IOChainContext & iocontext, const DavIOVecInput * input_vec,
+                                   DavIOVecOuput * output_vec, const dav_size_t count_vec){
+    std::vector<DavIOVecInput> remote_input;
+    std::vector<dav_size_t> remote_index;
+    dav_ssize_t total = 0;
+
+    for(dav_size_t i = 0; i < count_vec; i++){
+        ReadAheadChunk chunk;
+        dav_ssize_t ret = -1;
+        if(input_vec[i].diov_size > 0 && lookupPrefetched(input_vec[i].diov_offset, input_vec[i].diov_size, chunk))
+            ret = readPrefetched(iocontext, chunk, input_vec[i].diov_buffer, input_vec[i].diov_size, input_vec[i].diov_offset);
+
+        if(ret >= 0){
+            output_vec[i].diov_buffer = input_vec[i].diov_buffer;
+            output_vec[i].diov_size = ret;
+            total += ret;
+        }else{
+            remote_input.push_back(input_vec[i]);
+            remote_index.push_back(i);
+        }
+    }
+
+    if(remote_input.size() == count_vec){
+        CHAIN_FORWARD(preadVec(iocontext, input_vec, output_vec, count_vec));
+    }
+    if(remote_input.empty())
+        return total;
+
+    std::vector<DavIOVecOuput> remote_output(remote_input.size());
+    total += HttpIOChain::preadVec(iocontext, remote_input.data(), remote_output.data(), remote_input.size());
+    for(size_t i = 0; i < remote_index.size(); i++){
+        output_vec[remote_index[i]] = remote_output[i];
+    }
+    return total;
 }
 
 
@@ -473,6 +998,8 @@ void HttpIOBuffer::resetIO(IOChainContext & iocontext){
         _read_req = NULL;
     }
     _read_pos =0;
+    _read_endfile = false;
+    collapseReadAhead();
     commitLocal(iocontext);
 }
 
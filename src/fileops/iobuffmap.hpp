@@ -26,7 +26,10 @@
 #include <davix_internal.hpp>
 #include <fileops/fileutils.hpp>
 #include <fileops/httpiochain.hpp>
-
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
 
 
 namespace Davix {
@@ -60,6 +63,9 @@ public:
 
 private:
 
+    // download the file with concurrent range requests, written at their
+    // offsets - -1 if it can't be downloaded that way
+    dav_ssize_t readToFdSegmented(IOChainContext & iocontext, int fd, dav_size_t size, unsigned int streams);
 
     HttpIO(const HttpIO & );
     HttpIO & operator=(const HttpIO & );
@@ -69,6 +75,17 @@ private:
 
 
 struct IOBufferLocalFile;
+struct PrefetchQueue;
+
+/// segment of the file fetched in the background, ahead of the reader
+struct ReadAheadChunk{
+    typedef std::shared_ptr<std::vector<char> > Data;
+
+    dav_off_t offset;
+    dav_size_t size;
+    // NULL if the server ignored the range
+    std::shared_future<Data> data;
+};
 
 ///
 /// RW operation with buffering support and POSIX like interface
@@ -88,6 +105,14 @@ public:
     // give information on the future operation for prefecting
     virtual void prefetchInfo(IOChainContext & iocontext, off_t offset, dav_size_t size_read, advise_t adv);
 
+    // position independant read, served from the prefetched ranges if possible
+    virtual dav_ssize_t pread(IOChainContext & iocontext, void* buf, dav_size_t count, dav_off_t offset);
+
+    // vectored read, served from the prefetched ranges if possible
+    virtual dav_ssize_t preadVec(IOChainContext & iocontext, const DavIOVecInput * input_vec,
+                              DavIOVecOuput * output_vec,
+                              const dav_size_t count_vec);
+
     //
     virtual dav_ssize_t write(IOChainContext & iocontext, const void* buf, dav_size_t count);
 
@@ -117,14 +142,50 @@ protected:
     bool _read_endfile;
     HttpRequest * _read_req;
 
+    // sequential read-ahead, when the size of the file is known
+    // and the server supports ranges
+    std::deque<ReadAheadChunk> _readahead;
+    dav_size_t _readahead_max;
+    dav_size_t _readahead_window;
+    dav_size_t _readahead_streak;
+    bool _read_norange;
+
+    // ranges announced through fadvise, by offset, and in order of arrival
+    std::map<dav_off_t, ReadAheadChunk> _prefetched;
+    std::deque<std::pair<dav_off_t, dav_size_t> > _prefetch_order;
+    dav_size_t _prefetch_size;
+    std::shared_ptr<PrefetchQueue> _prefetch_queue;
+
 private:
 
     inline bool isAdviseFullRead(){
         return (_last_advise == AdviseAuto || _last_advise == AdviseSequential);
     }
 
+    inline bool isReadAhead(){
+        return (_readahead_max > 0 && _file_size > 0 && !_read_norange);
+    }
+
     dav_ssize_t readInternal(IOChainContext & iocontext, void *buffer, dav_size_t size_read);
 
+    // serve a sequential read from the read-ahead window
+    dav_ssize_t readAhead(IOChainContext & iocontext, void *buffer, dav_size_t size_read);
+
+    // keep the read-ahead window full
+    void scheduleReadAhead(IOChainContext & iocontext);
+
+    // drop the read-ahead window after a seek
+    void collapseReadAhead();
+
+    // fetch the given range in the background
+    void prefetch(IOChainContext & iocontext, dav_off_t offset, dav_size_t size);
+
+    // find a prefetched range covering the given one
+    bool lookupPrefetched(dav_off_t offset, dav_size_t size, ReadAheadChunk & chunk);
+
+    // serve a read from a prefetched range, -1 if the fetch failed
+    dav_ssize_t readPrefetched(IOChainContext & iocontext, const ReadAheadChunk & chunk, void* buf, dav_size_t count, dav_off_t offset);
+
     HttpIOBuffer(const HttpIOBuffer & );
     HttpIOBuffer & operator=(const HttpIOBuffer & );
 };
@@ -135,6 +196,12 @@ int get_valid_cache_file(FILE** stream, DavixError** err);
 
 dav_ssize_t read_segment_request(HttpRequest* req, void* buffer, dav_size_t size_read, DavixError**err);
 
+// fetch [offset, offset + size) with a single range request - empty past the end
+// of the file, NULL if the server ignored the range and sent the whole file.
+// etag is set to the ETag of the answer if given
+std::shared_ptr<std::vector<char> > fetch_range_request(Context & context, const Uri & uri, const RequestParams & reqparams,
+                                                         dav_off_t offset, dav_size_t size, std::string* etag, DavixError** err);
+
 
 } // namespace Davix
 
@@ -3,10 +3,14 @@
 #include <functional>
 #include <algorithm>
 #include <map>
+#include <list>
+#include <vector>
 #include <limits>
 #include <utility>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <chrono>
 
 
 namespace Davix {
@@ -14,14 +18,50 @@ namespace Davix {
 ///
 /// Thread Safe Cache container
 ///
-template <class Key, class Value, class CompareT = std::less<Key> >
+/// Entries are spread over shards by the hash of their key, each with its own lock,
+/// and evicted in LRU order once a shard holds its share of the maximum size.
+/// Entries may expire: after the TTL of the cache, or their own if given on insert.
+/// Expired entries are never returned, and dropped as soon as they are seen.
+///
+template <class Key, class Value, class CompareT = std::less<Key>, class HashT = std::hash<Key> >
 class Cache {
-    typedef std::map<Key, std::shared_ptr<Value> > Map;
     typedef std::shared_ptr<Value> shrPtr_type;
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry;
+    typedef std::map<Key, Entry, CompareT> Map;
+    typedef std::list<typename Map::iterator> LruList;
+
+    struct Entry {
+        shrPtr_type value;
+        Clock::time_point expires;
+        typename LruList::iterator lru;
+    };
+
+    struct Shard {
+        Shard(const CompareT & cmp) : map(cmp) {}
+
+        Map map;
+        LruList lru; // most recently used first
+        std::mutex m;
+    };
 
 public:
-    Cache(size_t max_size = std::numeric_limits<size_t>::max()) :
-        cmp(CompareT()), map(cmp), _max_size(max_size), _m(){}
+    typedef Clock::duration Duration;
+
+    ///
+    /// \brief create a cache
+    /// \param max_size maximum number of entries
+    /// \param ttl lifetime of the entries, zero for no expiry
+    /// \param shards number of independently locked shards
+    ///
+    Cache(size_t max_size = std::numeric_limits<size_t>::max(), Duration ttl = Duration::zero(), size_t shards = 1) :
+        cmp(CompareT()), hasher(HashT()), _ttl(ttl), _hits(0), _misses(0), _evictions(0){
+        for(size_t i = 0; i < std::max<size_t>(shards, 1); i++){
+            _shards.emplace_back(new Shard(cmp));
+        }
+        setMaxSize(max_size);
+    }
 
     ~Cache(){}
 
@@ -36,12 +76,38 @@ public:
     /// \return
     ///
     shrPtr_type insert(const Key & key, const shrPtr_type & value){
-        std::lock_guard<std::mutex> l(_m);
-        auto_clean();
-        std::pair< typename Map::iterator, bool > stored = map.insert(std::pair<Key,shrPtr_type> (key, value) );
-        if(stored.second)
-            return (*stored.first).second;
-        (*stored.first).second = value;
+        return insert(key, value, _ttl);
+    }
+
+    ///
+    /// \brief insert a new value into the cache with its own lifetime, replacing any existing one
+    /// \param key
+    /// \param value
+    /// \param ttl lifetime of the entry, zero for no expiry
+    /// \return
+    ///
+    shrPtr_type insert(const Key & key, const shrPtr_type & value, Duration ttl){
+        Shard & shard = getShard(key);
+        std::lock_guard<std::mutex> l(shard.m);
+
+        typename Map::iterator it = shard.map.find(key);
+        if(it == shard.map.end()){
+            while(shard.map.size() >= _shard_size && !shard.lru.empty()){
+                shard.map.erase(shard.lru.back());
+                shard.lru.pop_back();
+                _evictions++;
+            }
+
+            it = shard.map.insert(std::make_pair(key, Entry())).first;
+            shard.lru.push_front(it);
+            it->second.lru = shard.lru.begin();
+        }
+        else{
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        }
+
+        it->second.value = value;
+        it->second.expires = (ttl == Duration::zero()) ? Clock::time_point::max() : Clock::now() + ttl;
         return value;
     }
 
@@ -51,11 +117,22 @@ public:
     /// \return
     ///
     shrPtr_type find(const Key & key){
-        std::lock_guard<std::mutex> l(_m);
-        typename Map::iterator it = map.find( key);
-        if(it == map.end())
+        Shard & shard = getShard(key);
+        std::lock_guard<std::mutex> l(shard.m);
+
+        typename Map::iterator it = shard.map.find(key);
+        if(it != shard.map.end() && expired(shard, it, Clock::now())){
+            it = shard.map.end();
+        }
+
+        if(it == shard.map.end()){
+            _misses++;
             return shrPtr_type();
-        return it->second;
+        }
+
+        _hits++;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        return it->second.value;
     }
 
     ///
@@ -64,11 +141,25 @@ public:
     /// \return the next key
     ///
     const Key upper_bound(const Key & key) {
-        std::lock_guard<std::mutex> l(_m);
-        typename Map::iterator it = map.upper_bound( key);
-        if(it == map.end())
-            return Key();
-        return it->first;
+        const Clock::time_point now = Clock::now();
+        bool found = false;
+        Key next = Key();
+
+        for(size_t i = 0; i < _shards.size(); i++){
+            Shard & shard = *_shards[i];
+            std::lock_guard<std::mutex> l(shard.m);
+
+            typename Map::iterator it = shard.map.upper_bound(key);
+            while(it != shard.map.end() && it->second.expires <= now){
+                expired(shard, it++, now);
+            }
+
+            if(it != shard.map.end() && (!found || cmp(it->first, next))){
+                next = it->first;
+                found = true;
+            }
+        }
+        return next;
     }
 
     ///
@@ -76,8 +167,39 @@ public:
     /// \return
     ///
     size_t getSize() const{
-        std::lock_guard<std::mutex> l(_m);
-        return map.size();
+        size_t size = 0;
+        for(size_t i = 0; i < _shards.size(); i++){
+            std::lock_guard<std::mutex> l(_shards[i]->m);
+            size += _shards[i]->map.size();
+        }
+        return size;
+    }
+
+    ///
+    /// \brief set the maximum number of entries, evicting the least recently used ones if needed
+    /// \param max_size
+    ///
+    void setMaxSize(size_t max_size){
+        _max_size = max_size;
+        _shard_size = std::max<size_t>(max_size / _shards.size(), 1);
+
+        for(size_t i = 0; i < _shards.size(); i++){
+            Shard & shard = *_shards[i];
+            std::lock_guard<std::mutex> l(shard.m);
+            while(shard.map.size() > _shard_size){
+                shard.map.erase(shard.lru.back());
+                shard.lru.pop_back();
+                _evictions++;
+            }
+        }
+    }
+
+    ///
+    /// \brief getMaxSize return the maximum number of entries
+    /// \return
+    ///
+    size_t getMaxSize() const{
+        return _max_size;
     }
 
     ///
@@ -86,12 +208,15 @@ public:
     /// \return
     ///
     shrPtr_type take( const Key & key){
-        std::lock_guard<std::mutex> l(_m);
-        typename Map::iterator it = map.find( key);
-        if(it == map.end()) return shrPtr_type();
+        Shard & shard = getShard(key);
+        std::lock_guard<std::mutex> l(shard.m);
 
-        shrPtr_type ret = it->second;
-        map.erase(it);
+        typename Map::iterator it = shard.map.find( key);
+        if(it == shard.map.end() || expired(shard, it, Clock::now())) return shrPtr_type();
+
+        shrPtr_type ret = it->second.value;
+        shard.lru.erase(it->second.lru);
+        shard.map.erase(it);
         return ret;
     }
 
@@ -101,26 +226,97 @@ public:
     /// \return
     ///
     bool erase( const Key & key){
-        std::lock_guard<std::mutex> l(_m);
-        return ( map.erase(key) != 0);
+        Shard & shard = getShard(key);
+        std::lock_guard<std::mutex> l(shard.m);
+
+        typename Map::iterator it = shard.map.find( key);
+        if(it == shard.map.end() || expired(shard, it, Clock::now())) return false;
+
+        shard.lru.erase(it->second.lru);
+        shard.map.erase(it);
+        return true;
+    }
+
+    ///
+    /// \brief call fn(key, value) on every valid entry, in no particular order
+    ///
+    /// The LRU order is left untouched. fn is called with the lock of a shard held,
+    /// it must not use the cache.
+    ///
+    template<typename Fn>
+    void forEach(Fn fn){
+        const Clock::time_point now = Clock::now();
+        for(size_t i = 0; i < _shards.size(); i++){
+            Shard & shard = *_shards[i];
+            std::lock_guard<std::mutex> l(shard.m);
+
+            typename Map::iterator it = shard.map.begin();
+            while(it != shard.map.end()){
+                if(it->second.expires <= now){
+                    expired(shard, it++, now);
+                    continue;
+                }
+                fn(it->first, it->second.value);
+                ++it;
+            }
+        }
     }
 
     void clear(){
-        std::lock_guard<std::mutex> l(_m);
-        map.clear();
+        for(size_t i = 0; i < _shards.size(); i++){
+            std::lock_guard<std::mutex> l(_shards[i]->m);
+            _shards[i]->map.clear();
+            _shards[i]->lru.clear();
+        }
+    }
+
+    ///
+    /// \brief number of lookups which found a valid entry
+    ///
+    size_t hits() const{
+        return _hits;
+    }
+
+    ///
+    /// \brief number of lookups which found no entry, or an expired one
+    ///
+    size_t misses() const{
+        return _misses;
+    }
+
+    ///
+    /// \brief number of entries dropped to make room, or because they expired
+    ///
+    size_t evictions() const{
+        return _evictions;
     }
 
 
 protected:
     CompareT cmp;
-    Map map;
-    size_t _max_size;
-    mutable std::mutex _m;
+    HashT hasher;
+    std::vector<std::unique_ptr<Shard> > _shards;
+    Duration _ttl;
+    std::atomic<size_t> _max_size;
+    std::atomic<size_t> _shard_size;
 
-    void auto_clean(){
-        if(map.size() == _max_size){
-            map.clear();
-        }
+    std::atomic<size_t> _hits;
+    std::atomic<size_t> _misses;
+    std::atomic<size_t> _evictions;
+
+    Shard & getShard(const Key & key){
+        return *_shards[hasher(key) % _shards.size()];
+    }
+
+    // drop the entry if expired - the shard must be locked
+    bool expired(Shard & shard, typename Map::iterator it, Clock::time_point now){
+        if(it->second.expires > now)
+            return false;
+
+        shard.lru.erase(it->second.lru);
+        shard.map.erase(it);
+        _evictions++;
+        return true;
     }
 };
 
@@ -112,7 +112,10 @@ NeonRequest::NeonRequest(const BoundHooks &hooks, Context& context, const Uri &
     _redirects(0),
     _total_read_size(0),
     _headers_configured(false),
-    _accepted_202_retries(0) {
+    _accepted_202_retries(0),
+    _predicted_redirect(false),
+    _prediction_failed(false),
+    _checking_origin(false) {
 }
 
 
@@ -162,6 +165,11 @@ void NeonRequest::checkRedirectCache() {
     std::shared_ptr<Uri> redir_url;
     if(this->_params.getTransparentRedirectionSupport()) {
         redir_url = ContextExplorer::RedirectionResolverFromContext(_context).redirectionResolve(_request_type, *_current);
+
+        if(!redir_url && _current == _orig && _params.getRedirectionPrediction() && !_prediction_failed) {
+            redir_url = ContextExplorer::RedirectionResolverFromContext(_context).redirectionPredict(_request_type, *_current);
+            _predicted_redirect = (redir_url.get() != NULL);
+        }
     }
 
     // performing an operation which could change the PFN? Clear all cache entries for selected URL
@@ -174,6 +182,23 @@ void NeonRequest::checkRedirectCache() {
     }
 }
 
+//------------------------------------------------------------------------------
+// Give up on a predicted redirection
+//------------------------------------------------------------------------------
+bool NeonRequest::cancelPrediction() {
+    if(!_predicted_redirect) {
+        return false;
+    }
+
+    DAVIX_SLOG(DAVIX_LOG_VERBOSE, DAVIX_LOG_HTTP, "Predicted redirection to {} failed, falling back to {}", _current->getString(), _orig->getString());
+
+    _predicted_redirect = false;
+    _prediction_failed = true;
+    _checking_origin = true;
+    _current = _orig;
+    return true;
+}
+
 void NeonRequest::configureHeaders() {
     // add custom user headers, but make sure they're only added once
     // in case of a redirect
@@ -302,6 +327,11 @@ int NeonRequest::negotiateRequest(DavixError** err){
         Status st = _standalone_req->startRequest();
 
         if(!st.ok()) {
+            if(cancelPrediction()) {
+                _standalone_req->doNotReuseSession();
+                return startRequest(err);
+            }
+
             _number_try++;
             if(_number_try <= auth_retry_limit) {
                 DAVIX_SLOG(DAVIX_LOG_VERBOSE, DAVIX_LOG_HTTP, "Connection problem, retry");
@@ -317,6 +347,24 @@ int NeonRequest::negotiateRequest(DavixError** err){
         }
 
         code = getRequestCode();
+
+        // the predicted server doesn't know about this file, ask the original one
+        if(code >= 400 && code < 500 && cancelPrediction()) {
+            clearAnswerContent();
+            endRequest(NULL);
+            return startRequest(err);
+        }
+
+        // the origin redirecting us again, elsewhere or not, is learnt as any
+        // redirection, and an error means it doesn't know the file either -
+        // only answering itself means this directory can't be predicted
+        if(_checking_origin) {
+            _checking_origin = false;
+            if(code >= 200 && code < 300) {
+                ContextExplorer::RedirectionResolverFromContext(_context).predictionFailed(*_orig);
+            }
+        }
+
         switch(code){
             case 202:
                 // azure will reply with 202 when deleting files :(
@@ -444,6 +492,9 @@ int NeonRequest::redirectRequest(DavixError **err) {
         return -1;
     }
 
+    // the predicted server redirected us further, it was reached fine
+    _predicted_redirect = false;
+
     // setup new path & session target
     std::shared_ptr<Uri> old_uri = _current;
     _current= std::shared_ptr<Uri>(new Uri(location));
@@ -102,6 +102,12 @@ private:
     //--------------------------------------------------------------------------
     void checkRedirectCache();
 
+    //--------------------------------------------------------------------------
+    // Give up on a predicted redirection, going back to the original URL -
+    // returns false if the redirection was not predicted
+    //--------------------------------------------------------------------------
+    bool cancelPrediction();
+
     //--------------------------------------------------------------------------
     // Prepare URI & params
     //--------------------------------------------------------------------------
@@ -127,6 +133,10 @@ private:
 
     bool _headers_configured;
     int _accepted_202_retries;
+    // sent to a predicted redirection, or gave up on predictions
+    bool _predicted_redirect, _prediction_failed;
+    // gave up on a predicted redirection, waiting for the answer of the origin
+    bool _checking_origin;
 
     ////////////////////////////////////////////
     // Private Members
@@ -37,6 +37,10 @@ NeonHandle::~NeonHandle() {
         ne_session_destroy(session);
         session = NULL;
     }
+
+    if(counters) {
+        counters->live--;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -64,8 +68,8 @@ NEONSessionFactory::~NEONSessionFactory(){
 //------------------------------------------------------------------------------
 // Create a NEONSession.
 //------------------------------------------------------------------------------
-std::unique_ptr<NEONSession> NEONSessionFactory::provideNEONSession(const Uri &uri, const RequestParams &params, DavixError **err) {
-    NeonHandlePtr internal_session = createNeonSession(params, uri, err);
+std::unique_ptr<NEONSession> NEONSessionFactory::provideNEONSession(const Uri &uri, const RequestParams &params, DavixError **err, bool fresh) {
+    NeonHandlePtr internal_session = createNeonSession(params, uri, err, fresh);
     if(!internal_session) {
       return {};
     }
@@ -73,10 +77,13 @@ std::unique_ptr<NEONSession> NEONSessionFactory::provideNEONSession(const Uri &u
     return std::unique_ptr<NEONSession>(new NEONSession(*this, std::move(internal_session), uri, params, err));
 }
 
-NeonHandlePtr NEONSessionFactory::createNeonSession(const RequestParams & params, const Uri & uri, DavixError **err){
+NeonHandlePtr NEONSessionFactory::createNeonSession(const RequestParams & params, const Uri & uri, DavixError **err, bool fresh){
     if(uri.getStatus() == StatusCode::OK){
         std::string scheme = SessionFactory::httpizeProtocol(uri.getProtocol());
         if(scheme.size() > 0){
+            if(fresh){
+                return create_session(params, scheme, uri.getHost(), httpUriGetPort(uri));
+            }
             return create_recycled_session(params, scheme, uri.getHost(), httpUriGetPort(uri));
         }
     }
@@ -114,7 +121,9 @@ NeonHandlePtr NEONSessionFactory::create_session(const RequestParams & params, c
     }
 
     //ne_ssl_trust_default_ca(se); not stable in neon on epel 5
-    return NeonHandlePtr(new NeonHandle(create_map_keys_from_URL(protocol, host, port), se));
+    NeonHandlePtr handle(new NeonHandle(create_map_keys_from_URL(protocol, host, port), se));
+    handle->counters = _session_pool.registerSession(handle->key);
+    return handle;
 }
 
 NeonHandlePtr NEONSessionFactory::create_recycled_session(const RequestParams & params, const std::string &protocol, const std::string &host, unsigned int port){
@@ -131,7 +140,7 @@ NeonHandlePtr NEONSessionFactory::create_recycled_session(const RequestParams &
 }
 
 std::string create_map_keys_from_URL(const std::string & protocol, const std::string &host, unsigned int port){
-    return SSTR(protocol << host << ":" << port);
+    return SSTR(protocol << "://" << host << ":" << port);
 }
 
 //------------------------------------------------------------------------------
@@ -150,4 +159,11 @@ bool NEONSessionFactory::getSessionCaching() const {
   return _session_caching;
 }
 
+//------------------------------------------------------------------------------
+// Add session pool statistics onto the given map
+//------------------------------------------------------------------------------
+void NEONSessionFactory::collectSessionPoolStats(std::map<std::string, SessionPoolStats> &stats) const {
+  _session_pool.collectStats(stats);
+}
+
 } // namespace Davix
@@ -39,6 +39,7 @@ struct NeonHandle {
 
     std::string key;
     ne_session *session;
+    std::shared_ptr<SessionCounters> counters;
 };
 
 typedef std::shared_ptr<NeonHandle> NeonHandlePtr;
@@ -50,9 +51,10 @@ public:
     virtual ~NEONSessionFactory();
 
     //--------------------------------------------------------------------------
-    // Create a NEONSession tied to this class.
+    // Create a NEONSession tied to this class. A fresh session never comes
+    // from the pool of idle ones.
     //--------------------------------------------------------------------------
-    std::unique_ptr<NEONSession> provideNEONSession(const Uri &uri, const RequestParams &params, DavixError **err);
+    std::unique_ptr<NEONSession> provideNEONSession(const Uri &uri, const RequestParams &params, DavixError **err, bool fresh = false);
 
     //--------------------------------------------------------------------------
     // Store a Neon session object for session reuse purposes
@@ -69,6 +71,11 @@ public:
     //--------------------------------------------------------------------------
     bool getSessionCaching() const;
 
+    //--------------------------------------------------------------------------
+    // Add session pool statistics onto the given map
+    //--------------------------------------------------------------------------
+    void collectSessionPoolStats(std::map<std::string, SessionPoolStats> &stats) const;
+
 private:
     //--------------------------------------------------------------------------
     // Neon session pool
@@ -81,7 +88,7 @@ private:
     //--------------------------------------------------------------------------
     // Create a brand new neon session object, internal use only.
     //--------------------------------------------------------------------------
-    NeonHandlePtr createNeonSession(const RequestParams & params, const Uri & uri, DavixError** err);
+    NeonHandlePtr createNeonSession(const RequestParams & params, const Uri & uri, DavixError** err, bool fresh);
 
     //--------------------------------------------------------------------------
     // Variables to control session caching
@@ -120,7 +120,19 @@ struct RequestParamsInternal{
         _copy_mode(CopyMode::Push),
         _support_100continue(true),
         _accepted_retry(180), // wait for half an hour by default
-        _accepted_delay(10)
+        _accepted_delay(10),
+        _response_buffer_limit(DAVIX_DEFAULT_RESPONSE_BUFFER_LIMIT),
+        _context_response_buffer_limit(0),
+        _response_block_size(DAVIX_DEFAULT_RESPONSE_BLOCK_SIZE),
+        _max_response_block_size(DAVIX_DEFAULT_MAX_RESPONSE_BLOCK_SIZE),
+        _http2_support(false),
+        _merge_window(-1),
+        _transfer_streams(1),
+        _upload_chunk_size(0),
+        _upload_streams(DAVIX_DEFAULT_UPLOAD_STREAMS),
+        _upload_buffer_limit(DAVIX_DEFAULT_UPLOAD_BUFFER_LIMIT),
+        _upload_threshold(DAVIX_DEFAULT_UPLOAD_THRESHOLD),
+        _redirection_prediction(false)
     {
         timespec_clear(&connexion_timeout);
         timespec_clear(&ops_timeout);
@@ -172,7 +184,19 @@ struct RequestParamsInternal{
         _copy_mode(param_private._copy_mode),
         _support_100continue(param_private._support_100continue),
         _accepted_retry(param_private._accepted_retry),
-        _accepted_delay(param_private._accepted_delay) {
+        _accepted_delay(param_private._accepted_delay),
+        _response_buffer_limit(param_private._response_buffer_limit),
+        _context_response_buffer_limit(param_private._context_response_buffer_limit),
+        _response_block_size(param_private._response_block_size),
+        _max_response_block_size(param_private._max_response_block_size),
+        _http2_support(param_private._http2_support),
+        _merge_window(param_private._merge_window),
+        _transfer_streams(param_private._transfer_streams),
+        _upload_chunk_size(param_private._upload_chunk_size),
+        _upload_streams(param_private._upload_streams),
+        _upload_buffer_limit(param_private._upload_buffer_limit),
+        _upload_threshold(param_private._upload_threshold),
+        _redirection_prediction(param_private._redirection_prediction) {
 
         timespec_copy(&(connexion_timeout), &(param_private.connexion_timeout));
         timespec_copy(&(ops_timeout), &(param_private.ops_timeout));
@@ -253,6 +277,31 @@ struct RequestParamsInternal{
     // delay in seconds between retries in case davix receives 202-Accepted
     int _accepted_delay;
 
+    // response body bytes buffered ahead of the reader, per request / per context
+    dav_size_t _response_buffer_limit;
+    dav_size_t _context_response_buffer_limit;
+    // size of the first and of the largest block buffering a response body
+    dav_size_t _response_block_size;
+    dav_size_t _max_response_block_size;
+    bool _http2_support;
+
+    // merge window of vectored reads, negative for automatic
+    dav_ssize_t _merge_window;
+
+    // concurrent range requests of a download to a file descriptor
+    unsigned int _transfer_streams;
+
+    // chunked uploads: chunk size (0 for the protocol default), concurrent
+    // chunks, and memory used for them
+    dav_size_t _upload_chunk_size;
+    unsigned int _upload_streams;
+    dav_size_t _upload_buffer_limit;
+    // smallest S3 / Swift upload split into chunks
+    dav_size_t _upload_threshold;
+
+    // send requests straight to the server redirections are predicted to go to
+    bool _redirection_prediction;
+
     // method
     inline void regenerateStateUid(){
         _state_uid = get_requeste_uid();
@@ -501,6 +550,14 @@ bool RequestParams::getTransparentRedirectionSupport() const{
     return d_ptr->_redirection;
 }
 
+void RequestParams::setRedirectionPrediction(bool prediction){
+    d_ptr->_redirection_prediction = prediction;
+}
+
+bool RequestParams::getRedirectionPrediction() const{
+    return d_ptr->_redirection_prediction;
+}
+
 void RequestParams::setOperationRetry(int number_retry){
     d_ptr->retry_number = number_retry;
 }
@@ -625,6 +682,91 @@ void RequestParams::setAcceptedRetryDelay(int delay) {
   d_ptr->_accepted_delay = delay;
 }
 
+void RequestParams::setResponseBufferLimit(dav_size_t bytes) {
+  d_ptr->_response_buffer_limit = bytes;
+}
+
+dav_size_t RequestParams::getResponseBufferLimit() const {
+  return d_ptr->_response_buffer_limit;
+}
+
+void RequestParams::setContextResponseBufferLimit(dav_size_t bytes) {
+  d_ptr->_context_response_buffer_limit = bytes;
+}
+
+dav_size_t RequestParams::getContextResponseBufferLimit() const {
+  return d_ptr->_context_response_buffer_limit;
+}
+
+void RequestParams::setResponseBlockSize(dav_size_t initial, dav_size_t max) {
+  d_ptr->_response_block_size = std::max<dav_size_t>(initial, 1024);
+  d_ptr->_max_response_block_size = std::max(max, d_ptr->_response_block_size);
+}
+
+dav_size_t RequestParams::getResponseBlockSize() const {
+  return d_ptr->_response_block_size;
+}
+
+dav_size_t RequestParams::getMaxResponseBlockSize() const {
+  return d_ptr->_max_response_block_size;
+}
+
+void RequestParams::setHttp2Support(bool enabled) {
+  d_ptr->_http2_support = enabled;
+}
+
+bool RequestParams::getHttp2Support() const {
+  return d_ptr->_http2_support;
+}
+
+void RequestParams::setMergeWindow(dav_ssize_t bytes) {
+  d_ptr->_merge_window = bytes;
+}
+
+dav_ssize_t RequestParams::getMergeWindow() const {
+  return d_ptr->_merge_window;
+}
+
+void RequestParams::setTransferStreams(unsigned int streams) {
+  d_ptr->_transfer_streams = std::max(streams, 1u);
+}
+
+unsigned int RequestParams::getTransferStreams() const {
+  return d_ptr->_transfer_streams;
+}
+
+void RequestParams::setUploadChunkSize(dav_size_t bytes) {
+  d_ptr->_upload_chunk_size = bytes;
+}
+
+dav_size_t RequestParams::getUploadChunkSize() const {
+  return d_ptr->_upload_chunk_size;
+}
+
+void RequestParams::setUploadStreams(unsigned int streams) {
+  d_ptr->_upload_streams = std::max(streams, 1u);
+}
+
+unsigned int RequestParams::getUploadStreams() const {
+  return d_ptr->_upload_streams;
+}
+
+void RequestParams::setUploadBufferLimit(dav_size_t bytes) {
+  d_ptr->_upload_buffer_limit = bytes;
+}
+
+dav_size_t RequestParams::getUploadBufferLimit() const {
+  return d_ptr->_upload_buffer_limit;
+}
+
+void RequestParams::setUploadThreshold(dav_size_t bytes) {
+  d_ptr->_upload_threshold = bytes;
+}
+
+dav_size_t RequestParams::getUploadThreshold() const {
+  return d_ptr->_upload_threshold;
+}
+
 // suppress useless warning
 #pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
 void* RequestParams::getParmState() const{
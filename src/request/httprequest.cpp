@@ -24,6 +24,7 @@
 #include <neon/neonrequest.hpp>
 #include <davix_context_internal.hpp>
 #include <request/httprequest.hpp>
+#include <core/WorkerPool.hpp>
 
 namespace Davix {
 
@@ -148,6 +149,28 @@ int HttpRequest::executeRequest(DavixError **err){
     return -1;
 }
 
+std::future<int> HttpRequest::executeAsync(){
+    WorkerPool & pool = ContextExplorer::WorkerPoolFromContext(d_ptr->get()->getContext());
+
+    return pool.async<int>([this]() {
+        DavixError* tmp_err = NULL;
+        int ret = executeRequest(&tmp_err);
+        checkDavixError(&tmp_err);
+        return ret;
+    });
+}
+
+void HttpRequest::executeAsync(const AsyncCompletionCallback & callback){
+    WorkerPool & pool = ContextExplorer::WorkerPoolFromContext(d_ptr->get()->getContext());
+
+    pool.async([this]() {
+        DavixError* tmp_err = NULL;
+        dav_ssize_t ret = executeRequest(&tmp_err);
+        checkDavixError(&tmp_err);
+        return ret;
+    }, callback);
+}
+
 int HttpRequest::beginRequest(DavixError **err){
     TRY_DAVIX{
         // triggers Hooks
@@ -67,6 +67,7 @@ const std::string scope_params = "Davix::Tools::Params";
 #define OS_PROJECT_ID          1029
 #define SWIFT_LISTING_MODE     1030
 #define SWIFT_ACCOUNT          1031
+#define TRANSFER_STREAMS       1032
 
 // LONG OPTS
 
@@ -118,7 +119,8 @@ const std::string scope_params = "Davix::Tools::Params";
 
 #define GET_LONG_OPTIONS \
 {"accepted-retry", required_argument, 0, ACCEPTED_RETRY}, \
-{"accepted-retry-delay", required_argument, 0, ACCEPTED_RETRY_DELAY}
+{"accepted-retry-delay", required_argument, 0, ACCEPTED_RETRY_DELAY}, \
+{"streams", required_argument, 0, TRANSFER_STREAMS}
 
 #define PUT_LONG_OPTIONS \
 {"no-100-continue", no_argument, 0,  NO_100_CONTINUE }
@@ -427,6 +429,9 @@ int parse_davix_options_generic(const std::string &opt_filter,
             case ACCEPTED_RETRY_DELAY:
                 p.params.setAcceptedRetryDelay(atoi(optarg));
                 break;
+            case TRANSFER_STREAMS:
+                p.params.setTransferStreams(std::max(atoi(optarg), 1));
+                break;
             case '?':
                 std::cout <<  p.help_msg;
                 exit(1);
@@ -5,6 +5,7 @@
 #include <sys/time.h>
 #include <stdio.h>
 #include <vector>
+#include <map>
 #include <sstream>
 #include <pthread.h>
 #include "chunk_queue.h"
@@ -26,6 +27,8 @@ struct Options
     bool debug;
     bool silent;
     bool hasinputfile;
+    bool http2;
+    long merge_window;
     std::vector<std::string> vec_arg;
     std::string inputfile;
 
@@ -38,6 +41,8 @@ struct Options
         debug(false),
         silent(false),
         hasinputfile(false),
+        http2(false),
+        merge_window(-1),
         vec_arg(),
         inputfile()
     {
@@ -127,7 +132,7 @@ int main(int argc, char* argv[])
                 {
                     cout << "Opening - " << opts.vec_arg[0] << " --------------------- ";
 
-                    if((fd = infile->open(NULL, opts.vec_arg[0], O_RDONLY, &tmp_err)) != NULL)
+                    if((fd = infile->open(&opts.params, opts.vec_arg[0], O_RDONLY, &tmp_err)) != NULL)
                     {
                         cout << "success" << endl;
                         davfd_vec.push_back(fd);
@@ -182,7 +187,7 @@ int main(int argc, char* argv[])
                         {
                             cout << "Opening - " << filepath << " --------------------- ";
 
-                            if((fd = infile->open(NULL, filepath, O_RDONLY, &tmp_err)) != NULL)
+                            if((fd = infile->open(&opts.params, filepath, O_RDONLY, &tmp_err)) != NULL)
                             {
                                 cout << "Success" << endl;
                                 davfd_vec.push_back(fd);
@@ -595,8 +600,27 @@ int main(int argc, char* argv[])
         switch(opts.mode)
         {
             case 'v':
-                cout << summarypref << " Vector size: " << opts.vec_size << endl;
-                break;
+                {
+                    cout << summarypref << " Vector size: " << opts.vec_size << endl;
+                    if(opts.merge_window >= 0)
+                        cout << summarypref << " Merge window: " << opts.merge_window << endl;
+                    else
+                        cout << summarypref << " Merge window: automatic" << endl;
+
+                    std::map<std::string, LinkStats> linkstats = context.getLinkStats();
+                    for(std::map<std::string, LinkStats>::iterator it = linkstats.begin(); it != linkstats.end(); ++it)
+                    {
+                        cout << summarypref << " Link to " << it->first << ": latency " << it->second.latency <<
+                            "us, bandwidth " << it->second.bandwidth << " bytes/s, automatic merge window " <<
+                            it->second.merge_window << endl;
+                        cout << summarypref << " Vectored reads to " << it->first << ": ranges " << it->second.ranges_requested <<
+                            ", requested after merging " << it->second.ranges_issued << ", requests saved " <<
+                            it->second.ranges_requested - it->second.ranges_issued << endl;
+                        cout << summarypref << " Vectored reads to " << it->first << ": bytes " << it->second.bytes_requested <<
+                            ", wasted in merged gaps " << it->second.bytes_wasted << endl;
+                    }
+                    break;
+                }
 
             case 't':
                 cout << summarypref << " Number of thread(s): " << opts.no_of_thread << endl;
@@ -604,6 +628,14 @@ int main(int argc, char* argv[])
         }
     }
     cout << summarypref << " Opened file count: " << file_count << endl;
+    cout << summarypref << " HTTP version: " << (opts.http2 ? "2" : "1.1") << endl;
+
+    std::map<std::string, SessionPoolStats> poolstats = context.getSessionPoolStats();
+    for(std::map<std::string, SessionPoolStats>::iterator it = poolstats.begin(); it != poolstats.end(); ++it)
+    {
+        cout << summarypref << " Sessions to " << it->first << ": created " << it->second.created <<
+            ", reused " << it->second.reused << ", multiplexed requests " << it->second.multiplexed << endl;
+    }
     cout << endl;
 
     // print out any unique ocurrence of DavixError
@@ -719,7 +751,7 @@ int ReadSome(long *offs, long *lens, int maxnread, long long &totalbytes, bool &
 
 int ParseOptions(int argc, char* argv[], Options & p)
 {
-    const std::string arg_tool_main= "srwdchv:t:i:";
+    const std::string arg_tool_main= "srwdch2v:t:i:m:";
 
     int ret = 0;
 
@@ -783,6 +815,16 @@ int ParseOptions(int argc, char* argv[], Options & p)
                 p.inputfile = optarg;
                 break;
 
+            case '2':
+                p.http2 = true;
+                p.params.setHttp2Support(true);
+                break;
+
+            case 'm':
+                p.merge_window = atol(optarg);
+                p.params.setMergeWindow(p.merge_window);
+                break;
+
             default:
                 PrintUsage();
                 exit(-1);
@@ -898,5 +940,9 @@ void PrintUsage()
         "    -s          Silent mode." << endl <<
         "    -w          Write mode, create file which is compatible with the -c option." << endl <<
         "    -i<file>    Read input from file instead of standard input." << endl <<
+        "    -2          Use HTTP/2, multiplexing concurrent requests over one connection (libcurl backend only)." << endl <<
+        "                Run the same input with and without -2 to compare against HTTP/1.1." << endl <<
+        "    -m<bytes>   Merge window of vectored reads, automatic by default." << endl <<
+        "                Compare requests saved against bytes wasted in the summary." << endl <<
         "    -c          Verify if the value of the byte at offset i is i%256. Valid only for the non-vectored(r) read mode." << endl << endl;
 }
@@ -0,0 +1,80 @@
+#include <davix.hpp>
+#include <fileops/MultipartParser.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace Davix;
+
+// Parse an in-memory multipart/byteranges response of <parts> parts of
+// <part size> bytes, fed in <block size> blocks, scattering the payloads
+// into per-part destination buffers - reports the parsing throughput.
+int main(int argc, char* argv[])
+{
+    const dav_size_t nparts = (argc > 1) ? atol(argv[1]) : 10000;
+    const dav_size_t part_size = (argc > 2) ? atol(argv[2]) : 4096;
+    const dav_size_t block_size = (argc > 3) ? atol(argv[3]) : 262144;
+    const int iterations = (argc > 4) ? atoi(argv[4]) : 20;
+
+    if(nparts == 0 || part_size == 0 || block_size == 0 || iterations <= 0)
+    {
+        std::cerr << "Usage: davix-multipart-bench [parts] [part size] [block size] [iterations]" << std::endl;
+        return 1;
+    }
+
+    const std::string boundary = "3d6b6a416f9b5";
+    const dav_size_t stride = 2 * part_size;
+
+    std::string body;
+    body.reserve(nparts * (part_size + 128));
+    std::string payload(part_size, 'x');
+    for(dav_size_t i = 0; i < nparts; i++)
+    {
+        std::ostringstream ss;
+        ss << "\r\n--" << boundary << "\r\n" <<
+            "Content-Type: application/octet-stream\r\n" <<
+            "Content-Range: bytes " << i * stride << "-" << i * stride + part_size - 1 << "/" << nparts * stride << "\r\n\r\n";
+        body += ss.str();
+        body += payload;
+    }
+    body += "\r\n--" + boundary + "--\r\n";
+
+    std::vector<char> destination(nparts * part_size);
+    double best = 0;
+
+    for(int it = 0; it < iterations; it++)
+    {
+        DavixError* err = NULL;
+        MultipartParser parser(boundary, [&](dav_off_t offset, const char* data, dav_size_t size) {
+            const dav_size_t part = offset / stride;
+            memcpy(&destination[part * part_size + offset % stride], data, size);
+        });
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(dav_size_t pos = 0; pos < body.size() && !parser.done(); pos += block_size)
+        {
+            if(parser.feed(body.data() + pos, std::min(block_size, body.size() - pos), &err) < 0)
+            {
+                std::cerr << "Parsing failed: " << err->getErrMsg() << std::endl;
+                return 1;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if(!parser.done() || parser.payloadBytes() != nparts * part_size)
+        {
+            std::cerr << "Parsing incomplete" << std::endl;
+            return 1;
+        }
+
+        best = std::max(best, body.size() / elapsed.count());
+    }
+
+    std::cout << "Parts: " << nparts << ", part size: " << part_size << ", block size: " << block_size <<
+        ", response size: " << body.size() << std::endl;
+    std::cout << "Best throughput over " << iterations << " iterations: " << best / 1e9 << " GB/s" << std::endl;
+    return 0;
+}
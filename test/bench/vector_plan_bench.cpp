@@ -0,0 +1,127 @@
+#include <davix.hpp>
+#include <fileops/httpiovec.hpp>
+#include "libs/IntervalTree.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace Davix;
+
+// Time the planning phase of vectored reads - indexing the requested chunks
+// and merging them into ranges - then the lookup of the chunks matching each
+// range, as done when scattering the response, for growing vector sizes.
+// The interval tree based implementation used before is timed alongside,
+// for reference.
+
+typedef std::chrono::duration<double, std::milli> Millis;
+
+struct Timings {
+    Timings() : plan(0), lookup(0) {}
+    double plan;
+    double lookup;
+};
+
+static void planFlat(const std::vector<DavIOVecInput> & in, std::vector<DavIOVecOuput> & out, dav_size_t & matches, Timings & t) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    ChunkIndex chunks(&in[0], &out[0], in.size());
+    dav_size_t gap_bytes = 0;
+    SortedRanges ranges = partialMerging(chunks, 2000, gap_bytes);
+
+    std::chrono::steady_clock::time_point planned = std::chrono::steady_clock::now();
+
+    matches = 0;
+    for(dav_size_t i = 0; i < ranges.size(); i++) {
+        matches += chunks.forEachOverlapping(ranges[i].first, ranges[i].second, [](const ElemChunk &) {});
+    }
+
+    t.plan += Millis(planned - start).count();
+    t.lookup += Millis(std::chrono::steady_clock::now() - planned).count();
+}
+
+static void planTree(const std::vector<DavIOVecInput> & in, std::vector<DavIOVecOuput> & out, dav_size_t & matches, Timings & t) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<Interval<ElemChunk> > intervals;
+    for(dav_size_t i = 0; i < in.size(); i++) {
+        intervals.push_back(Interval<ElemChunk>(in[i].diov_offset, in[i].diov_offset + in[i].diov_size - 1, ElemChunk(&in[i], &out[i])));
+    }
+    IntervalTree<ElemChunk> tree(intervals);
+
+    std::vector<Interval<ElemChunk> > all;
+    tree.findContained(0, std::numeric_limits<dav_size_t>::max(), all);
+    std::multimap<dav_off_t, dav_size_t> sorted;
+    for(dav_size_t i = 0; i < all.size(); i++) {
+        sorted.insert(std::make_pair(all[i].start, all[i].stop));
+    }
+
+    SortedRanges ranges;
+    dav_off_t offset = sorted.begin()->first, end = sorted.begin()->second;
+    for(std::multimap<dav_off_t, dav_size_t>::iterator it = sorted.begin(); it != sorted.end(); it++) {
+        if(end + 2000 >= it->first) {
+            end = std::max<dav_off_t>(end, it->second);
+        }
+        else {
+            ranges.push_back(std::make_pair(offset, end));
+            offset = it->first;
+            end = it->second;
+        }
+    }
+    ranges.push_back(std::make_pair(offset, end));
+
+    std::chrono::steady_clock::time_point planned = std::chrono::steady_clock::now();
+
+    matches = 0;
+    for(dav_size_t i = 0; i < ranges.size(); i++) {
+        std::vector<Interval<ElemChunk> > found;
+        tree.findOverlapping(ranges[i].first, ranges[i].second, found);
+        matches += found.size();
+    }
+
+    t.plan += Millis(planned - start).count();
+    t.lookup += Millis(std::chrono::steady_clock::now() - planned).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const int iterations = (argc > 1) ? atoi(argv[1]) : 10;
+    const dav_size_t sizes[] = { 100, 1000, 10000, 50000, 100000 };
+    char buffer[4096];
+
+    srand(42);
+    std::cout << "vector size, planning (ms), lookups (ms), interval tree planning (ms), interval tree lookups (ms)" << std::endl;
+
+    for(dav_size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        std::vector<DavIOVecInput> in(sizes[s]);
+        std::vector<DavIOVecOuput> out(sizes[s]);
+
+        // ROOT-like access pattern: sorted, mostly small chunks with gaps
+        dav_off_t offset = 0;
+        for(dav_size_t i = 0; i < in.size(); i++) {
+            offset += rand() % 8192;
+            in[i].diov_buffer = buffer;
+            in[i].diov_offset = offset;
+            in[i].diov_size = 1 + rand() % sizeof(buffer);
+            offset += in[i].diov_size;
+        }
+
+        Timings flat, tree;
+        dav_size_t flatMatches = 0, treeMatches = 0;
+        for(int it = 0; it < iterations; it++) {
+            planFlat(in, out, flatMatches, flat);
+            planTree(in, out, treeMatches, tree);
+        }
+
+        if(flatMatches != treeMatches) {
+            std::cerr << "Mismatch: " << flatMatches << " vs " << treeMatches << " chunks" << std::endl;
+            return 1;
+        }
+
+        std::cout << sizes[s] << ", " << flat.plan / iterations << ", " << flat.lookup / iterations << ", " <<
+            tree.plan / iterations << ", " << tree.lookup / iterations << std::endl;
+    }
+
+    return 0;
+}
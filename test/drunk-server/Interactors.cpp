@@ -22,6 +22,9 @@
 #include "Interactors.hpp"
 #include "LineReader.hpp"
 #include <iostream>
+#include <strings.h>
+#include <functional>
+#include <sstream>
 
 //------------------------------------------------------------------------------
 // Destructor
@@ -109,3 +112,267 @@ void SingleShotInteractor::main(ThreadAssistant &assistant) {
   std::cout << "Response written successfully" << std::endl;
   _is_ok = true;
 }
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RecordingInteractor::RecordingInteractor(RequestLog &log, const std::string &response)
+: _log(log), _response(response) {}
+
+//------------------------------------------------------------------------------
+// Run interacting thread
+//------------------------------------------------------------------------------
+void RecordingInteractor::main(ThreadAssistant &assistant) {
+  while(!assistant.terminationRequested()) {
+    RequestLog::Entry entry;
+    entry.requestLine = consumeLine();
+    if(entry.requestLine.empty()) {
+      return; // connection closed
+    }
+
+    size_t contentLength = 0;
+    bool expectContinue = false;
+
+    while(true) {
+      std::string line = consumeLine();
+      if(line.empty()) {
+        return;
+      }
+
+      if(line == "\r\n") {
+        break;
+      }
+
+      if(strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+        contentLength = std::stoul(line.substr(15));
+      }
+      else if(strncasecmp(line.c_str(), "Expect: 100-continue", 20) == 0) {
+        expectContinue = true;
+      }
+    }
+
+    if(expectContinue) {
+      _conn->write(std::string("HTTP/1.1 100 Continue\r\n\r\n"));
+    }
+
+    while(entry.body.size() < contentLength) {
+      char buff[4096];
+      ssize_t ret = _conn->read(buff, std::min(sizeof(buff), contentLength - entry.body.size()));
+      if(ret <= 0) {
+        return;
+      }
+
+      entry.body.append(buff, ret);
+    }
+
+    _log.add(entry);
+
+    if(_conn->write(_response) != (ssize_t) _response.size()) {
+      std::cout << "Error when writing response" << std::endl;
+      return;
+    }
+
+    _is_ok = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Build the response to the given request line and Range header value
+//------------------------------------------------------------------------------
+std::string ServedFile::respond(const std::string &requestLine, const std::string &range) const {
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  std::ostringstream headers;
+  headers << "Last-Modified: " << _last_modified << "\r\n"
+          << "ETag: \"" << std::hash<std::string>()(_content + _last_modified) << "\"\r\n";
+
+  if(requestLine.compare(0, 5, "HEAD ") == 0) {
+    if(!_head) {
+      return "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\n\r\n";
+    }
+
+    return "HTTP/1.1 200 OK\r\n" + headers.str() + "Accept-Ranges: bytes\r\n" +
+      "Content-Length: " + std::to_string(_content.size()) + "\r\n\r\n";
+  }
+
+  if(!_ranges || range.compare(0, 6, "bytes=") != 0) {
+    return "HTTP/1.1 200 OK\r\n" + headers.str() +
+      "Content-Length: " + std::to_string(_content.size()) + "\r\n\r\n" + _content;
+  }
+
+  //----------------------------------------------------------------------------
+  // Parse "bytes=a-b,c-,..." - ranges past the end of the file are dropped
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<size_t, size_t> > ranges;
+  for(const std::string &spec : split(range.substr(6), ",")) {
+    const size_t dash = spec.find('-');
+    if(dash == std::string::npos || dash == 0) {
+      continue;
+    }
+
+    const size_t start = std::stoull(spec.substr(0, dash));
+    size_t end = _content.size() - 1;
+    if(dash + 1 < spec.size()) {
+      end = std::min<size_t>(end, std::stoull(spec.substr(dash + 1)));
+    }
+
+    if(start < _content.size() && start <= end) {
+      ranges.emplace_back(start, end);
+    }
+  }
+
+  if(ranges.empty()) {
+    return "HTTP/1.1 416 Range Not Satisfiable\r\n" + headers.str() +
+      "Content-Range: bytes */" + std::to_string(_content.size()) + "\r\nContent-Length: 0\r\n\r\n";
+  }
+
+  if(_fail_from >= 0 && ranges[0].first >= (size_t) _fail_from) {
+    return "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n";
+  }
+
+  if(ranges.size() > 1 && _whole_from >= 0 && ranges[0].first >= (size_t) _whole_from) {
+    return "HTTP/1.1 200 OK\r\n" + headers.str() +
+      "Content-Length: " + std::to_string(_content.size()) + "\r\n\r\n" + _content;
+  }
+
+  if(ranges.size() == 1) {
+    const size_t start = ranges[0].first, end = ranges[0].second;
+    return "HTTP/1.1 206 Partial Content\r\n" + headers.str() +
+      "Content-Range: bytes " + std::to_string(start) + "-" + std::to_string(end) + "/" + std::to_string(_content.size()) + "\r\n" +
+      "Content-Length: " + std::to_string(end - start + 1) + "\r\n\r\n" + _content.substr(start, end - start + 1);
+  }
+
+  std::string body;
+  for(const std::pair<size_t, size_t> &r : ranges) {
+    body += "\r\n--drunkboundary\r\nContent-Type: application/octet-stream\r\n";
+    body += "Content-Range: bytes " + std::to_string(r.first) + "-" + std::to_string(r.second) + "/" + std::to_string(_content.size()) + "\r\n\r\n";
+    body += _content.substr(r.first, r.second - r.first + 1);
+  }
+  body += "\r\n--drunkboundary--\r\n";
+
+  return "HTTP/1.1 206 Partial Content\r\n" + headers.str() +
+    "Content-Type: multipart/byteranges; boundary=drunkboundary\r\n" +
+    "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FileInteractor::FileInteractor(RequestLog &log, const ServedFile &file)
+: _log(log), _file(file) {}
+
+//------------------------------------------------------------------------------
+// Run interacting thread
+//------------------------------------------------------------------------------
+void FileInteractor::main(ThreadAssistant &assistant) {
+  while(!assistant.terminationRequested()) {
+    RequestLog::Entry entry;
+    entry.requestLine = consumeLine();
+    if(entry.requestLine.empty()) {
+      return; // connection closed
+    }
+
+    size_t contentLength = 0;
+
+    while(true) {
+      std::string line = consumeLine();
+      if(line.empty()) {
+        return;
+      }
+
+      if(line == "\r\n") {
+        break;
+      }
+
+      if(strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+        contentLength = std::stoul(line.substr(15));
+      }
+      else if(strncasecmp(line.c_str(), "Range:", 6) == 0) {
+        const size_t begin = line.find_first_not_of(' ', 6);
+        entry.range = line.substr(begin, line.find_last_not_of("\r\n") + 1 - begin);
+      }
+    }
+
+    while(entry.body.size() < contentLength) {
+      char buff[4096];
+      ssize_t ret = _conn->read(buff, std::min(sizeof(buff), contentLength - entry.body.size()));
+      if(ret <= 0) {
+        return;
+      }
+
+      entry.body.append(buff, ret);
+    }
+
+    _log.add(entry);
+
+    const std::string response = _file.respond(entry.requestLine, entry.range);
+    if(_conn->write(response) != (ssize_t) response.size()) {
+      return;
+    }
+
+    _is_ok = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RoutingInteractor::RoutingInteractor(RequestLog &log, const Router &router)
+: _log(log), _router(router) {}
+
+//------------------------------------------------------------------------------
+// Run interacting thread
+//------------------------------------------------------------------------------
+void RoutingInteractor::main(ThreadAssistant &assistant) {
+  while(!assistant.terminationRequested()) {
+    RequestLog::Entry entry;
+    entry.requestLine = consumeLine();
+    if(entry.requestLine.empty()) {
+      return; // connection closed
+    }
+
+    size_t contentLength = 0;
+
+    while(true) {
+      std::string line = consumeLine();
+      if(line.empty()) {
+        return;
+      }
+
+      if(line == "\r\n") {
+        break;
+      }
+
+      if(strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+        contentLength = std::stoul(line.substr(15));
+      }
+      else if(strncasecmp(line.c_str(), "Range:", 6) == 0) {
+        const size_t begin = line.find_first_not_of(' ', 6);
+        entry.range = line.substr(begin, line.find_last_not_of("\r\n") + 1 - begin);
+      }
+      else if(strncasecmp(line.c_str(), "Host:", 5) == 0) {
+        const size_t begin = line.find_first_not_of(' ', 5);
+        entry.host = line.substr(begin, line.find_last_not_of("\r\n") + 1 - begin);
+      }
+    }
+
+    while(entry.body.size() < contentLength) {
+      char buff[4096];
+      ssize_t ret = _conn->read(buff, std::min(sizeof(buff), contentLength - entry.body.size()));
+      if(ret <= 0) {
+        return;
+      }
+
+      entry.body.append(buff, ret);
+    }
+
+    _log.add(entry);
+
+    const std::string response = _router(entry);
+    if(_conn->write(response) != (ssize_t) response.size()) {
+      return;
+    }
+
+    _is_ok = true;
+  }
+}
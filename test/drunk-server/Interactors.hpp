@@ -24,6 +24,7 @@
 
 #include "AssistedThread.hh"
 #include "DrunkServer.hpp"
+#include <functional>
 
 class LineReader;
 
@@ -93,4 +94,176 @@ protected:
   std::string _response;
 };
 
+//------------------------------------------------------------------------------
+// Requests received by RecordingInteractors - shared among connections
+//------------------------------------------------------------------------------
+class RequestLog {
+public:
+  struct Entry {
+    std::string requestLine;
+    // value of the Range header, empty if none
+    std::string range;
+    std::string body;
+    // value of the Host header, only recorded by RoutingInteractors
+    std::string host;
+  };
+
+  //----------------------------------------------------------------------------
+  // Record a request
+  //----------------------------------------------------------------------------
+  void add(const Entry &entry) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _entries.emplace_back(entry);
+  }
+
+  //----------------------------------------------------------------------------
+  // Requests received so far, in arrival order
+  //----------------------------------------------------------------------------
+  std::vector<Entry> entries() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _entries;
+  }
+
+private:
+  mutable std::mutex _mtx;
+  std::vector<Entry> _entries;
+};
+
+//------------------------------------------------------------------------------
+// Recording interactor - serves any number of requests on a keep-alive
+// connection, giving the same response to all, and records them
+//------------------------------------------------------------------------------
+class RecordingInteractor : public BasicInteractor {
+public:
+  //----------------------------------------------------------------------------
+  // Constructor
+  //----------------------------------------------------------------------------
+  RecordingInteractor(RequestLog &log, const std::string &response);
+
+  //----------------------------------------------------------------------------
+  // Run interacting thread
+  //----------------------------------------------------------------------------
+  void main(ThreadAssistant &assistant);
+
+protected:
+  RequestLog &_log;
+  std::string _response;
+};
+
+//------------------------------------------------------------------------------
+// File served by FileInteractors - shared among connections, and may be
+// changed between requests
+//------------------------------------------------------------------------------
+class ServedFile {
+public:
+  //----------------------------------------------------------------------------
+  // Constructor
+  //----------------------------------------------------------------------------
+  ServedFile(const std::string &content, const std::string &lastModified = "Mon, 01 Jul 2019 10:00:00 GMT")
+  : _content(content), _last_modified(lastModified), _ranges(true), _head(true), _fail_from(-1), _whole_from(-1) {}
+
+  //----------------------------------------------------------------------------
+  // Replace the contents and modification time
+  //----------------------------------------------------------------------------
+  void update(const std::string &content, const std::string &lastModified) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _content = content;
+    _last_modified = lastModified;
+  }
+
+  //----------------------------------------------------------------------------
+  // Honour Range headers, or answer every GET with the whole file
+  //----------------------------------------------------------------------------
+  void setRangeSupport(bool ranges) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _ranges = ranges;
+  }
+
+  //----------------------------------------------------------------------------
+  // Answer HEAD requests, or refuse them with a 405
+  //----------------------------------------------------------------------------
+  void setHeadSupport(bool head) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _head = head;
+  }
+
+  //----------------------------------------------------------------------------
+  // Answer range requests starting at or after the given offset with a 500,
+  // -1 for never
+  //----------------------------------------------------------------------------
+  void failRangesFrom(long long offset) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _fail_from = offset;
+  }
+
+  //----------------------------------------------------------------------------
+  // Answer multi-range requests whose first range starts at or after the
+  // given offset with the whole file, -1 for never
+  //----------------------------------------------------------------------------
+  void ignoreMultirangeFrom(long long offset) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _whole_from = offset;
+  }
+
+  //----------------------------------------------------------------------------
+  // Build the response to the given request line and Range header value
+  //----------------------------------------------------------------------------
+  std::string respond(const std::string &requestLine, const std::string &range) const;
+
+private:
+  mutable std::mutex _mtx;
+  std::string _content;
+  std::string _last_modified;
+  bool _ranges;
+  bool _head;
+  long long _fail_from;
+  long long _whole_from;
+};
+
+//------------------------------------------------------------------------------
+// File interactor - serves HEAD and GET requests for a ServedFile on a
+// keep-alive connection, with single and multiple byte ranges, and records
+// the requests
+//------------------------------------------------------------------------------
+class FileInteractor : public BasicInteractor {
+public:
+  //----------------------------------------------------------------------------
+  // Constructor
+  //----------------------------------------------------------------------------
+  FileInteractor(RequestLog &log, const ServedFile &file);
+
+  //----------------------------------------------------------------------------
+  // Run interacting thread
+  //----------------------------------------------------------------------------
+  void main(ThreadAssistant &assistant);
+
+protected:
+  RequestLog &_log;
+  const ServedFile &_file;
+};
+
+//------------------------------------------------------------------------------
+// Routing interactor - serves any number of requests on a keep-alive
+// connection, answering each of them with the response given by a function of
+// the request, and records them
+//------------------------------------------------------------------------------
+class RoutingInteractor : public BasicInteractor {
+public:
+  typedef std::function<std::string(const RequestLog::Entry &entry)> Router;
+
+  //----------------------------------------------------------------------------
+  // Constructor
+  //----------------------------------------------------------------------------
+  RoutingInteractor(RequestLog &log, const Router &router);
+
+  //----------------------------------------------------------------------------
+  // Run interacting thread
+  //----------------------------------------------------------------------------
+  void main(ThreadAssistant &assistant);
+
+protected:
+  RequestLog &_log;
+  Router _router;
+};
+
 #endif
@@ -0,0 +1,104 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+
+using namespace Davix;
+
+class AzureIOTest : public DavixTestFixture {};
+
+//------------------------------------------------------------------------------
+// Value of the given query parameter of a request line
+//------------------------------------------------------------------------------
+static std::string getQueryParam(const std::string &requestLine, const std::string &key) {
+  Uri uri("http://localhost" + requestLine.substr(requestLine.find(' ') + 1, requestLine.rfind(' ') - requestLine.find(' ') - 1));
+
+  ParamVec params = uri.getQueryVec();
+  for(size_t i = 0; i < params.size(); i++) {
+    if(params[i].first == key) {
+      return Uri::unescapeString(params[i].second);
+    }
+  }
+
+  return "";
+}
+
+TEST_F(AzureIOTest, ConcurrentBlockUpload) {
+  RequestLog log;
+  std::vector<std::unique_ptr<RecordingInteractor> > interactors;
+
+  // PUT connections are not reused: one per request
+  for(size_t i = 0; i < 12; i++) {
+    interactors.emplace_back(new RecordingInteractor(log, "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n"));
+    _drunk_server->autoAcceptNext(interactors.back().get());
+  }
+
+  std::string content;
+  for(size_t i = 0; i < 10500; i++) {
+    content.push_back('a' + (i * 7) % 26);
+  }
+
+  {
+    Context context;
+    RequestParams params;
+    params.setOperationRetry(0);
+    params.setUploadChunkSize(1000);
+    params.setUploadStreams(3);
+
+    // a SAS-signed URL is detected as Azure
+    DavFile file(context, params, Uri("http://localhost:22222/container/blob?sig=abc&sr=b&sp=rw"));
+    file.put(&params, content.c_str(), content.size());
+  }
+
+  std::vector<RequestLog::Entry> requests = log.entries();
+  ASSERT_EQ(requests.size(), 12u);
+
+  // blocks may arrive in any order
+  std::map<std::string, std::string> blocks;
+  for(size_t i = 0; i < 11; i++) {
+    ASSERT_EQ(requests[i].requestLine.find("PUT /container/blob?"), 0u);
+    ASSERT_EQ(getQueryParam(requests[i].requestLine, "comp"), "block");
+    blocks[getQueryParam(requests[i].requestLine, "blockid")] = requests[i].body;
+  }
+  ASSERT_EQ(blocks.size(), 11u);
+
+  // but the block list has them in order
+  const RequestLog::Entry &commit = requests[11];
+  ASSERT_EQ(getQueryParam(commit.requestLine, "comp"), "blocklist");
+
+  std::string reassembled;
+  size_t pos = 0, count = 0;
+  while((pos = commit.body.find("<Latest>", pos)) != std::string::npos) {
+    pos += 8;
+    const std::string blockid = commit.body.substr(pos, commit.body.find("</Latest>", pos) - pos);
+    ASSERT_EQ(blocks.count(blockid), 1u);
+    ASSERT_EQ(blocks[blockid].size(), count < 10 ? 1000u : 500u);
+
+    reassembled += blocks[blockid];
+    count++;
+  }
+
+  ASSERT_EQ(count, 11u);
+  ASSERT_EQ(reassembled, content);
+}
@@ -0,0 +1,144 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+#include <davix_context_internal.hpp>
+#include <core/BlockCache.hpp>
+
+using namespace Davix;
+
+class BlockCacheTest : public DavixTestFixture {
+public:
+  BlockCacheTest() : _file(makeContent(600000)) {
+    for(size_t i = 0; i < 8; i++) {
+      _interactors.emplace_back(new FileInteractor(_log, _file));
+      _drunk_server->autoAcceptNext(_interactors.back().get());
+    }
+
+    _context.setBlockCacheLimit(16 << 20);
+    _params.setProtocol(RequestProtocol::Http);
+    _params.setOperationRetry(0);
+    _params.setMetalinkMode(MetalinkMode::Disable);
+  }
+
+  static std::string makeContent(size_t size) {
+    std::string content;
+    for(size_t i = 0; i < size; i++) {
+      content.push_back('a' + (i % 23));
+    }
+    return content;
+  }
+
+  std::string read(dav_off_t offset, dav_size_t size) {
+    DavFile file(_context, _params, Uri("http://localhost:22222/file"));
+    std::string out(size, '\0');
+    DavixError *err = NULL;
+    dav_ssize_t ret = file.readPartial(&_params, &out[0], size, offset, &err);
+    EXPECT_TRUE(err == NULL) << (err ? err->getErrMsg() : "");
+    DavixError::clearError(&err);
+    out.resize(std::max<dav_ssize_t>(ret, 0));
+    return out;
+  }
+
+  // GET requests received so far, as their Range header
+  std::vector<std::string> gets() {
+    std::vector<std::string> out;
+    for(const RequestLog::Entry &entry : _log.entries()) {
+      if(entry.requestLine.compare(0, 4, "GET ") == 0) {
+        out.push_back(entry.range);
+      }
+    }
+    return out;
+  }
+
+protected:
+  RequestLog _log;
+  ServedFile _file;
+  std::vector<std::unique_ptr<FileInteractor> > _interactors;
+  Context _context;
+};
+
+TEST_F(BlockCacheTest, Ranges) {
+  const std::string content = makeContent(600000);
+
+  // 206: whole blocks are fetched, and served from the cache from then on
+  ASSERT_EQ(read(10, 100), content.substr(10, 100));
+  ASSERT_EQ(read(200, 100), content.substr(200, 100));
+  ASSERT_EQ(read(262100, 200), content.substr(262100, 200));
+
+  std::vector<std::string> ranges = gets();
+  ASSERT_EQ(ranges.size(), 2u);
+  ASSERT_EQ(ranges[0], "bytes=0-262143");
+  ASSERT_EQ(ranges[1], "bytes=262144-524287");
+
+  // 416: past the end of the file
+  ASSERT_EQ(read(800000, 100), "");
+  ASSERT_EQ(gets().size(), 3u);
+
+  // short last block
+  ASSERT_EQ(read(599990, 100), content.substr(599990));
+  ASSERT_EQ(gets().size(), 4u);
+  ASSERT_EQ(read(599000, 10), content.substr(599000, 10));
+  ASSERT_EQ(gets().size(), 4u);
+}
+
+TEST_F(BlockCacheTest, RangesIgnored) {
+  const std::string content = makeContent(600000);
+  _file.setRangeSupport(false);
+
+  // plain 200: the block fetch gives up, and the read goes to the rest of
+  // the chain, which picks the bytes out of the whole file
+  ASSERT_EQ(read(10, 100), content.substr(10, 100));
+  ASSERT_EQ(gets().size(), 2u);
+
+  // remembered: no more block fetches for this file
+  ASSERT_EQ(read(300000, 100), content.substr(300000, 100));
+  ASSERT_EQ(gets().size(), 3u);
+  ASSERT_EQ(ContextExplorer::BlockCacheFromContext(_context).size(), 0u);
+}
+
+TEST_F(BlockCacheTest, ChangedDuringRead) {
+  const std::string content = makeContent(600000);
+
+  // the first block is cached under the ETag of the first version
+  ASSERT_EQ(read(10, 100), content.substr(10, 100));
+  ASSERT_EQ(gets().size(), 1u);
+
+  // the second block comes with another ETag: the read starts over, and
+  // does not mix the two versions
+  std::string updated = content;
+  std::fill(updated.begin(), updated.end(), 'z');
+  _file.update(updated, "Mon, 02 Jan 2006 15:04:05 GMT");
+
+  ASSERT_EQ(read(262000, 1000), updated.substr(262000, 1000));
+
+  std::vector<std::string> ranges = gets();
+  ASSERT_EQ(ranges.size(), 3u);
+  ASSERT_EQ(ranges[1], "bytes=262144-524287");
+  ASSERT_EQ(ranges[2], "bytes=0-262143");
+
+  // both blocks are now cached under the new ETag
+  ASSERT_EQ(read(0, 300000), updated.substr(0, 300000));
+  ASSERT_EQ(gets().size(), 3u);
+}
@@ -0,0 +1,159 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ * Author: Georgios Bitzes <georgios.bitzes@cern.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+#include <cstdlib>
+#include <thread>
+
+using namespace Davix;
+
+class ContextTest : public DavixTestFixture {};
+
+TEST_F(ContextTest, PrewarmConnections) {
+  Context context;
+  ASSERT_TRUE(context.getSessionPoolStats().empty());
+
+  SingleShotInteractor inter1(
+    SSTR("HEAD /chickens HTTP/1.1\r\n"),
+    SSTR("HTTP/1.1 200 OK\r\n"        <<
+         "Content-Length: 0\r\n"      <<
+         "\r\n")
+  );
+
+  SingleShotInteractor inter2(
+    SSTR("HEAD /chickens HTTP/1.1\r\n"),
+    SSTR("HTTP/1.1 200 OK\r\n"        <<
+         "Content-Length: 0\r\n"      <<
+         "\r\n")
+  );
+
+  _drunk_server->autoAcceptNext(&inter1);
+  _drunk_server->autoAcceptNext(&inter2);
+
+  DavixError *err = NULL;
+  ASSERT_EQ(context.prewarmConnections(Uri("http://localhost:22222/chickens"), 2, NULL, &err), 2);
+  ASSERT_TRUE(err == NULL);
+
+  // the interactors flag success only after the write has returned
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ASSERT_TRUE(inter1.ok());
+  ASSERT_TRUE(inter2.ok());
+
+  std::map<std::string, SessionPoolStats> stats = context.getSessionPoolStats();
+  ASSERT_EQ(stats.size(), 1u);
+
+  SessionPoolStats &host = stats["http://localhost:22222"];
+  ASSERT_EQ(host.created, 2u);
+  ASSERT_EQ(host.live, 2u);
+  ASSERT_EQ(host.idle, 2u);
+  ASSERT_EQ(host.reused, 0u);
+}
+
+TEST_F(ContextTest, PrewarmConnectionsFewWorkers) {
+  Context context;
+  context.setWorkerThreads(1);
+
+  //----------------------------------------------------------------------------
+  // More sessions than workers: each request still opens a session of its own
+  //----------------------------------------------------------------------------
+  std::vector<std::unique_ptr<SingleShotInteractor>> interactors;
+  for(size_t i = 0; i < 40; i++) {
+    interactors.emplace_back(new SingleShotInteractor(
+      SSTR("HEAD /chickens HTTP/1.1\r\n"),
+      SSTR("HTTP/1.1 200 OK\r\n"        <<
+           "Content-Length: 0\r\n"      <<
+           "\r\n")
+    ));
+    _drunk_server->autoAcceptNext(interactors.back().get());
+  }
+
+  //----------------------------------------------------------------------------
+  // Clamped to the idle limit of the session pool
+  //----------------------------------------------------------------------------
+  DavixError *err = NULL;
+  ASSERT_EQ(context.prewarmConnections(Uri("http://localhost:22222/chickens"), 40, NULL, &err), 32);
+  ASSERT_TRUE(err == NULL);
+
+  SessionPoolStats host = context.getSessionPoolStats()["http://localhost:22222"];
+  ASSERT_EQ(host.created, 32u);
+  ASSERT_EQ(host.idle, 32u);
+  ASSERT_EQ(host.reused, 0u);
+}
+
+TEST_F(ContextTest, PrewarmConnectionsFailure) {
+  Context context;
+  RequestParams params;
+  setConnectionTimeout(std::chrono::seconds(1));
+  params = _params;
+  params.setOperationRetry(0);
+
+  DavixError *err = NULL;
+  ASSERT_EQ(context.prewarmConnections(Uri("http://localhost:22223/chickens"), 2, &params, &err), -1);
+  ASSERT_TRUE(err != NULL);
+  DavixError::clearError(&err);
+
+  ASSERT_EQ(context.prewarmConnections(Uri("http://localhost:22223/chickens"), 0, &params, &err), 0);
+  ASSERT_TRUE(err == NULL);
+}
+
+TEST_F(ContextTest, ResponseBufferStats) {
+  Context context;
+  ResponseBufferStats stats = context.getResponseBufferStats();
+  ASSERT_EQ(stats.allocated, 0u);
+  ASSERT_EQ(stats.reused, 0u);
+
+  std::string body;
+  for(size_t i = 0; i < 200000; i++) {
+    body.push_back('a' + (i % 26));
+  }
+
+  SingleShotInteractor inter(
+    SSTR("GET /chickens HTTP/1.1\r\n"),
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Content-Length: " << body.size() << "\r\n" <<
+         "\r\n"                                      <<
+         body)
+  );
+  _drunk_server->autoAcceptNext(&inter);
+
+  //----------------------------------------------------------------------------
+  // 1 KiB blocks all along: one block per KiB of the body
+  //----------------------------------------------------------------------------
+  setenv("DAVIX_USE_LIBCURL", "1", 1);
+  RequestParams params(_params);
+  params.setResponseBlockSize(1024, 1024);
+
+  DavixError *err = NULL;
+  HttpRequest req(context, Uri("http://localhost:22222/chickens"), &err);
+  req.setParameters(params);
+  ASSERT_EQ(req.executeRequest(&err), 0);
+  unsetenv("DAVIX_USE_LIBCURL");
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_EQ(req.getAnswerContent(), body);
+
+  stats = context.getResponseBufferStats();
+  ASSERT_GE(stats.allocated + stats.reused, body.size() / 1024);
+  ASSERT_GT(stats.cached_bytes, 0u);
+}
@@ -0,0 +1,141 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+#include <cstdlib>
+#include <dirent.h>
+
+using namespace Davix;
+
+class DiskCacheTest : public DavixTestFixture {
+public:
+  DiskCacheTest() : _file(makeContent(600000)) {
+    for(size_t i = 0; i < 16; i++) {
+      _interactors.emplace_back(new FileInteractor(_log, _file));
+      _drunk_server->autoAcceptNext(_interactors.back().get());
+    }
+
+    char tmpl[] = "/tmp/davix-disk-cache-XXXXXX";
+    if(mkdtemp(tmpl) != NULL) {
+      _dir = tmpl;
+    }
+
+    _params.setProtocol(RequestProtocol::Http);
+    _params.setOperationRetry(0);
+    _params.setMetalinkMode(MetalinkMode::Disable);
+  }
+
+  ~DiskCacheTest() {
+    DIR *dir = opendir(_dir.c_str());
+    struct dirent *ent;
+    while(dir && (ent = readdir(dir)) != NULL) {
+      unlink((_dir + "/" + ent->d_name).c_str());
+    }
+    if(dir) closedir(dir);
+    rmdir(_dir.c_str());
+  }
+
+  static std::string makeContent(size_t size, char first = 'a') {
+    std::string content;
+    for(size_t i = 0; i < size; i++) {
+      content.push_back(first + (i % 23));
+    }
+    return content;
+  }
+
+  std::string read(Context &context, dav_off_t offset, dav_size_t size) {
+    DavFile file(context, _params, Uri("http://localhost:22222/file"));
+    std::string out(size, '\0');
+    DavixError *err = NULL;
+    dav_ssize_t ret = file.readPartial(&_params, &out[0], size, offset, &err);
+    EXPECT_TRUE(err == NULL) << (err ? err->getErrMsg() : "");
+    DavixError::clearError(&err);
+    out.resize(std::max<dav_ssize_t>(ret, 0));
+    return out;
+  }
+
+  // requests received so far, as their method
+  std::vector<std::string> methods() {
+    std::vector<std::string> out;
+    for(const RequestLog::Entry &entry : _log.entries()) {
+      out.push_back(entry.requestLine.substr(0, entry.requestLine.find(' ')));
+    }
+    return out;
+  }
+
+protected:
+  RequestLog _log;
+  ServedFile _file;
+  std::vector<std::unique_ptr<FileInteractor> > _interactors;
+  std::string _dir;
+};
+
+TEST_F(DiskCacheTest, ReadThrough) {
+  ASSERT_FALSE(_dir.empty());
+  const std::string content = makeContent(600000);
+
+  Context context;
+  context.setDiskCache(_dir, 0);
+
+  ASSERT_EQ(read(context, 10, 100), content.substr(10, 100));
+  ASSERT_EQ(methods(), std::vector<std::string>({"HEAD", "GET"}));
+
+  // served from the disk
+  ASSERT_EQ(read(context, 10, 100), content.substr(10, 100));
+  ASSERT_EQ(read(context, 300000, 100), content.substr(300000, 100));
+  ASSERT_EQ(methods().size(), 2u);
+
+  // another process: the file is validated, and still served from the disk
+  Context later;
+  later.setDiskCache(_dir, 0);
+  ASSERT_EQ(read(later, 300000, 100), content.substr(300000, 100));
+  ASSERT_EQ(methods(), std::vector<std::string>({"HEAD", "GET", "HEAD"}));
+}
+
+TEST_F(DiskCacheTest, Changed) {
+  ASSERT_FALSE(_dir.empty());
+
+  Context context;
+  context.setDiskCache(_dir, 0);
+  ASSERT_EQ(read(context, 10, 100), makeContent(600000).substr(10, 100));
+  ASSERT_EQ(methods().size(), 2u);
+
+  // modified
+  const std::string modified = makeContent(600000, 'b');
+  _file.update(modified, "Tue, 02 Jul 2019 10:00:00 GMT");
+
+  Context later;
+  later.setDiskCache(_dir, 0);
+  ASSERT_EQ(read(later, 10, 100), modified.substr(10, 100));
+  ASSERT_EQ(methods(), std::vector<std::string>({"HEAD", "GET", "HEAD", "GET"}));
+
+  // resized within the same second
+  const std::string resized = makeContent(500000, 'c');
+  _file.update(resized, "Tue, 02 Jul 2019 10:00:00 GMT");
+
+  Context evenLater;
+  evenLater.setDiskCache(_dir, 0);
+  ASSERT_EQ(read(evenLater, 10, 100), resized.substr(10, 100));
+  ASSERT_EQ(methods(), std::vector<std::string>({"HEAD", "GET", "HEAD", "GET", "HEAD", "GET"}));
+}
@@ -0,0 +1,303 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+#include <davix_context_internal.hpp>
+#include <core/BlockCache.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <thread>
+
+using namespace Davix;
+
+class IOBufferTest : public DavixTestFixture {
+public:
+  IOBufferTest() : _content(makeContent(6 << 20)), _file(_content) {
+    for(size_t i = 0; i < 64; i++) {
+      _interactors.emplace_back(new FileInteractor(_log, _file));
+      _drunk_server->autoAcceptNext(_interactors.back().get());
+    }
+
+    _params.setProtocol(RequestProtocol::Http);
+    _params.setOperationRetry(0);
+    _params.setMetalinkMode(MetalinkMode::Disable);
+  }
+
+  // no period, so that reading from the wrong offset shows
+  static std::string makeContent(size_t size) {
+    std::string content(size, '\0');
+    uint32_t state = 1;
+    for(size_t i = 0; i < size; i++) {
+      state = state * 1103515245 + 12345;
+      content[i] = static_cast<char>(state >> 16);
+    }
+    return content;
+  }
+
+  void serve(const std::string &content) {
+    _content = content;
+    _file.update(content, "Mon, 01 Jul 2019 10:00:00 GMT");
+  }
+
+  DAVIX_FD* open() {
+    DavixError *err = NULL;
+    DAVIX_FD *fd = _posix.open(&_params, "http://localhost:22222/file", O_RDONLY, &err);
+    EXPECT_TRUE(err == NULL) << (err ? err->getErrMsg() : "");
+    DavixError::clearError(&err);
+    return fd;
+  }
+
+  void close(DAVIX_FD *fd) {
+    DavixError *err = NULL;
+    _posix.close(fd, &err);
+    DavixError::clearError(&err);
+  }
+
+  std::string read(DAVIX_FD *fd, dav_size_t size) {
+    std::string out(size, '\0');
+    DavixError *err = NULL;
+    dav_ssize_t ret = _posix.read(fd, &out[0], size, &err);
+    EXPECT_TRUE(err == NULL) << (err ? err->getErrMsg() : "");
+    DavixError::clearError(&err);
+    out.resize(std::max<dav_ssize_t>(ret, 0));
+    return out;
+  }
+
+  // read until the end of the file, step bytes at a time
+  std::string readAll(DAVIX_FD *fd, dav_size_t step) {
+    std::string out;
+    std::string chunk;
+    while(!(chunk = read(fd, step)).empty()) {
+      out += chunk;
+    }
+    return out;
+  }
+
+  std::string pread(DAVIX_FD *fd, dav_off_t offset, dav_size_t size) {
+    std::string out(size, '\0');
+    DavixError *err = NULL;
+    dav_ssize_t ret = _posix.pread64(fd, &out[0], size, offset, &err);
+    EXPECT_TRUE(err == NULL) << (err ? err->getErrMsg() : "");
+    DavixError::clearError(&err);
+    out.resize(std::max<dav_ssize_t>(ret, 0));
+    return out;
+  }
+
+  void seek(DAVIX_FD *fd, dav_off_t offset) {
+    DavixError *err = NULL;
+    ASSERT_EQ(_posix.lseek64(fd, offset, SEEK_SET, &err), offset);
+    DavixError::clearError(&err);
+  }
+
+  // GET requests received so far, as their Range header
+  std::vector<std::string> gets() {
+    std::vector<std::string> out;
+    for(const RequestLog::Entry &entry : _log.entries()) {
+      if(entry.requestLine.compare(0, 4, "GET ") == 0) {
+        out.push_back(entry.range);
+      }
+    }
+    return out;
+  }
+
+  // length of the largest range requested so far
+  dav_size_t largestRange() {
+    dav_size_t largest = 0;
+    for(const std::string &range : gets()) {
+      unsigned long long first, last;
+      if(sscanf(range.c_str(), "bytes=%llu-%llu", &first, &last) == 2) {
+        largest = std::max<dav_size_t>(largest, last - first + 1);
+      }
+    }
+    return largest;
+  }
+
+protected:
+  RequestLog _log;
+  std::string _content;
+  ServedFile _file;
+  std::vector<std::unique_ptr<FileInteractor> > _interactors;
+  Context _context;
+  DavPosix _posix{&_context};
+};
+
+TEST_F(IOBufferTest, ReadAhead) {
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+  ASSERT_EQ(readAll(fd, 100000), _content);
+  close(fd);
+
+  // in 1 MiB ranges, each of them fetched once
+  std::vector<std::string> ranges = gets();
+  ASSERT_EQ(ranges.size(), 6u);
+  ASSERT_EQ(largestRange(), 1u << 20);
+}
+
+TEST_F(IOBufferTest, BackwardSeek) {
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+  ASSERT_EQ(read(fd, 3 << 20), _content.substr(0, 3 << 20));
+
+  // the window ahead of the old position must not be served from here
+  seek(fd, 1000);
+  ASSERT_EQ(read(fd, 100), _content.substr(1000, 100));
+  ASSERT_EQ(read(fd, 2 << 20), _content.substr(1100, 2 << 20));
+
+  seek(fd, (2 << 20) + 12345);
+  ASSERT_EQ(readAll(fd, 300000), _content.substr((2 << 20) + 12345));
+  close(fd);
+}
+
+TEST_F(IOBufferTest, WindowGrows) {
+  serve(makeContent(48 << 20));
+
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+  ASSERT_EQ(readAll(fd, 1 << 20), _content);
+  close(fd);
+
+  // past 16 MiB, and 32 MiB at most: fetched in chunks of an eighth of the
+  // window, cut at the end of the file
+  ASSERT_GT(largestRange(), 2u << 20);
+  ASSERT_LE(largestRange(), 4u << 20);
+}
+
+TEST_F(IOBufferTest, WindowOverride) {
+  serve(makeContent(48 << 20));
+
+  setenv("DAVIX_READAHEAD_WINDOW", "16777216", 1);
+  DAVIX_FD *fd = open();
+  unsetenv("DAVIX_READAHEAD_WINDOW");
+  ASSERT_TRUE(fd != NULL);
+  ASSERT_EQ(readAll(fd, 1 << 20), _content);
+  close(fd);
+
+  ASSERT_EQ(largestRange(), 2u << 20);
+}
+
+TEST_F(IOBufferTest, WindowDisabled) {
+  setenv("DAVIX_READAHEAD_WINDOW", "0", 1);
+  DAVIX_FD *fd = open();
+  unsetenv("DAVIX_READAHEAD_WINDOW");
+  ASSERT_TRUE(fd != NULL);
+  ASSERT_EQ(readAll(fd, 100000), _content);
+  close(fd);
+
+  // a single streamed GET
+  ASSERT_EQ(gets(), std::vector<std::string>({""}));
+}
+
+TEST_F(IOBufferTest, RangesIgnored) {
+  _file.setRangeSupport(false);
+
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+  ASSERT_EQ(readAll(fd, 100000), _content);
+  close(fd);
+
+  // the first chunks of the window, then a plain stream of the file
+  std::vector<std::string> ranges = gets();
+  ASSERT_LE(ranges.size(), 3u);
+  ASSERT_EQ(ranges.back(), "");
+}
+
+TEST_F(IOBufferTest, Shrunk) {
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+
+  // chunks past the new end get a 416, which ends the file
+  const std::string content = _content;
+  serve(content.substr(0, 1 << 20));
+  ASSERT_EQ(readAll(fd, 100000), _content);
+  close(fd);
+}
+
+TEST_F(IOBufferTest, WillNeed) {
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+
+  _posix.fadvise(fd, 1000, 5000, AdviseWillNeed);
+  ASSERT_EQ(pread(fd, 1000, 5000), _content.substr(1000, 5000));
+  ASSERT_EQ(pread(fd, 3000, 100), _content.substr(3000, 100));
+  ASSERT_EQ(gets(), std::vector<std::string>({"bytes=1000-5999"}));
+
+  // not announced
+  ASSERT_EQ(pread(fd, 200000, 100), _content.substr(200000, 100));
+  ASSERT_EQ(gets().size(), 2u);
+  close(fd);
+}
+
+TEST_F(IOBufferTest, WillNeedBlockCache) {
+  _context.setBlockCacheLimit(16 << 20);
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+
+  // fetched once, as whole blocks into the block cache, rather than a second
+  // time by the prefetching further down the chain
+  std::vector<std::string> expected;
+  for(dav_off_t i = 0; i < 8; i++) {
+    _posix.fadvise(fd, i * 300000 + 1000, 10000, AdviseWillNeed);
+
+    const dav_off_t block = (i * 300000 + 1000) / 262144;
+    expected.push_back("bytes=" + std::to_string(block * 262144) + "-" + std::to_string(block * 262144 + 262143));
+  }
+
+  BlockCache &cache = ContextExplorer::BlockCacheFromContext(_context);
+  for(size_t i = 0; i < 200 && cache.size() < expected.size() * 262144; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  for(dav_off_t i = 0; i < 8; i++) {
+    ASSERT_EQ(pread(fd, i * 300000 + 1000, 10000), _content.substr(i * 300000 + 1000, 10000));
+  }
+
+  std::vector<std::string> ranges = gets();
+  std::sort(ranges.begin(), ranges.end());
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(ranges, expected);
+  close(fd);
+}
+
+TEST_F(IOBufferTest, PrefetchLimit) {
+  DAVIX_FD *fd = open();
+  ASSERT_TRUE(fd != NULL);
+
+  // 70 MiB announced: the oldest ranges are dropped to stay within 64 MiB
+  const dav_size_t size = 5 << 20;
+  for(dav_off_t i = 0; i < 14; i++) {
+    _posix.fadvise(fd, i * 65536, size, AdviseWillNeed);
+  }
+
+  // announced last, fetched last
+  ASSERT_EQ(pread(fd, 13 * 65536, size), _content.substr(13 * 65536, size));
+  const size_t fetched = gets().size();
+
+  ASSERT_EQ(pread(fd, 2 * 65536, size), _content.substr(2 * 65536, size));
+  ASSERT_EQ(gets().size(), fetched);
+
+  ASSERT_EQ(pread(fd, 0, size), _content.substr(0, size));
+  ASSERT_GT(gets().size(), fetched);
+  close(fd);
+}
@@ -0,0 +1,149 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+
+using namespace Davix;
+
+//------------------------------------------------------------------------------
+// A head server at localhost, redirecting to disk servers at 127.0.0.1 and
+// 127.0.0.2 - all of them the drunk server, told apart by the Host header
+//------------------------------------------------------------------------------
+class RedirectionTest : public DavixTestFixture {
+public:
+  RedirectionTest() {
+    for(size_t i = 0; i < 16; i++) {
+      _interactors.emplace_back(new RoutingInteractor(_log, route));
+      _drunk_server->autoAcceptNext(_interactors.back().get());
+    }
+
+    _params.setProtocol(RequestProtocol::Http);
+    _params.setOperationRetry(0);
+    _params.setRedirectionPrediction(true);
+  }
+
+  static std::string answer(const std::string &status, const std::string &body) {
+    return "HTTP/1.1 " + status + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+  }
+
+  // file1 and file2 are on disk1, missing is nowhere, local is on the head
+  // server itself, everything else is on disk2
+  static std::string route(const RequestLog::Entry &entry) {
+    const std::string path = entry.requestLine.substr(4, entry.requestLine.find(' ', 4) - 4);
+    const bool onDisk1 = (path == "/data/file1" || path == "/data/file2");
+    const bool onDisk2 = !onDisk1 && path != "/data/missing" && path != "/data/local";
+
+    if(entry.host == "localhost:22222") {
+      if(onDisk1 || onDisk2) {
+        const std::string location = std::string("http://") + (onDisk1 ? "127.0.0.1" : "127.0.0.2") + ":22222" + path;
+        return "HTTP/1.1 302 Found\r\nLocation: " + location + "\r\nContent-Length: 0\r\n\r\n";
+      }
+
+      return (path == "/data/local") ? answer("200 OK", "head") : answer("404 Not Found", "");
+    }
+
+    if((entry.host == "127.0.0.1:22222" && onDisk1) || (entry.host == "127.0.0.2:22222" && onDisk2)) {
+      return answer("200 OK", entry.host.substr(0, 9));
+    }
+
+    return answer("404 Not Found", "");
+  }
+
+  // GET the given file from the head server: status, and body
+  std::pair<int, std::string> get(const std::string &name) {
+    DavixError *err = NULL;
+    GetRequest req(_context, Uri("http://localhost:22222/data/" + name), &err);
+    req.setParameters(_params);
+    req.executeRequest(&err);
+    EXPECT_TRUE(err == NULL || req.getRequestCode() >= 400) << err->getErrMsg();
+    DavixError::clearError(&err);
+    return std::make_pair(req.getRequestCode(), std::string(req.getAnswerContent() ? req.getAnswerContent() : ""));
+  }
+
+  // servers requests were sent to since the last call
+  std::vector<std::string> hosts() {
+    std::vector<RequestLog::Entry> entries = _log.entries();
+    std::vector<std::string> out;
+    for(size_t i = _seen; i < entries.size(); i++) {
+      out.push_back(entries[i].host.substr(0, entries[i].host.find(':')));
+    }
+    _seen = entries.size();
+    return out;
+  }
+
+protected:
+  RequestLog _log;
+  std::vector<std::unique_ptr<RoutingInteractor> > _interactors;
+  Context _context;
+  size_t _seen = 0;
+};
+
+TEST_F(RedirectionTest, Prediction) {
+  // learnt from a redirection, then used for the other files of the directory
+  ASSERT_EQ(get("file1"), std::make_pair(200, std::string("127.0.0.1")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"localhost", "127.0.0.1"}));
+
+  ASSERT_EQ(get("file2"), std::make_pair(200, std::string("127.0.0.1")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"127.0.0.1"}));
+}
+
+TEST_F(RedirectionTest, Relearn) {
+  ASSERT_EQ(get("file1"), std::make_pair(200, std::string("127.0.0.1")));
+  hosts();
+
+  // not on the predicted server: back to the head server, which redirects to
+  // another one, used from then on
+  ASSERT_EQ(get("file3"), std::make_pair(200, std::string("127.0.0.2")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"127.0.0.1", "localhost", "127.0.0.2"}));
+
+  ASSERT_EQ(get("file4"), std::make_pair(200, std::string("127.0.0.2")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"127.0.0.2"}));
+}
+
+TEST_F(RedirectionTest, Missing) {
+  ASSERT_EQ(get("file3"), std::make_pair(200, std::string("127.0.0.2")));
+  hosts();
+
+  // the head server doesn't know the file either: predictions go on
+  ASSERT_EQ(get("missing").first, 404);
+  ASSERT_EQ(hosts(), std::vector<std::string>({"127.0.0.2", "localhost"}));
+
+  ASSERT_EQ(get("file4"), std::make_pair(200, std::string("127.0.0.2")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"127.0.0.2"}));
+}
+
+TEST_F(RedirectionTest, AnsweredByOrigin) {
+  ASSERT_EQ(get("file3"), std::make_pair(200, std::string("127.0.0.2")));
+  hosts();
+
+  // the head server serves some files itself: predictions stop
+  ASSERT_EQ(get("local"), std::make_pair(200, std::string("head")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"127.0.0.2", "localhost"}));
+
+  ASSERT_EQ(get("file4"), std::make_pair(200, std::string("127.0.0.2")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"localhost", "127.0.0.2"}));
+
+  ASSERT_EQ(get("file5"), std::make_pair(200, std::string("127.0.0.2")));
+  ASSERT_EQ(hosts(), std::vector<std::string>({"localhost", "127.0.0.2"}));
+}
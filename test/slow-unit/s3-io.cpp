@@ -0,0 +1,73 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+
+using namespace Davix;
+
+class S3IOTest : public DavixTestFixture {};
+
+TEST_F(S3IOTest, MinimumPartSize) {
+  RequestLog log;
+  std::vector<std::unique_ptr<RecordingInteractor> > interactors;
+
+  // the same answer does for the initiation, the parts and the commit - and
+  // enough connections for 1 MiB parts, not to hang if they were sent
+  const std::string body = "<InitiateMultipartUploadResult><UploadId>xyz</UploadId></InitiateMultipartUploadResult>";
+  for(size_t i = 0; i < 16; i++) {
+    interactors.emplace_back(new RecordingInteractor(log, "HTTP/1.1 200 OK\r\nEtag: abc\r\nContent-Length: " +
+                                                          std::to_string(body.size()) + "\r\n\r\n" + body));
+    _drunk_server->autoAcceptNext(interactors.back().get());
+  }
+
+  const std::string content((12 << 20) + 100, 'x');
+
+  {
+    Context context;
+    RequestParams params;
+    params.setProtocol(RequestProtocol::AwsS3);
+    params.setAwsAuthorizationKeys("secret", "access");
+    params.setOperationRetry(0);
+    params.setUploadThreshold(1 << 20);
+    params.setUploadChunkSize(1 << 20);
+
+    DavFile file(context, params, Uri("http://localhost:22222/bucket/object"));
+    file.put(&params, content.c_str(), content.size());
+  }
+
+  // 5 MiB parts, except the last one
+  std::map<std::string, size_t> parts;
+  for(const RequestLog::Entry &entry : log.entries()) {
+    if(entry.requestLine.compare(0, 4, "PUT ") == 0) {
+      const size_t pos = entry.requestLine.find("partNumber=");
+      ASSERT_NE(pos, std::string::npos);
+      parts[entry.requestLine.substr(pos + 11, entry.requestLine.find_first_of("& ", pos) - pos - 11)] = entry.body.size();
+    }
+  }
+
+  ASSERT_EQ(parts.size(), 3u);
+  ASSERT_EQ(parts["1"], 5u << 20);
+  ASSERT_EQ(parts["2"], 5u << 20);
+  ASSERT_EQ(parts["3"], (2u << 20) + 100);
+}
@@ -0,0 +1,217 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+using namespace Davix;
+
+class SegmentedDownloadTest : public DavixTestFixture {
+public:
+  SegmentedDownloadTest() : _content(makeContent(6 << 20)), _file(_content), _fd(-1) {
+    for(size_t i = 0; i < 32; i++) {
+      _interactors.emplace_back(new FileInteractor(_log, _file));
+      _drunk_server->autoAcceptNext(_interactors.back().get());
+    }
+
+    char tmpl[] = "/tmp/davix-segmented-XXXXXX";
+    _fd = mkstemp(tmpl);
+    _path = tmpl;
+
+    _params.setProtocol(RequestProtocol::Http);
+    _params.setOperationRetry(0);
+    _params.setMetalinkMode(MetalinkMode::Disable);
+    _params.setTransferStreams(4);
+  }
+
+  ~SegmentedDownloadTest() {
+    if(_fd >= 0) {
+      close(_fd);
+      unlink(_path.c_str());
+    }
+  }
+
+  // no period, so that segments written at the wrong offset show
+  static std::string makeContent(size_t size) {
+    std::string content(size, '\0');
+    uint32_t state = 1;
+    for(size_t i = 0; i < size; i++) {
+      state = state * 1103515245 + 12345;
+      content[i] = static_cast<char>(state >> 16);
+    }
+    return content;
+  }
+
+  dav_ssize_t download(int fd, DavixError **err) {
+    DavFile file(_context, _params, Uri("http://localhost:22222/file"));
+    return file.getToFd(&_params, fd, err);
+  }
+
+  std::string written() {
+    std::string out(lseek(_fd, 0, SEEK_END), '\0');
+    EXPECT_EQ(pread(_fd, &out[0], out.size(), 0), (ssize_t) out.size());
+    return out;
+  }
+
+  // GET requests received so far, as their Range header
+  std::vector<std::string> gets() {
+    std::vector<std::string> out;
+    for(const RequestLog::Entry &entry : _log.entries()) {
+      if(entry.requestLine.compare(0, 4, "GET ") == 0) {
+        out.push_back(entry.range);
+      }
+    }
+    return out;
+  }
+
+protected:
+  RequestLog _log;
+  std::string _content;
+  ServedFile _file;
+  std::vector<std::unique_ptr<FileInteractor> > _interactors;
+  Context _context;
+  std::string _path;
+  int _fd;
+};
+
+TEST_F(SegmentedDownloadTest, Segments) {
+  ASSERT_GE(_fd, 0);
+
+  DavixError *err = NULL;
+  ASSERT_EQ(download(_fd, &err), (dav_ssize_t) _content.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_TRUE(written() == _content);
+
+  // the first segment on its own, then the others in parallel
+  std::vector<std::string> ranges = gets();
+  ASSERT_GT(ranges.size(), 2u);
+  ASSERT_EQ(ranges[0], "bytes=0-1048575");
+  for(const std::string &range : ranges) {
+    ASSERT_FALSE(range.empty());
+  }
+}
+
+TEST_F(SegmentedDownloadTest, SameAsSingleStream) {
+  ASSERT_GE(_fd, 0);
+
+  DavixError *err = NULL;
+  ASSERT_EQ(download(_fd, &err), (dav_ssize_t) _content.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  const std::string segmented = written();
+
+  ASSERT_EQ(ftruncate(_fd, 0), 0);
+  ASSERT_EQ(lseek(_fd, 0, SEEK_SET), 0);
+  _params.setTransferStreams(1);
+  ASSERT_EQ(download(_fd, &err), (dav_ssize_t) _content.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_EQ(gets().back(), "");
+
+  ASSERT_TRUE(written() == segmented);
+}
+
+TEST_F(SegmentedDownloadTest, RangesIgnored) {
+  ASSERT_GE(_fd, 0);
+  _file.setRangeSupport(false);
+
+  // the probe gets the whole file: a single stream from then on
+  DavixError *err = NULL;
+  ASSERT_EQ(download(_fd, &err), (dav_ssize_t) _content.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_TRUE(written() == _content);
+  ASSERT_EQ(gets(), std::vector<std::string>({"bytes=0-1048575", ""}));
+}
+
+TEST_F(SegmentedDownloadTest, FailingSegment) {
+  ASSERT_GE(_fd, 0);
+  _file.failRangesFrom(3 << 20);
+
+  DavixError *err = NULL;
+  ASSERT_EQ(download(_fd, &err), -1);
+  ASSERT_TRUE(err != NULL);
+  DavixError::clearError(&err);
+
+  // no silent fallback to a single stream
+  for(const std::string &range : gets()) {
+    ASSERT_FALSE(range.empty());
+  }
+}
+
+TEST_F(SegmentedDownloadTest, StaleStatCache) {
+  ASSERT_GE(_fd, 0);
+  _context.setStatCacheTTL(3600);
+
+  DavixError *err = NULL;
+  DavFile file(_context, _params, Uri("http://localhost:22222/file"));
+  StatInfo info;
+  file.statInfo(&_params, info);
+  ASSERT_EQ(info.size, _content.size());
+
+  // grown since: the download must not stop at the cached size
+  const std::string grown = _content + makeContent(2 << 20);
+  _file.update(grown, "Mon, 02 Jan 2006 15:04:05 GMT");
+
+  ASSERT_EQ(download(_fd, &err), (dav_ssize_t) grown.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_TRUE(written() == grown);
+}
+
+TEST_F(SegmentedDownloadTest, HeadRefused) {
+  ASSERT_GE(_fd, 0);
+  _file.setHeadSupport(false);
+
+  // no size to split: a single stream
+  DavixError *err = NULL;
+  ASSERT_EQ(download(_fd, &err), (dav_ssize_t) _content.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_TRUE(written() == _content);
+  ASSERT_EQ(gets(), std::vector<std::string>({""}));
+}
+
+TEST_F(SegmentedDownloadTest, Pipe) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  std::string received;
+  std::thread reader([&]() {
+    char buffer[65536];
+    ssize_t ret;
+    while((ret = read(fds[0], buffer, sizeof(buffer))) > 0) {
+      received.append(buffer, ret);
+    }
+  });
+
+  // can't write at offsets: a single stream
+  DavixError *err = NULL;
+  const dav_ssize_t ret = download(fds[1], &err);
+  close(fds[1]);
+  reader.join();
+  close(fds[0]);
+
+  ASSERT_EQ(ret, (dav_ssize_t) _content.size());
+  ASSERT_TRUE(err == NULL) << err->getErrMsg();
+  ASSERT_TRUE(received == _content);
+  ASSERT_EQ(gets(), std::vector<std::string>({""}));
+}
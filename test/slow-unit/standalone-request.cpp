@@ -22,11 +22,15 @@
 #include <gtest/gtest.h>
 #include <backend/StandaloneNeonRequest.hpp>
 #include <neon/neonsessionfactory.hpp>
+#include <curl/CurlSessionFactory.hpp>
+#include <curl/StandaloneCurlRequest.hpp>
+#include <curl/curl.h>
 #include "../drunk-server/DrunkServer.hpp"
 #include "../drunk-server/LineReader.hpp"
 #include "../drunk-server/Interactors.hpp"
 #include "test-utils.hpp"
 #include <iostream>
+#include <thread>
 
 #define DBG(message) std::cerr << __FILE__ << ":" << __LINE__ << " -- " << #message << " = " << message << std::endl;
 
@@ -276,3 +280,279 @@ TEST_F(Standalone_Neon_Request, StopNoStart) {
   ASSERT_EQ(request->getState(), RequestState::kFinished);
   ASSERT_EQ(request->getStatusCode(), 0);
 }
+
+TEST_F(Standalone_Curl_Request, SharedEventLoop) {
+  _uri = Uri("http://localhost:22222/chickens");
+
+  SingleShotInteractor inter1(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Connection: close\r\n"                     <<
+         "Content-Length: 19\r\n"                    <<
+         "\r\n"                                      <<
+         "I like turtles too.")
+  );
+
+  SingleShotInteractor inter2(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 404 Not Found\r\n"                <<
+         "Connection: close\r\n"                     <<
+         "Content-Length: 8\r\n"                     <<
+         "\r\n"                                      <<
+         "No dice.")
+  );
+
+  _drunk_server->autoAcceptNext(&inter1);
+  _drunk_server->autoAcceptNext(&inter2);
+
+  //----------------------------------------------------------------------------
+  // Both requests are driven by the same event loop, and are in flight at
+  // the same time.
+  //----------------------------------------------------------------------------
+  std::unique_ptr<StandaloneRequest> request1 = makeStandaloneCurlReq();
+  std::unique_ptr<StandaloneRequest> request2 = makeStandaloneCurlReq();
+
+  ASSERT_TRUE(request1->startRequest().ok());
+  ASSERT_TRUE(request2->startRequest().ok());
+
+  ASSERT_EQ(request1->getStatusCode(), 200);
+  ASSERT_EQ(request2->getStatusCode(), 404);
+
+  char buffer[2048];
+  Status st;
+
+  ASSERT_EQ(request2->readBlock(buffer, 2048, st), 8);
+  ASSERT_TRUE(st.ok());
+  ASSERT_EQ(std::string(buffer, 8), "No dice.");
+  ASSERT_EQ(request2->readBlock(buffer, 2048, st), 0);
+  ASSERT_TRUE(st.ok());
+
+  ASSERT_EQ(request1->readBlock(buffer, 2048, st), 19);
+  ASSERT_TRUE(st.ok());
+  ASSERT_EQ(std::string(buffer, 19), "I like turtles too.");
+  ASSERT_EQ(request1->readBlock(buffer, 2048, st), 0);
+  ASSERT_TRUE(st.ok());
+
+  ASSERT_TRUE(request1->endRequest().ok());
+  ASSERT_TRUE(request2->endRequest().ok());
+
+  // the interactors flag success only after their writes have returned
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ASSERT_TRUE(inter1.ok());
+  ASSERT_TRUE(inter2.ok());
+}
+
+TEST_F(Standalone_Curl_Request, DirectBufferOverflow) {
+  _uri = Uri("http://localhost:22222/chickens");
+
+  //----------------------------------------------------------------------------
+  // The server sends the first byte of the body, the test feeds the rest
+  //----------------------------------------------------------------------------
+  SingleShotInteractor inter(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Content-Length: 100000000\r\n"             <<
+         "\r\n"                                      <<
+         "x")
+  );
+
+  _drunk_server->autoAcceptNext(&inter);
+
+  std::unique_ptr<StandaloneRequest> request = makeStandaloneCurlReq();
+  ASSERT_TRUE(request->startRequest().ok());
+  ASSERT_EQ(request->getStatusCode(), 200);
+  StandaloneCurlRequest *curlRequest = static_cast<StandaloneCurlRequest*>(request.get());
+
+  char byte = 0;
+  Status st;
+  ASSERT_EQ(request->readBlock(&byte, 1, st), 1);
+  ASSERT_EQ(byte, 'x');
+
+  //----------------------------------------------------------------------------
+  // A reader waits with a single byte of room
+  //----------------------------------------------------------------------------
+  dav_ssize_t readBytes = -1;
+  std::thread reader([&]() {
+    readBytes = request->readBlock(&byte, 1, st);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  //----------------------------------------------------------------------------
+  // Its buffer is filled by the first chunk, which puts the response buffer
+  // over its 32 MiB limit: whether or not the reader picked up its byte yet,
+  // the next chunk must pause the transfer.
+  //----------------------------------------------------------------------------
+  std::string chunk(40 * 1024 * 1024, 'a');
+  size_t first = curlRequest->feedResponseBody(chunk.c_str(), chunk.size());
+  size_t second = curlRequest->feedResponseBody("b", 1);
+  reader.join();
+
+  ASSERT_EQ(first, chunk.size());
+  ASSERT_EQ(second, (size_t) CURL_WRITEFUNC_PAUSE);
+  ASSERT_EQ(readBytes, 1);
+  ASSERT_EQ(byte, 'a');
+}
+
+TEST_F(Standalone_Curl_Request, ResponseBufferLimit) {
+  _uri = Uri("http://localhost:22222/chickens");
+  _params.setResponseBufferLimit(1024);
+
+  std::string body;
+  for(size_t i = 0; i < 200000; i++) {
+    body.push_back('a' + (i % 26));
+  }
+
+  SingleShotInteractor inter(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Content-Length: " << body.size() << "\r\n" <<
+         "\r\n"                                      <<
+         body)
+  );
+
+  _drunk_server->autoAcceptNext(&inter);
+
+  std::unique_ptr<StandaloneRequest> request = makeStandaloneCurlReq();
+  ASSERT_TRUE(request->startRequest().ok());
+  ASSERT_EQ(request->getStatusCode(), 200);
+
+  //----------------------------------------------------------------------------
+  // Give the transfer a chance to run ahead - it should get paused shortly
+  // after going over the limit, a single network read at most.
+  //----------------------------------------------------------------------------
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ASSERT_LE(_factory.getCurl().getBufferedBytes(), 1024u + CURL_MAX_WRITE_SIZE);
+
+  std::string received;
+  char buffer[100];
+  Status st;
+
+  while(true) {
+    dav_ssize_t bytes = request->readBlock(buffer, 100, st);
+    ASSERT_TRUE(st.ok());
+    ASSERT_GE(bytes, 0);
+
+    if(bytes == 0) break;
+    received.append(buffer, bytes);
+    ASSERT_LE(_factory.getCurl().getBufferedBytes(), 1024u + CURL_MAX_WRITE_SIZE);
+  }
+
+  ASSERT_EQ(received, body);
+  ASSERT_TRUE(request->endRequest().ok());
+  ASSERT_TRUE(inter.ok());
+  ASSERT_EQ(_factory.getCurl().getBufferedBytes(), 0u);
+}
+
+TEST_F(Standalone_Curl_Request, Http2OverPlainHttp) {
+  _uri = Uri("http://localhost:22222/chickens");
+  _params.setHttp2Support(true);
+
+  //----------------------------------------------------------------------------
+  // HTTP/2 is only negotiated over TLS, plain http stays on HTTP/1.1
+  //----------------------------------------------------------------------------
+  SingleShotInteractor inter(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Content-Length: 19\r\n"                    <<
+         "\r\n"                                      <<
+         "I like turtles too.")
+  );
+
+  _drunk_server->autoAcceptNext(&inter);
+
+  std::unique_ptr<StandaloneRequest> request = makeStandaloneCurlReq();
+  ASSERT_TRUE(request->startRequest().ok());
+  ASSERT_EQ(request->getStatusCode(), 200);
+
+  char buffer[2048];
+  Status st;
+
+  ASSERT_EQ(request->readBlock(buffer, 2048, st), 19);
+  ASSERT_TRUE(st.ok());
+  ASSERT_EQ(request->readBlock(buffer, 2048, st), 0);
+  ASSERT_TRUE(request->endRequest().ok());
+
+  // the interactor flags success only after the write has returned
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ASSERT_TRUE(inter.ok());
+
+  std::map<std::string, SessionPoolStats> stats = _factory.getSessionPoolStats();
+  ASSERT_EQ(stats["http://localhost:22222"].multiplexed, 0u);
+}
+
+TEST_F(Standalone_Curl_Request, RecycleOnlyCompletedTransfers) {
+  _uri = Uri("http://localhost:22222/chickens");
+
+  //----------------------------------------------------------------------------
+  // Request ended in the middle of the body: the handle is dropped
+  //----------------------------------------------------------------------------
+  SingleShotInteractor inter1(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Content-Length: 1000\r\n"                  <<
+         "\r\n"                                      <<
+         "I like turtles too.")
+  );
+
+  _drunk_server->autoAcceptNext(&inter1);
+
+  char buffer[2048];
+  Status st;
+
+  {
+    std::unique_ptr<StandaloneRequest> request = makeStandaloneCurlReq();
+    ASSERT_TRUE(request->startRequest().ok());
+    ASSERT_EQ(request->readBlock(buffer, 19, st), 19);
+    ASSERT_TRUE(request->endRequest().ok());
+  }
+
+  std::map<std::string, SessionPoolStats> stats = _factory.getSessionPoolStats();
+  ASSERT_EQ(stats["http://localhost:22222"].idle, 0u);
+  ASSERT_EQ(stats["http://localhost:22222"].live, 0u);
+
+  //----------------------------------------------------------------------------
+  // Complete transfer: the handle goes back to the pool
+  //----------------------------------------------------------------------------
+  SingleShotInteractor inter2(
+    SSTR("GET /chickens HTTP/1.1\r\n"  <<
+          "Host: localhost:22222\r\n"  <<
+          "Accept: */*\r\n"),
+
+    SSTR("HTTP/1.1 200 OK\r\n"                       <<
+         "Content-Length: 19\r\n"                    <<
+         "\r\n"                                      <<
+         "I like turtles too.")
+  );
+
+  _drunk_server->autoAcceptNext(&inter2);
+
+  {
+    std::unique_ptr<StandaloneRequest> request = makeStandaloneCurlReq();
+    ASSERT_TRUE(request->startRequest().ok());
+    ASSERT_EQ(request->readBlock(buffer, 2048, st), 19);
+    ASSERT_EQ(request->readBlock(buffer, 2048, st), 0);
+    ASSERT_TRUE(request->endRequest().ok());
+  }
+
+  stats = _factory.getSessionPoolStats();
+  ASSERT_EQ(stats["http://localhost:22222"].idle, 1u);
+  ASSERT_EQ(stats["http://localhost:22222"].live, 1u);
+}
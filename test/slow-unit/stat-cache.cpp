@@ -0,0 +1,153 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+
+using namespace Davix;
+
+class StatCacheTest : public DavixTestFixture {};
+
+static RequestParams makeParams() {
+  RequestParams params;
+  params.setProtocol(RequestProtocol::Http);
+  params.setOperationRetry(0);
+  params.setMetalinkMode(MetalinkMode::Disable);
+  return params;
+}
+
+TEST_F(StatCacheTest, CachedUntilDeleted) {
+  RequestLog log;
+  RecordingInteractor interactor(log, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+  _drunk_server->autoAcceptNext(&interactor);
+
+  Context context;
+  context.setStatCacheTTL(60);
+  RequestParams params = makeParams();
+
+  DavFile file(context, params, Uri("http://localhost:22222/dir/file"));
+  StatInfo info;
+  file.statInfo(&params, info);
+  file.statInfo(&params, info);
+  ASSERT_EQ(log.entries().size(), 1u);
+
+  // trailing slashes make no difference
+  DavFile dir(context, params, Uri("http://localhost:22222/dir/"));
+  dir.statInfo(&params, info);
+  DavFile(context, params, Uri("http://localhost:22222/dir")).statInfo(&params, info);
+  ASSERT_EQ(log.entries().size(), 2u);
+
+  // deleting the file drops its metadata, and its parent's
+  file.deletion(&params);
+  file.statInfo(&params, info);
+  dir.statInfo(&params, info);
+
+  std::vector<RequestLog::Entry> requests = log.entries();
+  ASSERT_EQ(requests.size(), 5u);
+  ASSERT_EQ(requests[2].requestLine.find("DELETE /dir/file "), 0u);
+  ASSERT_EQ(requests[3].requestLine.find("HEAD /dir/file "), 0u);
+  ASSERT_EQ(requests[4].requestLine.find("HEAD /dir/ "), 0u);
+}
+
+static const std::string kListing =
+  "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+  "<D:multistatus xmlns:D=\"DAV:\">"
+  "<D:response><D:href>/dir/</D:href><D:propstat><D:prop>"
+  "<D:getlastmodified>Mon, 01 Jul 2019 10:00:00 GMT</D:getlastmodified>"
+  "<D:resourcetype><D:collection/></D:resourcetype>"
+  "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>"
+  "<D:response><D:href>/dir/f1</D:href><D:propstat><D:prop>"
+  "<D:getlastmodified>Mon, 01 Jul 2019 10:00:00 GMT</D:getlastmodified>"
+  "<D:getcontentlength>100</D:getcontentlength><D:resourcetype/>"
+  "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>"
+  "<D:response><D:href>/dir/f2</D:href><D:propstat><D:prop>"
+  "<D:getlastmodified>Mon, 01 Jul 2019 10:00:00 GMT</D:getlastmodified>"
+  "<D:getcontentlength>200</D:getcontentlength><D:resourcetype/>"
+  "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>"
+  "</D:multistatus>";
+
+TEST_F(StatCacheTest, FilledByListing) {
+  RequestLog log;
+  RecordingInteractor interactor(log, "HTTP/1.1 207 Multi-Status\r\nContent-Type: text/xml\r\nContent-Length: " +
+                                      std::to_string(kListing.size()) + "\r\n\r\n" + kListing);
+  _drunk_server->autoAcceptNext(&interactor);
+
+  Context context;
+  context.setStatCacheTTL(60);
+  RequestParams params = makeParams();
+
+  DavFile dir(context, params, Uri("http://localhost:22222/dir/"));
+  std::vector<std::string> names;
+  DavFile::Iterator it = dir.listCollection(&params);
+  do {
+    names.push_back(it.name());
+  } while(it.next());
+  ASSERT_EQ(names.size(), 2u);
+  ASSERT_EQ(log.entries().size(), 1u);
+
+  StatInfo info;
+  DavFile(context, params, Uri("http://localhost:22222/dir/f1")).statInfo(&params, info);
+  ASSERT_EQ(info.size, 100u);
+  DavFile(context, params, Uri("http://localhost:22222/dir/f2")).statInfo(&params, info);
+  ASSERT_EQ(info.size, 200u);
+
+  std::vector<RequestLog::Entry> requests = log.entries();
+  ASSERT_EQ(requests.size(), 1u);
+  ASSERT_EQ(requests[0].requestLine.find("PROPFIND /dir/ "), 0u);
+}
+
+TEST_F(StatCacheTest, NegativeCaching) {
+  RequestLog log;
+  RecordingInteractor interactor(log, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+  _drunk_server->autoAcceptNext(&interactor);
+
+  Context context;
+  RequestParams params = makeParams();
+  DavFile file(context, params, Uri("http://localhost:22222/missing"));
+  StatInfo info;
+
+  // not found answers are only cached when asked for
+  context.setStatCacheTTL(60);
+  for(size_t i = 0; i < 2; i++) {
+    try {
+      file.statInfo(&params, info);
+      FAIL();
+    }
+    catch(DavixException &e) {
+      ASSERT_EQ(e.code(), StatusCode::FileNotFound);
+    }
+  }
+  ASSERT_EQ(log.entries().size(), 2u);
+
+  context.setStatCacheTTL(60, 60);
+  for(size_t i = 0; i < 2; i++) {
+    try {
+      file.statInfo(&params, info);
+      FAIL();
+    }
+    catch(DavixException &e) {
+      ASSERT_EQ(e.code(), StatusCode::FileNotFound);
+    }
+  }
+  ASSERT_EQ(log.entries().size(), 3u);
+}
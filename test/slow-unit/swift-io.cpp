@@ -0,0 +1,112 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+
+using namespace Davix;
+
+class SwiftIOTest : public DavixTestFixture {};
+
+TEST_F(SwiftIOTest, ConcurrentSegmentUpload) {
+  RequestLog log;
+  std::vector<std::unique_ptr<RecordingInteractor> > interactors;
+
+  // PUT connections are not reused: one per request
+  for(size_t i = 0; i < 9; i++) {
+    interactors.emplace_back(new RecordingInteractor(log, "HTTP/1.1 201 Created\r\nEtag: abc\r\nContent-Length: 0\r\n\r\n"));
+    _drunk_server->autoAcceptNext(interactors.back().get());
+  }
+
+  std::string content;
+  for(size_t i = 0; i < 7200; i++) {
+    content.push_back('a' + (i * 7) % 26);
+  }
+
+  {
+    Context context;
+    RequestParams params;
+    params.setProtocol(RequestProtocol::Swift);
+    params.setOperationRetry(0);
+    params.setUploadThreshold(5000);
+    params.setUploadChunkSize(1000);
+    params.setUploadStreams(4);
+
+    DavFile file(context, params, Uri("http://localhost:22222/container/object"));
+    file.put(&params, content.c_str(), content.size());
+  }
+
+  std::vector<RequestLog::Entry> requests = log.entries();
+  ASSERT_EQ(requests.size(), 9u);
+
+  // segments may arrive in any order
+  std::map<std::string, std::string> segments;
+  for(size_t i = 0; i < 8; i++) {
+    const std::string &line = requests[i].requestLine;
+    ASSERT_EQ(line.find("PUT /container/object/"), 0u);
+    segments[line.substr(4, line.find(' ', 4) - 4)] = requests[i].body;
+  }
+  ASSERT_EQ(segments.size(), 8u);
+
+  // but the manifest, sent last, has them in order
+  const RequestLog::Entry &manifest = requests[8];
+  ASSERT_EQ(manifest.requestLine, "PUT /container/object?multipart-manifest=put HTTP/1.1\r\n");
+
+  std::string reassembled;
+  size_t pos = 0, count = 0;
+  while((pos = manifest.body.find("\"path\":\"", pos)) != std::string::npos) {
+    pos += 8;
+    const std::string path = manifest.body.substr(pos, manifest.body.find('"', pos) - pos);
+    ASSERT_EQ(path, "/container/object/" + std::to_string(count + 1));
+    ASSERT_EQ(segments.count(path), 1u);
+    ASSERT_EQ(segments[path].size(), count < 7 ? 1000u : 200u);
+
+    reassembled += segments[path];
+    count++;
+  }
+
+  ASSERT_EQ(count, 8u);
+  ASSERT_EQ(reassembled, content);
+}
+
+TEST_F(SwiftIOTest, BelowThreshold) {
+  RequestLog log;
+  RecordingInteractor interactor(log, "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n");
+  _drunk_server->autoAcceptNext(&interactor);
+
+  {
+    Context context;
+    RequestParams params;
+    params.setProtocol(RequestProtocol::Swift);
+    params.setOperationRetry(0);
+    params.setUploadThreshold(5000);
+
+    DavFile file(context, params, Uri("http://localhost:22222/container/object"));
+    file.put(&params, "small object", 12);
+  }
+
+  std::vector<RequestLog::Entry> requests = log.entries();
+  ASSERT_EQ(requests.size(), 1u);
+  ASSERT_EQ(requests[0].requestLine, "PUT /container/object HTTP/1.1\r\n");
+  ASSERT_EQ(requests[0].body, "small object");
+}
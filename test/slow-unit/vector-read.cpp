@@ -0,0 +1,123 @@
+/*
+ * This File is part of Davix, The IO library for HTTP based protocols
+ * Copyright (C) CERN 2019
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+*/
+
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include "../drunk-server/DrunkServer.hpp"
+#include "../drunk-server/Interactors.hpp"
+#include "test-utils.hpp"
+
+using namespace Davix;
+
+class VectorReadTest : public DavixTestFixture {
+public:
+  VectorReadTest() : _content(makeContent(6 << 20)), _file(_content) {
+    for(size_t i = 0; i < 16; i++) {
+      _interactors.emplace_back(new FileInteractor(_log, _file));
+      _drunk_server->autoAcceptNext(_interactors.back().get());
+    }
+
+    _params.setProtocol(RequestProtocol::Http);
+    _params.setOperationRetry(0);
+    _params.setMetalinkMode(MetalinkMode::Disable);
+    _params.setMergeWindow(0);
+  }
+
+  // no period, so that reading from the wrong offset shows
+  static std::string makeContent(size_t size) {
+    std::string content(size, '\0');
+    uint32_t state = 1;
+    for(size_t i = 0; i < size; i++) {
+      state = state * 1103515245 + 12345;
+      content[i] = static_cast<char>(state >> 16);
+    }
+    return content;
+  }
+
+  // read count ranges of size bytes, every stride bytes, and check what came back
+  void readVec(size_t count, dav_size_t size, dav_off_t stride) {
+    std::vector<std::string> buffers(count, std::string(size, '\0'));
+    std::vector<DavIOVecInput> input(count);
+    std::vector<DavIOVecOuput> output(count);
+    for(size_t i = 0; i < count; i++) {
+      input[i].diov_buffer = &buffers[i][0];
+      input[i].diov_offset = i * stride + 7;
+      input[i].diov_size = size;
+    }
+
+    DavFile file(_context, _params, Uri("http://localhost:22222/file"));
+    DavixError *err = NULL;
+    ASSERT_EQ(file.readPartialBufferVec(&_params, input.data(), output.data(), count, &err), (dav_ssize_t) (count * size));
+    ASSERT_TRUE(err == NULL) << err->getErrMsg();
+
+    for(size_t i = 0; i < count; i++) {
+      ASSERT_EQ(output[i].diov_size, (dav_ssize_t) size) << "range " << i;
+      ASSERT_TRUE(buffers[i] == _content.substr(input[i].diov_offset, size)) << "range " << i;
+    }
+  }
+
+  // GET requests received so far, as their Range header
+  std::vector<std::string> gets() {
+    std::vector<std::string> out;
+    for(const RequestLog::Entry &entry : _log.entries()) {
+      if(entry.requestLine.compare(0, 4, "GET ") == 0) {
+        out.push_back(entry.range);
+      }
+    }
+    return out;
+  }
+
+protected:
+  RequestLog _log;
+  std::string _content;
+  ServedFile _file;
+  std::vector<std::unique_ptr<FileInteractor> > _interactors;
+  Context _context;
+};
+
+TEST_F(VectorReadTest, Batches) {
+  // too many ranges for one Range header: several multi-range requests
+  ASSERT_NO_FATAL_FAILURE(readVec(600, 100, 10000));
+
+  std::vector<std::string> ranges = gets();
+  ASSERT_GT(ranges.size(), 1u);
+  for(const std::string &range : ranges) {
+    ASSERT_NE(range.find(','), std::string::npos);
+    ASSERT_LT(range.size(), 3920u);
+  }
+}
+
+TEST_F(VectorReadTest, LaterBatchWholeFile) {
+  // the first batch goes through, a later one gets the whole file: start
+  // over with single-range requests
+  _file.ignoreMultirangeFrom(2000000);
+  ASSERT_NO_FATAL_FAILURE(readVec(600, 100, 10000));
+
+  std::vector<std::string> ranges = gets();
+  ASSERT_NE(ranges[0].find(','), std::string::npos);
+
+  size_t single = 0;
+  for(const std::string &range : ranges) {
+    if(range.find(',') == std::string::npos) {
+      single++;
+    }
+  }
+  ASSERT_EQ(single, 600u);
+}
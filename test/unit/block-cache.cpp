@@ -0,0 +1,259 @@
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include <core/BlockCache.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace Davix;
+
+static BlockCache::Block makeBlock(size_t size, char c) {
+  return std::make_shared<const std::vector<char> >(size, c);
+}
+
+TEST(BlockCache, HitAndMiss) {
+  BlockCache cache(1000);
+  int fetches = 0;
+
+  auto fetcher = [&fetches]() { fetches++; return makeBlock(100, 'a'); };
+
+  const std::string key = BlockCache::makeKey("http://example.org/file", "etag", 3);
+  ASSERT_EQ(cache.get(key, fetcher)->size(), 100u);
+  ASSERT_EQ(cache.get(key, fetcher)->at(0), 'a');
+
+  ASSERT_EQ(fetches, 1);
+  ASSERT_EQ(cache.misses(), 1u);
+  ASSERT_EQ(cache.hits(), 1u);
+  ASSERT_EQ(cache.size(), 100u);
+
+  // NULL blocks are not cached
+  const std::string other = BlockCache::makeKey("http://example.org/file", "etag", 4);
+  ASSERT_FALSE(cache.get(other, []() { return BlockCache::Block(); }));
+  ASSERT_FALSE(cache.get(other, []() { return BlockCache::Block(); }));
+  ASSERT_EQ(cache.misses(), 3u);
+}
+
+TEST(BlockCache, LRUEviction) {
+  BlockCache cache(300);
+
+  cache.insert("a", makeBlock(100, 'a'));
+  cache.insert("b", makeBlock(100, 'b'));
+  cache.insert("c", makeBlock(100, 'c'));
+  ASSERT_EQ(cache.size(), 300u);
+
+  // touch a, so that b is the least recently used
+  int fetches = 0;
+  auto fetcher = [&fetches]() { fetches++; return makeBlock(100, 'x'); };
+  ASSERT_EQ(cache.get("a", fetcher)->at(0), 'a');
+
+  cache.insert("d", makeBlock(100, 'd'));
+  ASSERT_EQ(cache.size(), 300u);
+
+  ASSERT_EQ(cache.get("a", fetcher)->at(0), 'a');
+  ASSERT_EQ(cache.get("c", fetcher)->at(0), 'c');
+  ASSERT_EQ(cache.get("d", fetcher)->at(0), 'd');
+  ASSERT_EQ(fetches, 0);
+  ASSERT_EQ(cache.get("b", fetcher)->at(0), 'x');
+  ASSERT_EQ(fetches, 1);
+
+  // blocks larger than the cache are never kept
+  cache.insert("huge", makeBlock(301, 'h'));
+  ASSERT_EQ(cache.size(), 300u);
+
+  cache.setCapacity(100);
+  ASSERT_EQ(cache.size(), 100u);
+
+  cache.setCapacity(0);
+  ASSERT_EQ(cache.size(), 0u);
+}
+
+TEST(BlockCache, SingleFlight) {
+  BlockCache cache(1 << 20);
+  std::atomic<int> fetches(0);
+
+  auto fetcher = [&fetches]() {
+    fetches++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return makeBlock(1000, 'z');
+  };
+
+  std::vector<std::thread> threads;
+  std::atomic<int> ok(0);
+  for(int i = 0; i < 8; i++) {
+    threads.emplace_back([&]() {
+      BlockCache::Block block = cache.get("key", fetcher);
+      if(block && block->size() == 1000) {
+        ok++;
+      }
+    });
+  }
+
+  for(auto &t : threads) {
+    t.join();
+  }
+
+  ASSERT_EQ(fetches, 1);
+  ASSERT_EQ(ok, 8);
+  ASSERT_EQ(cache.misses(), 1u);
+  ASSERT_EQ(cache.hits() + cache.waits(), 7u);
+}
+
+TEST(BlockCache, FetchFailure) {
+  BlockCache cache(1 << 20);
+  std::atomic<int> fetches(0);
+
+  auto failing = [&fetches]() -> BlockCache::Block {
+    fetches++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    throw DavixException(davix_scope_io_buff(), StatusCode::ConnectionProblem, "nope");
+  };
+
+  std::vector<std::thread> threads;
+  std::atomic<int> failed(0);
+  for(int i = 0; i < 4; i++) {
+    threads.emplace_back([&]() {
+      try {
+        cache.get("key", failing);
+      }
+      catch(DavixException &e) {
+        if(e.code() == StatusCode::ConnectionProblem) {
+          failed++;
+        }
+      }
+    });
+  }
+
+  for(auto &t : threads) {
+    t.join();
+  }
+
+  // waiters got the error of the fetch in progress, if any; nothing was cached
+  ASSERT_EQ(failed, 4);
+  ASSERT_LE(fetches, 4);
+  ASSERT_EQ(cache.size(), 0u);
+
+  ASSERT_EQ(cache.get("key", []() { return makeBlock(10, 'k'); })->size(), 10u);
+}
+
+TEST(BlockCache, Validators) {
+  BlockCache cache(1 << 20);
+  const std::string url = "http://example.org/file";
+  const std::string otherUrl = "http://example.org/file2";
+
+  ASSERT_EQ(cache.getValidator(url), "");
+
+  cache.setValidator(url, "v1");
+  cache.insert(BlockCache::makeKey(url, "v1", 0), makeBlock(10, 'a'));
+  cache.insert(BlockCache::makeKey(url, "v1", 1), makeBlock(10, 'b'));
+  cache.insert(BlockCache::makeKey(otherUrl, "v1", 0), makeBlock(10, 'c'));
+  ASSERT_EQ(cache.size(), 30u);
+
+  // same validator: nothing changes
+  cache.setValidator(url, "v1");
+  ASSERT_EQ(cache.size(), 30u);
+
+  // file changed: its blocks go, the others stay
+  cache.setValidator(url, "v2");
+  ASSERT_EQ(cache.getValidator(url), "v2");
+  ASSERT_EQ(cache.size(), 10u);
+
+  cache.invalidate(otherUrl);
+  ASSERT_EQ(cache.size(), 0u);
+  ASSERT_EQ(cache.getValidator(otherUrl), "");
+
+  cache.insert(BlockCache::makeKey(url, "v2", 0), makeBlock(10, 'a'));
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0u);
+  ASSERT_EQ(cache.getValidator(url), "");
+}
+
+TEST(BlockCache, Revalidation) {
+  BlockCache cache(1 << 20);
+  const std::string url = "http://example.org/file";
+
+  ASSERT_FALSE(cache.isValidated(url, std::chrono::seconds(60)));
+
+  cache.setValidator(url, "v1");
+  cache.insert(BlockCache::makeKey(url, "v1", 0), makeBlock(10, 'a'));
+  ASSERT_TRUE(cache.isValidated(url, std::chrono::seconds(60)));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_FALSE(cache.isValidated(url, std::chrono::seconds(0)));
+
+  // checked again and unchanged: the blocks stay
+  cache.setValidator(url, "v1");
+  ASSERT_TRUE(cache.isValidated(url, std::chrono::seconds(60)));
+  ASSERT_EQ(cache.size(), 10u);
+
+  // no validator, no way to tell: the blocks go
+  cache.setValidator(url, "");
+  ASSERT_EQ(cache.size(), 0u);
+  ASSERT_TRUE(cache.isValidated(url, std::chrono::seconds(60)));
+
+  cache.invalidate(url);
+  ASSERT_FALSE(cache.isValidated(url, std::chrono::seconds(60)));
+}
+
+TEST(BlockCache, Drop) {
+  BlockCache cache(1 << 20);
+  const std::string key = BlockCache::makeKey("http://example.org/file", "v1", 0);
+
+  cache.insert(key, makeBlock(10, 'a'));
+  cache.drop(key);
+  ASSERT_EQ(cache.size(), 0u);
+
+  // fetched again on the next get
+  size_t fetches = 0;
+  cache.get(key, [&]() { fetches++; return makeBlock(10, 'b'); });
+  ASSERT_EQ(fetches, 1u);
+  ASSERT_EQ((*cache.get(key, [&]() { fetches++; return makeBlock(10, 'c'); }))[0], 'b');
+  ASSERT_EQ(fetches, 1u);
+}
+
+TEST(BlockCache, ContextLimit) {
+  Context context;
+  ASSERT_EQ(context.getBlockCacheLimit(), 0u);
+
+  context.setBlockCacheLimit(1 << 20);
+  ASSERT_EQ(context.getBlockCacheLimit(), 1u << 20);
+
+  Context copy(context);
+  ASSERT_EQ(copy.getBlockCacheLimit(), 1u << 20);
+}
+
+TEST(BlockCache, BoundedValidators) {
+  BlockCache cache(1 << 20);
+  const std::string url("http://example.org/file");
+
+  cache.setValidator(url, "v1");
+  cache.insert(BlockCache::makeKey(url, "v1", 0), makeBlock(10, 'a'));
+
+  // the validator in use stays, only the least recently used ones go
+  for(size_t i = 0; i < 5000; i++) {
+    cache.setValidator("http://example.org/other" + std::to_string(i), "v");
+    if(i % 1000 == 0) {
+      ASSERT_EQ(cache.getValidator(url), "v1");
+    }
+  }
+
+  ASSERT_EQ(cache.getValidator(url), "v1");
+  ASSERT_EQ(cache.getValidator("http://example.org/other0"), "");
+  ASSERT_EQ(cache.getValidator("http://example.org/other4999"), "v");
+  ASSERT_EQ(cache.size(), 10u);
+}
+
+TEST(BlockCache, Rangeless) {
+  BlockCache cache(1 << 20);
+  const std::string url("http://example.org/file");
+
+  cache.insert(BlockCache::makeKey(url, "", 0), makeBlock(10, 'a'));
+  ASSERT_FALSE(cache.isRangeless(url));
+
+  cache.setRangeless(url);
+  ASSERT_TRUE(cache.isRangeless(url));
+  ASSERT_FALSE(cache.isRangeless("http://example.org/other"));
+  ASSERT_EQ(cache.size(), 0u);
+
+  cache.clear();
+  ASSERT_FALSE(cache.isRangeless(url));
+}
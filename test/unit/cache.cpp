@@ -3,6 +3,8 @@
 #include <string>
 #include <cstring>
 #include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
 
 
 
@@ -10,6 +12,7 @@
 #define A_LIB_NAMESPACE Davix
 
 #include "libs/alibxx/alibxx.hpp"
+#include <core/RedirectionResolver.hpp>
 
 using namespace std;
 
@@ -58,3 +61,188 @@ TEST(ALibxx, CacheTest){
     cache.clear();
     ASSERT_EQ(0, cache.getSize());
 }
+
+static std::shared_ptr<DummyStruct> makeDummy(const std::string & dude){
+    std::shared_ptr<DummyStruct> dumb( new DummyStruct());
+    dumb->dude = dude;
+    return dumb;
+}
+
+TEST(ALibxx, CacheLRU){
+    Davix::Cache<std::string, DummyStruct> cache(3);
+
+    cache.insert("a", makeDummy("a"));
+    cache.insert("b", makeDummy("b"));
+    cache.insert("c", makeDummy("c"));
+
+    // "a" becomes the most recently used, "b" is evicted
+    ASSERT_STREQ("a", cache.find("a")->dude.c_str());
+    cache.insert("d", makeDummy("d"));
+
+    ASSERT_EQ(3, cache.getSize());
+    ASSERT_TRUE(cache.find("b").get() == NULL);
+    ASSERT_TRUE(cache.find("a").get() != NULL);
+    ASSERT_TRUE(cache.find("c").get() != NULL);
+    ASSERT_TRUE(cache.find("d").get() != NULL);
+
+    ASSERT_EQ(4u, cache.hits());
+    ASSERT_EQ(1u, cache.misses());
+    ASSERT_EQ(1u, cache.evictions());
+
+    // replacing an entry evicts nothing
+    cache.insert("c", makeDummy("c2"));
+    ASSERT_STREQ("c2", cache.find("c")->dude.c_str());
+    ASSERT_EQ(1u, cache.evictions());
+
+    // shrinking evicts the least recently used
+    cache.setMaxSize(1);
+    ASSERT_EQ(1u, cache.getMaxSize());
+    ASSERT_EQ(1, cache.getSize());
+    ASSERT_TRUE(cache.find("c").get() != NULL);
+    ASSERT_EQ(3u, cache.evictions());
+}
+
+TEST(ALibxx, CacheTTL){
+    Davix::Cache<std::string, DummyStruct> cache(100, std::chrono::milliseconds(200));
+
+    cache.insert("short", makeDummy("short"));
+    cache.insert("long", makeDummy("long"), std::chrono::seconds(60));
+    cache.insert("forever", makeDummy("forever"), std::chrono::seconds(0));
+
+    ASSERT_TRUE(cache.find("short").get() != NULL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    ASSERT_TRUE(cache.find("short").get() == NULL);
+    ASSERT_TRUE(cache.find("long").get() != NULL);
+    ASSERT_TRUE(cache.find("forever").get() != NULL);
+
+    // expired entries are dropped
+    ASSERT_EQ(2, cache.getSize());
+    ASSERT_EQ(1u, cache.evictions());
+    ASSERT_FALSE(cache.erase("short"));
+}
+
+TEST(ALibxx, CacheShards){
+    Davix::Cache<std::string, DummyStruct> cache(1000, Davix::Cache<std::string, DummyStruct>::Duration::zero(), 8);
+
+    for(int i = 0; i < 500; i++){
+        cache.insert("key" + std::to_string(1000 + i), makeDummy(std::to_string(i)));
+    }
+    ASSERT_EQ(500, cache.getSize());
+
+    // keys stay ordered across shards
+    std::string key = "key";
+    for(int i = 0; i < 500; i++){
+        key = cache.upper_bound(key);
+        ASSERT_EQ("key" + std::to_string(1000 + i), key);
+    }
+    ASSERT_EQ("", cache.upper_bound(key));
+
+    // the size limit holds, spread over shards
+    for(int i = 500; i < 5000; i++){
+        cache.insert("key" + std::to_string(1000 + i), makeDummy(std::to_string(i)));
+    }
+    ASSERT_LE(cache.getSize(), 1000u);
+    ASSERT_GT(cache.getSize(), 500u);
+    ASSERT_TRUE(cache.find("key5999").get() != NULL);
+}
+
+TEST(ALibxx, CacheForEach){
+    Davix::Cache<std::string, DummyStruct> cache(100, Davix::Cache<std::string, DummyStruct>::Duration::zero(), 4);
+
+    for(int i = 0; i < 10; i++){
+        cache.insert("key" + std::to_string(i), makeDummy(std::to_string(i)));
+    }
+    cache.insert("short", makeDummy("short"), std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // expired entries are skipped and dropped
+    std::map<std::string, std::string> seen;
+    cache.forEach([&](const std::string & key, const std::shared_ptr<DummyStruct> & value){
+        seen[key] = value->dude;
+    });
+    ASSERT_EQ(10u, seen.size());
+    ASSERT_EQ("3", seen["key3"]);
+    ASSERT_EQ(10, cache.getSize());
+}
+
+TEST(RedirectionResolver, ResolveAndClean){
+    Davix::RedirectionResolver resolver(true, 100);
+    Davix::Uri origin("http://redirector.example.org/file");
+
+    resolver.addRedirection("GET", origin, std::make_shared<Davix::Uri>("http://disk1.example.org/file"));
+    resolver.addRedirection("GET", Davix::Uri("http://disk1.example.org/file"), std::make_shared<Davix::Uri>("http://disk2.example.org/file"));
+    resolver.addRedirection("PUT", origin, std::make_shared<Davix::Uri>("http://disk3.example.org/file"));
+
+    // HEAD shares the redirections of GET, chains are followed
+    ASSERT_EQ("http://disk2.example.org/file", resolver.redirectionResolve("HEAD", origin)->getString());
+    ASSERT_EQ("http://disk3.example.org/file", resolver.redirectionResolve("PUT", origin)->getString());
+
+    // every method of the origin is dropped, along with the chain
+    resolver.redirectionClean(origin);
+    ASSERT_TRUE(resolver.redirectionResolve("GET", origin).get() == NULL);
+    ASSERT_TRUE(resolver.redirectionResolve("PUT", origin).get() == NULL);
+    ASSERT_TRUE(resolver.redirectionResolve("GET", Davix::Uri("http://disk1.example.org/file")).get() == NULL);
+
+    ASSERT_EQ(100u, resolver.getCacheSize());
+    ASSERT_GT(resolver.hits(), 0u);
+    ASSERT_GT(resolver.misses(), 0u);
+}
+
+TEST(RedirectionResolver, Prediction){
+    Davix::RedirectionResolver resolver(true, 100);
+
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run1/file1"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org:1094/data/run1/file1"));
+
+    // same directory
+    std::shared_ptr<Davix::Uri> predicted = resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run1/file2?x=y"));
+    ASSERT_TRUE(predicted.get() != NULL);
+    ASSERT_EQ("http://disk1.example.org:1094/data/run1/file2?x=y", predicted->getString());
+    ASSERT_TRUE(resolver.redirectionPredict("HEAD", Davix::Uri("http://head.example.org/data/run1/file3")).get() != NULL);
+
+    // other directories, servers and methods
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run2/file2")).get() == NULL);
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org:8443/data/run1/file2")).get() == NULL);
+    ASSERT_TRUE(resolver.redirectionPredict("PUT", Davix::Uri("http://head.example.org/data/run1/file2")).get() == NULL);
+
+    // redirections which change the path are not predictable
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run2/file1"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org/pool/run2/file1"));
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run2/file2")).get() == NULL);
+
+    // nor those adding or changing a query or a fragment: tokens are only
+    // good for the file they were issued for
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run3/file1"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org/data/run3/file1?token=a"));
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run3/file2?x=y"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org/data/run3/file2?x=z"));
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run3/file3"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org/data/run3/file3#token=a"));
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run3/file4")).get() == NULL);
+
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run3/file5?x=y"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org/data/run3/file5?x=y"));
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run3/file4")).get() != NULL);
+
+    // another server for the directory replaces the previous one
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run3/file6"),
+                            std::make_shared<Davix::Uri>("http://disk2.example.org/data/run3/file6"));
+    ASSERT_EQ("http://disk2.example.org/data/run3/file4",
+              resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run3/file4"))->getString());
+
+    // once the origin answered a request predicted to be redirected itself, the
+    // directory is left alone
+    resolver.predictionFailed(Davix::Uri("http://head.example.org/data/run1/file2"));
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run1/file3")).get() == NULL);
+
+    resolver.addRedirection("GET", Davix::Uri("http://head.example.org/data/run1/file4"),
+                            std::make_shared<Davix::Uri>("http://disk2.example.org/data/run1/file4"));
+    ASSERT_TRUE(resolver.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run1/file5")).get() == NULL);
+
+    // nothing is predicted when inactive
+    Davix::RedirectionResolver inactive(false, 100);
+    inactive.addRedirection("GET", Davix::Uri("http://head.example.org/data/run1/file1"),
+                            std::make_shared<Davix::Uri>("http://disk1.example.org/data/run1/file1"));
+    ASSERT_TRUE(inactive.redirectionPredict("GET", Davix::Uri("http://head.example.org/data/run1/file2")).get() == NULL);
+}
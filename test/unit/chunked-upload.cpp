@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include <core/ContentProvider.hpp>
+#include <fileops/ChunkedUpload.hpp>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace Davix;
+
+static std::string makeContent(size_t size) {
+  std::string content(size, '\0');
+  for(size_t i = 0; i < size; i++) {
+    content[i] = 'a' + (i % 26);
+  }
+  return content;
+}
+
+TEST(ChunkedUpload, OrderAndSizes) {
+  Context context;
+  RequestParams params;
+  params.setUploadStreams(3);
+  Uri uri("http://example.org/file");
+  IOChainContext iocontext(context, uri, &params);
+
+  const std::string content = makeContent(1050);
+  BufferContentProvider provider(content.c_str(), content.size());
+
+  std::mutex mtx;
+  std::map<size_t, std::string> received;
+
+  std::vector<UploadedChunk> chunks = uploadChunks(iocontext, provider, 100,
+    [&](const char *buffer, dav_size_t size, size_t index) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10 - index % 10));
+      std::lock_guard<std::mutex> lock(mtx);
+      received[index] = std::string(buffer, size);
+      return "tag-" + std::to_string(index);
+    });
+
+  ASSERT_EQ(chunks.size(), 11u);
+  ASSERT_EQ(received.size(), 11u);
+
+  std::string reassembled;
+  for(size_t i = 0; i < chunks.size(); i++) {
+    ASSERT_EQ(chunks[i].tag, "tag-" + std::to_string(i));
+    ASSERT_EQ(chunks[i].size, i < 10 ? 100u : 50u);
+    reassembled += received[i];
+  }
+
+  ASSERT_EQ(reassembled, content);
+}
+
+TEST(ChunkedUpload, BoundedConcurrency) {
+  Context context;
+  RequestParams params;
+  params.setUploadStreams(8);
+  params.setUploadBufferLimit(300);
+  Uri uri("http://example.org/file");
+  IOChainContext iocontext(context, uri, &params);
+
+  const std::string content = makeContent(2000);
+  BufferContentProvider provider(content.c_str(), content.size());
+
+  std::atomic<int> inFlight(0);
+  std::atomic<int> maxInFlight(0);
+
+  std::vector<UploadedChunk> chunks = uploadChunks(iocontext, provider, 100,
+    [&](const char *, dav_size_t, size_t) {
+      int now = ++inFlight;
+      int seen = maxInFlight;
+      while(now > seen && !maxInFlight.compare_exchange_weak(seen, now)) {}
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      inFlight--;
+      return std::string("tag");
+    });
+
+  ASSERT_EQ(chunks.size(), 20u);
+  // three chunks of 100 bytes fit in the buffer limit
+  ASSERT_LE(maxInFlight, 3);
+}
+
+TEST(ChunkedUpload, Retry) {
+  Context context;
+  RequestParams params;
+  params.setUploadStreams(2);
+  params.setOperationRetry(3);
+  params.setOperationRetryDelay(0);
+  Uri uri("http://example.org/file");
+  IOChainContext iocontext(context, uri, &params);
+
+  const std::string content = makeContent(500);
+  BufferContentProvider provider(content.c_str(), content.size());
+
+  std::mutex mtx;
+  std::map<size_t, int> attempts;
+
+  std::vector<UploadedChunk> chunks = uploadChunks(iocontext, provider, 100,
+    [&](const char *, dav_size_t, size_t index) {
+      std::lock_guard<std::mutex> lock(mtx);
+      if(++attempts[index] == 1 && index == 2) {
+        throw DavixException(davix_scope_io_buff(), StatusCode::ConnectionProblem, "connection reset");
+      }
+      return std::to_string(index);
+    });
+
+  ASSERT_EQ(chunks.size(), 5u);
+  ASSERT_EQ(chunks[2].tag, "2");
+  ASSERT_EQ(attempts[2], 2);
+  ASSERT_EQ(attempts[3], 1);
+}
+
+TEST(ChunkedUpload, Failure) {
+  Context context;
+  RequestParams params;
+  params.setUploadStreams(2);
+  params.setOperationRetry(2);
+  params.setOperationRetryDelay(0);
+  Uri uri("http://example.org/file");
+  IOChainContext iocontext(context, uri, &params);
+
+  const std::string content = makeContent(5000);
+  BufferContentProvider provider(content.c_str(), content.size());
+
+  std::atomic<int> calls(0);
+
+  try {
+    uploadChunks(iocontext, provider, 100, [&](const char *, dav_size_t, size_t index) -> std::string {
+      calls++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      if(index == 3) {
+        throw DavixException(davix_scope_io_buff(), StatusCode::ConnectionProblem, "connection reset");
+      }
+      return "tag";
+    });
+    FAIL();
+  }
+  catch(DavixException &e) {
+    ASSERT_EQ(e.code(), StatusCode::ConnectionProblem);
+  }
+
+  // the upload stopped early, instead of going through the 50 chunks
+  ASSERT_LT(calls, 20);
+
+  // no retry on permission errors
+  calls = 0;
+  provider.rewind();
+  try {
+    uploadChunks(iocontext, provider, 100, [&](const char *, dav_size_t, size_t) -> std::string {
+      calls++;
+      throw DavixException(davix_scope_io_buff(), StatusCode::PermissionRefused, "denied");
+    });
+    FAIL();
+  }
+  catch(DavixException &e) {
+    ASSERT_EQ(e.code(), StatusCode::PermissionRefused);
+  }
+
+  ASSERT_LE(calls, 2);
+}
+
+TEST(ChunkedUpload, EmptyContent) {
+  Context context;
+  RequestParams params;
+  Uri uri("http://example.org/file");
+  IOChainContext iocontext(context, uri, &params);
+
+  BufferContentProvider provider("", 0);
+
+  std::vector<UploadedChunk> chunks = uploadChunks(iocontext, provider, 100,
+    [&](const char *, dav_size_t size, size_t) {
+      return std::to_string(size);
+    });
+
+  ASSERT_EQ(chunks.size(), 1u);
+  ASSERT_EQ(chunks[0].tag, "0");
+  ASSERT_EQ(chunks[0].size, 0u);
+}
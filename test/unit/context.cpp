@@ -103,6 +103,24 @@ TEST(RequestParametersTest, CreateDeleteDyn){
     delete p3;
  }
 
+TEST(RequestParametersTest, ResponseBlockSize){
+    Davix::RequestParams params;
+    ASSERT_EQ(params.getResponseBlockSize(), 16384u);
+    ASSERT_EQ(params.getMaxResponseBlockSize(), 1048576u);
+
+    params.setResponseBlockSize(65536, 4194304);
+    Davix::RequestParams copy(params);
+    ASSERT_EQ(copy.getResponseBlockSize(), 65536u);
+    ASSERT_EQ(copy.getMaxResponseBlockSize(), 4194304u);
+
+    // at least 1 KiB, and the largest block at least as large as the first
+    params.setResponseBlockSize(0, 0);
+    ASSERT_EQ(params.getResponseBlockSize(), 1024u);
+    ASSERT_EQ(params.getMaxResponseBlockSize(), 1024u);
+
+    params.setResponseBlockSize(65536, 4096);
+    ASSERT_EQ(params.getMaxResponseBlockSize(), 65536u);
+}
 
 TEST(DavixErrorTest, CreateDelete){
     Davix::DavixError err("test_dav_scope", Davix::StatusCode::IsNotADirectory, " problem");
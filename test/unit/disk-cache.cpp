@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include <core/DiskCache.hpp>
+#include <cstdlib>
+#include <dirent.h>
+#include <thread>
+
+using namespace Davix;
+
+static const dav_size_t kBlock = DAVIX_DISK_CACHE_BLOCK_SIZE;
+
+class DiskCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/davix-disk-cache-XXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+    _dir = tmpl;
+  }
+
+  void TearDown() override {
+    DIR *dir = opendir(_dir.c_str());
+    struct dirent *ent;
+    while(dir && (ent = readdir(dir)) != NULL) {
+      unlink((_dir + "/" + ent->d_name).c_str());
+    }
+    if(dir) closedir(dir);
+    rmdir(_dir.c_str());
+  }
+
+  std::string _dir;
+};
+
+TEST_F(DiskCacheTest, Disabled) {
+  DiskCache cache;
+  ASSERT_FALSE(cache.enabled());
+  ASSERT_FALSE(cache.open("http://example.org/file", "10:20", 100));
+}
+
+TEST_F(DiskCacheTest, Blocks) {
+  const std::string url = "http://example.org/file";
+  const dav_size_t size = 2 * kBlock + 10;
+  std::vector<char> data(size);
+  for(size_t i = 0; i < size; i++) {
+    data[i] = static_cast<char>(i * 7);
+  }
+
+  {
+    DiskCache cache;
+    cache.configure(_dir, 0);
+    std::shared_ptr<DiskCache::Entry> entry = cache.open(url, "v1", size);
+    ASSERT_TRUE(entry.get() != NULL);
+    ASSERT_EQ(entry->fileSize(), size);
+
+    ASSERT_EQ(entry->missingBlocks(0, 2), std::vector<dav_off_t>({0, 1, 2}));
+    ASSERT_TRUE(entry->writeBlock(1, data.data() + kBlock, kBlock));
+    ASSERT_TRUE(entry->writeBlock(2, data.data() + 2 * kBlock, 10));
+    ASSERT_EQ(entry->missingBlocks(0, 2), std::vector<dav_off_t>({0}));
+
+    char buf[100];
+    ASSERT_FALSE(entry->read(buf, 100, kBlock - 50));
+    ASSERT_TRUE(entry->read(buf, 100, 2 * kBlock - 90));
+    ASSERT_EQ(memcmp(buf, data.data() + 2 * kBlock - 90, 100), 0);
+
+    // remembered for a while
+    std::shared_ptr<DiskCache::Entry> found;
+    ASSERT_TRUE(cache.lookup(url, std::chrono::seconds(60), found));
+    ASSERT_EQ(found, entry);
+  }
+
+  // another process, later on
+  DiskCache cache;
+  cache.configure(_dir, 0);
+
+  std::shared_ptr<DiskCache::Entry> found;
+  ASSERT_FALSE(cache.lookup(url, std::chrono::seconds(60), found));
+
+  std::shared_ptr<DiskCache::Entry> entry = cache.open(url, "v1", size);
+  ASSERT_EQ(entry->missingBlocks(0, 2), std::vector<dav_off_t>({0}));
+
+  // the file changed
+  entry = cache.open(url, "v2", size);
+  ASSERT_EQ(entry->missingBlocks(0, 2), std::vector<dav_off_t>({0, 1, 2}));
+}
+
+TEST_F(DiskCacheTest, StaleEntry) {
+  const std::string url = "http://example.org/file";
+  std::vector<char> data(kBlock, 'a');
+
+  DiskCache cache1, cache2;
+  cache1.configure(_dir, 0);
+  cache2.configure(_dir, 0);
+
+  std::shared_ptr<DiskCache::Entry> old = cache1.open(url, "v1", kBlock);
+  ASSERT_TRUE(old->writeBlock(0, data.data(), kBlock));
+
+  // someone else sees a newer version: the old entry can't be used anymore
+  std::shared_ptr<DiskCache::Entry> current = cache2.open(url, "v2", kBlock);
+  ASSERT_FALSE(old->read(data.data(), 10, 0));
+  ASSERT_FALSE(old->writeBlock(0, data.data(), kBlock));
+  ASSERT_EQ(current->missingBlocks(0, 0), std::vector<dav_off_t>({0}));
+}
+
+TEST_F(DiskCacheTest, Uncacheable) {
+  DiskCache cache;
+  cache.configure(_dir, 0);
+
+  ASSERT_FALSE(cache.open("http://example.org/file", "", 100));
+
+  std::shared_ptr<DiskCache::Entry> found;
+  ASSERT_TRUE(cache.lookup("http://example.org/file", std::chrono::seconds(60), found));
+  ASSERT_FALSE(found);
+}
+
+TEST_F(DiskCacheTest, InvalidateAndTrim) {
+  std::vector<char> data(kBlock, 'a');
+
+  DiskCache cache;
+  cache.configure(_dir, 3 * kBlock);
+
+  for(int i = 0; i < 5; i++) {
+    std::shared_ptr<DiskCache::Entry> entry = cache.open("http://example.org/" + std::to_string(i), "v", kBlock);
+    ASSERT_TRUE(entry->writeBlock(0, data.data(), kBlock));
+    cache.written(kBlock);
+  }
+
+  cache.trim();
+
+  int kept = 0;
+  for(int i = 0; i < 5; i++) {
+    std::string base = _dir + "/" + DiskCache::makeName("http://example.org/" + std::to_string(i));
+    kept += (access((base + ".data").c_str(), F_OK) == 0);
+  }
+
+  ASSERT_GE(kept, 1);
+  ASSERT_LE(kept, 2);
+
+  const std::string url = "http://example.org/4";
+  cache.open(url, "v", kBlock)->writeBlock(0, data.data(), kBlock);
+  cache.invalidate(url);
+  ASSERT_NE(access((_dir + "/" + DiskCache::makeName(url) + ".data").c_str(), F_OK), 0);
+}
+
+TEST_F(DiskCacheTest, TrimBetweenOpenAndRead) {
+  const std::string url = "http://example.org/file";
+  std::vector<char> data(kBlock, 'a');
+
+  DiskCache cache, other;
+  cache.configure(_dir, 0);
+  other.configure(_dir, kBlock / 2);
+
+  std::shared_ptr<DiskCache::Entry> entry = cache.open(url, "v1", kBlock);
+  ASSERT_TRUE(entry->writeBlock(0, data.data(), kBlock));
+
+  // another process trims the directory
+  other.trim();
+  ASSERT_NE(access((_dir + "/" + DiskCache::makeName(url) + ".index").c_str(), F_OK), 0);
+
+  // the entry notices, rather than using files nobody else can see
+  ASSERT_FALSE(entry->read(data.data(), 10, 0));
+  ASSERT_FALSE(entry->writeBlock(0, data.data(), kBlock));
+  ASSERT_EQ(entry->missingBlocks(0, 0), std::vector<dav_off_t>({0}));
+
+  std::shared_ptr<DiskCache::Entry> found;
+  ASSERT_FALSE(cache.lookup(url, std::chrono::seconds(60), found));
+
+  entry = cache.open(url, "v1", kBlock);
+  ASSERT_TRUE(entry->writeBlock(0, data.data(), kBlock));
+  ASSERT_TRUE(entry->read(data.data(), 10, 0));
+  ASSERT_EQ(access((_dir + "/" + DiskCache::makeName(url) + ".data").c_str(), F_OK), 0);
+}
+
+TEST_F(DiskCacheTest, TrimOrder) {
+  std::vector<char> data(kBlock, 'a');
+
+  DiskCache cache;
+  cache.configure(_dir, 0);
+
+  for(int i = 0; i < 4; i++) {
+    std::shared_ptr<DiskCache::Entry> entry = cache.open("http://example.org/" + std::to_string(i), "v", kBlock);
+    ASSERT_TRUE(entry->writeBlock(0, data.data(), kBlock));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  // opened again within the same second
+  cache.forget();
+  ASSERT_TRUE(cache.open("http://example.org/0", "v", kBlock));
+
+  cache.configure(_dir, 3 * kBlock);
+
+  std::vector<bool> kept;
+  for(int i = 0; i < 4; i++) {
+    std::string base = _dir + "/" + DiskCache::makeName("http://example.org/" + std::to_string(i));
+    kept.push_back(access((base + ".data").c_str(), F_OK) == 0);
+  }
+
+  ASSERT_TRUE(kept[0]);
+  ASSERT_FALSE(kept[1]);
+  ASSERT_FALSE(kept[2]);
+  ASSERT_TRUE(kept[3]);
+}
+
+TEST_F(DiskCacheTest, RememberedEntries) {
+  DiskCache cache;
+  cache.configure(_dir, 0);
+
+  for(int i = 0; i < 100; i++) {
+    ASSERT_TRUE(cache.open("http://example.org/" + std::to_string(i), "v", 100));
+    // keep using the first one
+    std::shared_ptr<DiskCache::Entry> found;
+    ASSERT_TRUE(cache.lookup("http://example.org/0", std::chrono::seconds(60), found));
+  }
+
+  std::shared_ptr<DiskCache::Entry> found;
+  ASSERT_TRUE(cache.lookup("http://example.org/99", std::chrono::seconds(60), found));
+  ASSERT_FALSE(cache.lookup("http://example.org/1", std::chrono::seconds(60), found));
+}
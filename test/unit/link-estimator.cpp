@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include <core/LinkEstimator.hpp>
+
+using namespace Davix;
+using std::chrono::microseconds;
+
+TEST(LinkEstimator, UnknownEndpoint) {
+  LinkEstimator estimator;
+  ASSERT_EQ(estimator.getMergeWindow("http://example.org:80", 1234), 1234u);
+
+  // latency alone is not enough
+  estimator.recordRequest("http://example.org:80", microseconds(10000), 100, microseconds(10));
+  ASSERT_EQ(estimator.getMergeWindow("http://example.org:80", 1234), 1234u);
+}
+
+TEST(LinkEstimator, BandwidthDelayProduct) {
+  LinkEstimator estimator;
+
+  // WAN: 20ms, 50 MB/s -> 1 MB
+  estimator.recordRequest("https://far.example.org:443", microseconds(20000), 5000000, microseconds(100000));
+  ASSERT_EQ(estimator.getMergeWindow("https://far.example.org:443", 2000), 1000000u);
+
+  // LAN: 50us, 10 MB/s -> clamped to the minimum
+  estimator.recordRequest("http://near.example.org:80", microseconds(50), 1000000, microseconds(100000));
+  ASSERT_EQ(estimator.getMergeWindow("http://near.example.org:80", 2000), (dav_size_t) DAVIX_MIN_MERGE_WINDOW);
+
+  // slow links are clamped to the maximum
+  estimator.recordRequest("http://huge.example.org:80", microseconds(1000000), 100000000, microseconds(1000000));
+  ASSERT_EQ(estimator.getMergeWindow("http://huge.example.org:80", 2000), (dav_size_t) DAVIX_MAX_MERGE_WINDOW);
+}
+
+TEST(LinkEstimator, MovingAverage) {
+  LinkEstimator estimator;
+
+  estimator.recordRequest("http://example.org:80", microseconds(1000), 1000000, microseconds(10000));
+  estimator.recordRequest("http://example.org:80", microseconds(5000), 1000000, microseconds(10000));
+
+  std::map<std::string, LinkStats> stats;
+  estimator.collectStats(stats);
+  ASSERT_EQ(stats.size(), 1u);
+  ASSERT_EQ(stats["http://example.org:80"].latency, 2000u);
+  ASSERT_EQ(stats["http://example.org:80"].bandwidth, 100000000u);
+  ASSERT_EQ(stats["http://example.org:80"].merge_window, 200000u);
+}
+
+TEST(LinkEstimator, VectorReads) {
+  LinkEstimator estimator;
+
+  estimator.recordVectorRead("http://example.org:80", 10, 4, 1000, 50);
+  estimator.recordVectorRead("http://example.org:80", 5, 5, 500, 0);
+
+  std::map<std::string, LinkStats> stats;
+  estimator.collectStats(stats);
+  ASSERT_EQ(stats["http://example.org:80"].vector_reads, 2u);
+  ASSERT_EQ(stats["http://example.org:80"].ranges_requested, 15u);
+  ASSERT_EQ(stats["http://example.org:80"].ranges_issued, 9u);
+  ASSERT_EQ(stats["http://example.org:80"].bytes_requested, 1500u);
+  ASSERT_EQ(stats["http://example.org:80"].bytes_wasted, 50u);
+  ASSERT_EQ(stats["http://example.org:80"].merge_window, (dav_size_t) DAVIX_DEFAULT_MERGE_WINDOW);
+}
+
+TEST(LinkEstimator, BoundedEndpoints) {
+  LinkEstimator estimator(2);
+
+  estimator.recordVectorRead("http://a:80", 1, 1, 1, 0);
+  estimator.recordVectorRead("http://b:80", 1, 1, 1, 0);
+  estimator.recordVectorRead("http://a:80", 1, 1, 1, 0);
+  estimator.recordVectorRead("http://c:80", 1, 1, 1, 0);
+
+  // only the least recently used endpoint is forgotten
+  std::map<std::string, LinkStats> stats;
+  estimator.collectStats(stats);
+  ASSERT_EQ(stats.size(), 2u);
+  ASSERT_EQ(stats["http://a:80"].vector_reads, 2u);
+  ASSERT_EQ(stats.count("http://b:80"), 0u);
+  ASSERT_EQ(stats.count("http://c:80"), 1u);
+}
@@ -167,3 +167,40 @@ TEST_P(Response_Buffer, SeparateFeedAndConsume) {
   ASSERT_EQ(contents.size(), consumed);
   ASSERT_EQ(contents, reconstructed);
 }
+
+TEST_P(Response_Buffer, GrowingPooledBlocks) {
+  std::string contents = "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Mauris porttitor urna in diam ultricies semper. Vivamus gravida purus eu erat condimentum, ullamcorper aliquam dui commodo. Fusce id nunc euismod mauris venenatis cursus non vel odio. Aliquam porttitor urna eget nibh cursus, eget ultricies quam sagittis. Donec pulvinar fermentum nunc, id rhoncus justo convallis sed. Donec suscipit quis lectus eget maximus. Etiam ut pharetra odio. Morbi ac nulla rhoncus, placerat quam varius, ultrices justo.";
+
+  ResponseBlockPool pool;
+
+  for(size_t round = 0; round < 3; round++) {
+    ResponseBuffer buffer(GetParam(), &pool, GetParam() * 8);
+
+    size_t fed = 0;
+    std::string reconstructed;
+
+    while(fed < contents.size()) {
+      size_t stride = std::min(contents.size() - fed, (size_t) (rand() % 50));
+      buffer.feed(contents.c_str()+fed, stride);
+      fed += stride;
+
+      std::string target;
+      target.resize(rand() % 20);
+      target.resize(buffer.consume( (char*) target.c_str(), target.size()));
+      reconstructed += target;
+    }
+
+    std::string target;
+    target.resize(contents.size());
+    target.resize(buffer.consume( (char*) target.c_str(), target.size()));
+    reconstructed += target;
+
+    ASSERT_EQ(reconstructed, contents);
+    ASSERT_EQ(buffer.size(), 0u);
+  }
+
+  // later rounds are served from blocks given back by earlier ones
+  ResponseBlockPool::Stats stats = pool.getStats();
+  ASSERT_GT(stats.allocated, 0u);
+  ASSERT_GT(stats.reused, 0u);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include <core/StatCache.hpp>
+#include <chrono>
+#include <thread>
+
+using namespace Davix;
+
+static StatInfo makeInfo(dav_size_t size) {
+  StatInfo info;
+  info.size = size;
+  info.mtime = 1000;
+  return info;
+}
+
+TEST(StatCache, Disabled) {
+  StatCache cache;
+  StatInfo info;
+
+  cache.insert(Uri("http://example.org/file"), makeInfo(10));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/file"), info), StatCache::Miss);
+  ASSERT_EQ(cache.size(), 0u);
+}
+
+TEST(StatCache, Keys) {
+  ASSERT_EQ(StatCache::makeKey(Uri("http://example.org/dir/")), "http://example.org/dir");
+  ASSERT_EQ(StatCache::makeKey(Uri("http://example.org/dir//")), "http://example.org/dir");
+  ASSERT_EQ(StatCache::makeKey(Uri("http://example.org/")), "http://example.org/");
+  ASSERT_EQ(StatCache::makeKey(Uri("http://example.org:8443/file?a=b#frag")), "http://example.org:8443/file?a=b");
+}
+
+TEST(StatCache, HitAndMiss) {
+  StatCache cache(60);
+  StatInfo info;
+
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/file"), info), StatCache::Miss);
+
+  cache.insert(Uri("http://example.org/file"), makeInfo(10));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/file"), info), StatCache::Found);
+  ASSERT_EQ(info.size, 10u);
+  ASSERT_EQ(info.mtime, 1000);
+
+  cache.insert(Uri("http://example.org/dir/"), makeInfo(0));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir"), info), StatCache::Found);
+
+  ASSERT_EQ(cache.hits(), 2u);
+  ASSERT_EQ(cache.misses(), 1u);
+
+  // without negative TTL, missing files are not remembered
+  cache.insertNotFound(Uri("http://example.org/missing"));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/missing"), info), StatCache::Miss);
+
+  cache.setTTL(0, 0);
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/file"), info), StatCache::Miss);
+  ASSERT_EQ(cache.size(), 0u);
+}
+
+TEST(StatCache, NegativeCaching) {
+  StatCache cache(60, 1);
+  StatInfo info;
+
+  cache.insertNotFound(Uri("http://example.org/missing"));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/missing"), info), StatCache::NotFound);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/missing"), info), StatCache::Miss);
+
+  // a file showing up replaces the negative entry
+  cache.insertNotFound(Uri("http://example.org/missing"));
+  cache.insert(Uri("http://example.org/missing"), makeInfo(5));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/missing"), info), StatCache::Found);
+}
+
+TEST(StatCache, Listing) {
+  StatCache cache(60);
+  StatInfo info;
+
+  cache.insertChild(Uri("http://example.org/dir/"), "file", makeInfo(10));
+  cache.insertChild(Uri("http://example.org/dir?a=b"), "with space", makeInfo(20));
+  cache.insertChild(Uri("http://example.org/dir"), "sub/file", makeInfo(30));
+  cache.insertChild(Uri("http://example.org/dir"), "..", makeInfo(0));
+  cache.insertChild(Uri("http://example.org/dir"), "", makeInfo(0));
+
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir/file"), info), StatCache::Found);
+  ASSERT_EQ(info.size, 10u);
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir/with%20space"), info), StatCache::Found);
+  ASSERT_EQ(info.size, 20u);
+  ASSERT_EQ(cache.size(), 2u);
+}
+
+TEST(StatCache, Invalidate) {
+  StatCache cache(60, 60);
+  StatInfo info;
+
+  cache.insert(Uri("http://example.org/"), makeInfo(0));
+  cache.insert(Uri("http://example.org/dir"), makeInfo(0));
+  cache.insert(Uri("http://example.org/dir/file"), makeInfo(10));
+  cache.insert(Uri("http://example.org/dir/other"), makeInfo(20));
+  cache.insertNotFound(Uri("http://example.org/dir/new"));
+
+  // the file and its parent go, siblings stay
+  cache.invalidate(Uri("http://example.org/dir/file"));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir/file"), info), StatCache::Miss);
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir"), info), StatCache::Miss);
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir/other"), info), StatCache::Found);
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/"), info), StatCache::Found);
+
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir/new"), info), StatCache::NotFound);
+  cache.invalidate(Uri("http://example.org/dir/new"));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir/new"), info), StatCache::Miss);
+
+  // directories, with or without trailing slash
+  cache.insert(Uri("http://example.org/dir"), makeInfo(0));
+  cache.invalidate(Uri("http://example.org/dir/"));
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/dir"), info), StatCache::Miss);
+  ASSERT_EQ(cache.lookup(Uri("http://example.org/"), info), StatCache::Miss);
+
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0u);
+}
@@ -7,6 +7,7 @@
 #include <utils/davix_swift_utils.hpp>
 #include <gtest/gtest.h>
 #include <core/SessionPool.hpp>
+#include <thread>
 #include <curl/HeaderlineParser.hpp>
 
 using namespace std;
@@ -228,6 +229,10 @@ TEST(SessionPool, BasicSanity) {
     pool.insert("test-2", 3);
     pool.insert("test-2", 5);
 
+    // most recently inserted first
+    ASSERT_TRUE(pool.retrieve("test-2", out));
+    ASSERT_EQ(out, 5);
+
     ASSERT_TRUE(pool.retrieve("test-2", out));
     ASSERT_EQ(out, 3);
 
@@ -236,9 +241,61 @@ TEST(SessionPool, BasicSanity) {
 
     ASSERT_TRUE(pool.retrieve("test-2", out));
     ASSERT_EQ(out, 3);
+}
 
-    ASSERT_TRUE(pool.retrieve("test-2", out));
-    ASSERT_EQ(out, 5);
+TEST(SessionPool, PerHostLimit) {
+    SessionPool<int> pool(2, 100);
+
+    pool.insert("httpexample.org:80", 1);
+    pool.insert("httpexample.org:80", 2);
+    pool.insert("httpexample.org:80", 3);
+    ASSERT_EQ(pool.size("httpexample.org:80"), 2u);
+
+    int item = 0;
+    ASSERT_TRUE(pool.retrieve("httpexample.org:80", item));
+    ASSERT_EQ(item, 3);
+    ASSERT_TRUE(pool.retrieve("httpexample.org:80", item));
+    ASSERT_EQ(item, 2);
+    ASSERT_FALSE(pool.retrieve("httpexample.org:80", item));
+}
+
+TEST(SessionPool, GlobalLimit) {
+    SessionPool<int> pool(10, 3);
+
+    for(int i = 0; i < 10; i++) {
+        pool.insert("httphost" + std::to_string(i) + ":80", i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_EQ(pool.size(), 3u);
+
+    // the most recently inserted sessions survive
+    int item = 0;
+    ASSERT_TRUE(pool.retrieve("httphost9:80", item));
+    ASSERT_EQ(item, 9);
+    ASSERT_FALSE(pool.retrieve("httphost0:80", item));
+}
+
+TEST(SessionPool, IdleExpiry) {
+    SessionPool<int> pool(10, 10, std::chrono::milliseconds(50));
+
+    pool.insert("httpexample.org:80", 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    pool.insert("httpexample.org:80", 2);
+
+    int item = 0;
+    ASSERT_TRUE(pool.retrieve("httpexample.org:80", item));
+    ASSERT_EQ(item, 2);
+    ASSERT_FALSE(pool.retrieve("httpexample.org:80", item));
+    ASSERT_EQ(pool.size(), 0u);
+}
+
+TEST(SessionPool, Disabled) {
+    SessionPool<int> pool(0, 10);
+    ASSERT_FALSE(pool.insert("httpexample.org:80", 1));
+
+    int item = 0;
+    ASSERT_FALSE(pool.retrieve("httpexample.org:80", item));
 }
 
 TEST(HeaderlineParser, BasicSanity) {
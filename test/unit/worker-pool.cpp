@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <davix.hpp>
+#include <core/WorkerPool.hpp>
+#include <davix_context_internal.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace Davix;
+
+TEST(WorkerPool, RunsAllTasks) {
+  std::atomic<int> counter(0);
+
+  {
+    WorkerPool pool(4);
+    ASSERT_EQ(pool.size(), 4u);
+
+    for(size_t i = 0; i < 100; i++) {
+      pool.submit([&counter]() { counter++; });
+    }
+  }
+
+  // destructor drains the queue
+  ASSERT_EQ(counter, 100);
+}
+
+TEST(WorkerPool, Future) {
+  WorkerPool pool(2);
+
+  std::future<int> ok = pool.async<int>([]() { return 42; });
+  ASSERT_EQ(ok.get(), 42);
+
+  std::future<int> failed = pool.async<int>([]() -> int {
+    throw DavixException(davix_scope_io_buff(), StatusCode::InvalidArgument, "nope");
+  });
+
+  try {
+    failed.get();
+    FAIL();
+  }
+  catch(DavixException &e) {
+    ASSERT_EQ(e.code(), StatusCode::InvalidArgument);
+  }
+}
+
+TEST(WorkerPool, Callback) {
+  WorkerPool pool(2);
+
+  std::promise<std::pair<dav_ssize_t, std::string> > res1, res2;
+
+  pool.async([]() -> dav_ssize_t { return 19; }, [&res1](dav_ssize_t r, DavixError* err) {
+    res1.set_value(std::make_pair(r, std::string(err ? err->getErrMsg() : "")));
+  });
+
+  pool.async([]() -> dav_ssize_t {
+    throw DavixException(davix_scope_io_buff(), StatusCode::OperationTimeout, "too slow");
+  }, [&res2](dav_ssize_t r, DavixError* err) {
+    res2.set_value(std::make_pair(r, std::string(err ? err->getErrMsg() : "")));
+  });
+
+  ASSERT_EQ(res1.get_future().get(), std::make_pair(dav_ssize_t(19), std::string()));
+  ASSERT_EQ(res2.get_future().get(), std::make_pair(dav_ssize_t(-1), std::string("too slow")));
+}
+
+TEST(WorkerPool, ParallelFor) {
+  WorkerPool pool(4);
+  std::vector<std::atomic<int> > hits(1000);
+
+  pool.parallelFor(hits.size(), 4, [&hits](size_t i) { hits[i]++; });
+
+  for(size_t i = 0; i < hits.size(); i++) {
+    ASSERT_EQ(hits[i], 1);
+  }
+
+  // from within a task of a saturated pool: the caller does all the work
+  WorkerPool single(1);
+  std::future<int> fut = single.async<int>([&single]() {
+    std::atomic<int> count(0);
+    single.parallelFor(100, 8, [&count](size_t i) { count++; });
+    return count.load();
+  });
+
+  ASSERT_EQ(fut.get(), 100);
+}
+
+TEST(WorkerPool, ParallelForException) {
+  WorkerPool pool(4);
+  std::atomic<int> count(0);
+
+  ASSERT_THROW(pool.parallelFor(1000, 4, [&count](size_t i) {
+    count++;
+    if(i == 10) {
+      throw DavixException(davix_scope_io_buff(), StatusCode::InvalidArgument, "nope");
+    }
+
+    // leave the failing index time to report, even on a single CPU
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }), DavixException);
+
+  // dispatch stops early
+  ASSERT_LT(count, 1000);
+}
+
+TEST(WorkerPool, ParallelForLimit) {
+  WorkerPool pool(2);
+  std::mutex mtx;
+  int inflight = 0, peak = 0;
+
+  pool.parallelFor(50, 10, [&](size_t i) {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      peak = std::max(peak, ++inflight);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::lock_guard<std::mutex> lock(mtx);
+    inflight--;
+  });
+
+  // two pool threads plus the caller
+  ASSERT_LE(peak, 3);
+
+  // no parallelism: the caller does everything
+  std::atomic<int> count(0);
+  pool.parallelFor(10, 0, [&count](size_t i) { count++; });
+  ASSERT_EQ(count, 10);
+}
+
+TEST(WorkerPool, ReadPartialAsyncFailure) {
+  Context context;
+  RequestParams params;
+  params.setOperationRetry(0);
+
+  DavFile file(context, params, Uri("http://localhost:1/nothing-listens-here"));
+
+  char buffer[16];
+  std::future<dav_ssize_t> fut = file.readPartialAsync(NULL, buffer, sizeof(buffer), 0);
+  ASSERT_THROW(fut.get(), DavixException);
+
+  std::promise<dav_ssize_t> res;
+  file.readPartialAsync(NULL, buffer, sizeof(buffer), 0, [&res](dav_ssize_t r, DavixError* err) {
+    res.set_value((err != NULL) ? r : 0);
+  });
+
+  ASSERT_EQ(res.get_future().get(), -1);
+}
+
+TEST(WorkerPool, ContextSize) {
+  Context context;
+  ASSERT_EQ(context.getWorkerThreads(), WorkerPool::defaultSize());
+
+  context.setWorkerThreads(3);
+  ASSERT_EQ(context.getWorkerThreads(), 3u);
+
+  Context copy(context);
+  ASSERT_EQ(copy.getWorkerThreads(), 3u);
+
+  context.setWorkerThreads(100000);
+  ASSERT_EQ(context.getWorkerThreads(), (size_t) DAVIX_MAX_WORKER_THREADS);
+
+  // fixed once the pool is started
+  context.setWorkerThreads(2);
+  ASSERT_EQ(ContextExplorer::WorkerPoolFromContext(context).size(), 2u);
+  context.setWorkerThreads(5);
+  ASSERT_EQ(context.getWorkerThreads(), 2u);
+}